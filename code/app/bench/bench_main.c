@@ -0,0 +1,450 @@
+/**
+ * @file bench_main.c
+ * @brief kernel micro benchmark, an application instead of app/main.c
+ * @note cycles are read by tos_cpu_cycle_get (DWT CYCCNT, or SysTick when no DWT such as QEMU),
+ *       results are sent to debug uart, one line for one item:
+ *           BENCH_BEGIN clock=<hz> overhead=<cycles>
+ *           BENCH <name> n=<samples> min=<> avg=<> max=<> p50=<> p90=<> p99=<>
+ *           BENCH_END
+ *       all values are cycles of MCU_SYS_CLOCK, the overhead of reading cycle counter is subtracted.
+ *       the host build (make bench) exits after BENCH_END, a target keeps running
+ */
+
+#include "bsp.h"
+
+#include "log_core.h"
+#include "tos_cond.h"
+#include "tos_core.h"
+#include "tos_cpu.h"
+#include "tos_mem.h"
+#include "tos_mutex.h"
+#include "tos_sem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#ifndef BENCH_EXIT_ENABLE
+#define BENCH_EXIT_ENABLE  0    // exit the process after BENCH_END, given by make on the host port
+#endif
+#define BENCH_SAMPLE_NUM   200u
+#define BENCH_WORKER_NUM   2u
+#define BENCH_SLEEPER_NUM  4u
+#define BENCH_CTRL_PRIO    3u
+#define BENCH_WORKER_PRIO  5u   // higher than ctrl task, runs as soon as woken
+#define BENCH_TICK_SAMPLES 50u
+
+
+typedef struct bench_worker_t {
+    tos_task_t* task_hdl;
+    tos_sem_t   start;
+    void        (*proc)(struct bench_worker_t* worker);
+} bench_worker_t;
+
+
+static tos_stack_t    bench_ctrl_stack[512];
+static tos_stack_t    bench_worker_stack[BENCH_WORKER_NUM][256];
+static tos_stack_t    bench_sleeper_stack[BENCH_SLEEPER_NUM][128];
+static uint32_t       bench_mem_space[256];
+static bench_worker_t bench_worker[BENCH_WORKER_NUM];
+static tos_sem_t      bench_done;
+static tos_mutex_t    bench_mutex;
+static tos_cond_t     bench_cond;
+static tos_sem_t      bench_sem;
+
+static uint32_t          bench_samples[BENCH_SAMPLE_NUM];
+static uint32_t          bench_sample_cnt;
+static uint32_t          bench_overhead;
+static volatile uint32_t bench_stamp;
+static bench_worker_t*   bench_stamp_owner;   // worker which sets bench_stamp in switch bench
+
+
+/**
+ * @brief
+ *
+ * @return uint32_t cycles
+ */
+static inline uint32_t bench_cycle(void) {
+    return tos_cpu_cycle_get();
+}
+
+
+static void bench_sample_add(uint32_t cycles) {
+    if (bench_sample_cnt < BENCH_SAMPLE_NUM) {
+        bench_samples[bench_sample_cnt++] = (cycles > bench_overhead) ? cycles - bench_overhead : 0;
+    }
+}
+
+
+/**
+ * @brief sort samples and print one result line
+ *
+ * @param name
+ */
+static void bench_report(const char* name) {
+    char     line[128];
+    uint32_t i, j, val;
+    uint64_t sum = 0;
+    uint32_t n   = bench_sample_cnt;
+
+    if (n == 0) {
+        snprintf(line, sizeof(line), "BENCH %s n=0\n", name);
+        uart_dbg_send_string(line);
+        return;
+    }
+
+    // insertion sort, samples are few
+    for (i = 1; i < n; i++) {
+        val = bench_samples[i];
+        for (j = i; j > 0 && bench_samples[j - 1] > val; j--) {
+            bench_samples[j] = bench_samples[j - 1];
+        }
+        bench_samples[j] = val;
+    }
+    for (i = 0; i < n; i++) {
+        sum += bench_samples[i];
+    }
+
+    snprintf(line, sizeof(line), "BENCH %s n=%u min=%u avg=%u max=%u p50=%u p90=%u p99=%u\n", name, (unsigned)n,
+             (unsigned)bench_samples[0], (unsigned)(sum / n), (unsigned)bench_samples[n - 1],
+             (unsigned)bench_samples[(n - 1) * 50 / 100], (unsigned)bench_samples[(n - 1) * 90 / 100],
+             (unsigned)bench_samples[(n - 1) * 99 / 100]);
+    uart_dbg_send_string(line);
+
+    bench_sample_cnt = 0;
+}
+
+
+/**
+ * @brief worker task, run the proc when started by ctrl task
+ *
+ * @param arg bench_worker_t
+ */
+static void bench_worker_task(void* arg) {
+    bench_worker_t* worker = (bench_worker_t*)arg;
+
+    while (true) {
+        tos_sem_take(&worker->start, TOS_SEM_WAIT_INFINITE);
+        worker->proc(worker);
+        tos_sem_give(&bench_done);
+    }
+}
+
+
+/**
+ * @brief start workers with procs, wait until all done
+ *
+ * @param proc0
+ * @param proc1 nullptr if only one worker is used
+ */
+static void bench_workers_run(void (*proc0)(bench_worker_t*), void (*proc1)(bench_worker_t*)) {
+    uint32_t num = (proc1 != nullptr) ? 2 : 1;
+    uint32_t i;
+
+    bench_worker[0].proc = proc0;
+    bench_worker[1].proc = proc1;
+    tos_schedule_disable();   // all workers are ready before the first one runs
+    for (i = 0; i < num; i++) {
+        tos_sem_give(&bench_worker[i].start);
+    }
+    tos_schedule_enable();
+    for (i = 0; i < num; i++) {
+        tos_sem_take(&bench_done, TOS_SEM_WAIT_INFINITE);
+    }
+}
+
+
+static void bench_sleeper_task(void* arg) {
+    while (true) {
+        tos_task_sleep(1000000u);
+    }
+}
+
+
+/**
+ * @brief two workers with the same prio yield to each other, sample from yield to the other task running
+ *
+ * @param worker
+ */
+static void bench_switch_proc(bench_worker_t* worker) {
+    uint32_t i;
+
+    for (i = 0; i < BENCH_SAMPLE_NUM / 2 + 1; i++) {
+        bench_stamp_owner = worker;
+        bench_stamp       = bench_cycle();
+        tos_task_yield();
+        if (bench_stamp_owner != worker) {   // switched from the other worker
+            bench_sample_add(bench_cycle() - bench_stamp);
+        }
+    }
+}
+
+
+/**
+ * @brief wait on mutex held by ctrl task, sample from unlock to the waiter running
+ *
+ * @param worker
+ */
+static void bench_mutex_proc(bench_worker_t* worker) {
+    tos_mutex_lock(&bench_mutex);
+    bench_sample_add(bench_cycle() - bench_stamp);
+    tos_mutex_unlock(&bench_mutex);
+}
+
+
+/**
+ * @brief wait on cond, sample from signal to the waiter running
+ *
+ * @param worker
+ */
+static void bench_cond_proc(bench_worker_t* worker) {
+    uint32_t i;
+
+    tos_mutex_lock(&bench_mutex);
+    for (i = 0; i < BENCH_SAMPLE_NUM; i++) {
+        tos_cond_wait(&bench_cond, &bench_mutex);
+        bench_sample_add(bench_cycle() - bench_stamp);
+    }
+    tos_mutex_unlock(&bench_mutex);
+}
+
+
+/**
+ * @brief wait on sem, sample from give to the waiter running
+ *
+ * @param worker
+ */
+static void bench_sem_proc(bench_worker_t* worker) {
+    uint32_t i;
+
+    for (i = 0; i < BENCH_SAMPLE_NUM; i++) {
+        tos_sem_take(&bench_sem, TOS_SEM_WAIT_INFINITE);
+        bench_sample_add(bench_cycle() - bench_stamp);
+    }
+}
+
+
+/**
+ * @brief busy loop reading cycle counter, a gap much longer than one loop is the tick ISR
+ *
+ */
+static void bench_tick_isr(void) {
+    uint32_t last, now, loop_max, start_ticks;
+    uint32_t i;
+
+    // the longest loop without irq
+    loop_max = 0;
+    last     = bench_cycle();
+    for (i = 0; i < 1000; i++) {
+        now = bench_cycle();
+        if (now - last > loop_max && i > 0) {
+            loop_max = now - last;
+        }
+        last = now;
+    }
+    loop_max = (loop_max < bench_overhead * 4) ? loop_max * 4 : loop_max * 2;
+
+    tos_task_sleep(TOS_TICK_MS);   // start at the beginning of a tick
+    start_ticks = tos_get_sys_ticks();
+    last        = bench_cycle();
+    while (bench_sample_cnt < BENCH_TICK_SAMPLES && tos_get_sys_ticks() - start_ticks < BENCH_TICK_SAMPLES * 4) {
+        now = bench_cycle();
+        if (now - last > loop_max) {
+            bench_sample_add(now - last);
+        }
+        last = now;
+    }
+}
+
+
+static void bench_ctrl_task(void* arg) {
+    char     line[64];
+    uint32_t i, t0, t1;
+    void*    mem;
+
+    tos_cpu_cycle_init();
+    tos_task_sleep(10);
+
+    // overhead of reading cycle counter
+    bench_overhead = 0xFFFFFFFFu;
+    for (i = 0; i < 100; i++) {
+        t0 = bench_cycle();
+        t1 = bench_cycle();
+        if (t1 - t0 < bench_overhead) {
+            bench_overhead = t1 - t0;
+        }
+    }
+
+    snprintf(line, sizeof(line), "BENCH_BEGIN clock=%u overhead=%u\n", (unsigned)MCU_SYS_CLOCK,
+             (unsigned)bench_overhead);
+    uart_dbg_send_string(line);
+
+    // 1 task switch by yield
+    bench_workers_run(bench_switch_proc, bench_switch_proc);
+    bench_report("task_switch_yield");
+
+    // 2 yield without other task of the same prio
+    for (i = 0; i < BENCH_SAMPLE_NUM; i++) {
+        t0 = bench_cycle();
+        tos_task_yield();
+        bench_sample_add(bench_cycle() - t0);
+    }
+    bench_report("task_yield_noswitch");
+
+    // 3 mutex without contention
+    for (i = 0; i < BENCH_SAMPLE_NUM; i++) {
+        t0 = bench_cycle();
+        tos_mutex_lock(&bench_mutex);
+        t1 = bench_cycle();
+        tos_mutex_unlock(&bench_mutex);
+        bench_sample_add(t1 - t0);
+    }
+    bench_report("mutex_lock");
+    for (i = 0; i < BENCH_SAMPLE_NUM; i++) {
+        tos_mutex_lock(&bench_mutex);
+        t0 = bench_cycle();
+        tos_mutex_unlock(&bench_mutex);
+        bench_sample_add(bench_cycle() - t0);
+    }
+    bench_report("mutex_unlock");
+
+    // 4 mutex with contention, unlock hands over to the higher prio waiter
+    for (i = 0; i < BENCH_SAMPLE_NUM; i++) {
+        tos_mutex_lock(&bench_mutex);
+        bench_worker[0].proc = bench_mutex_proc;
+        tos_sem_give(&bench_worker[0].start);   // worker preempts and blocks on mutex
+        bench_stamp = bench_cycle();
+        tos_mutex_unlock(&bench_mutex);
+        tos_sem_take(&bench_done, TOS_SEM_WAIT_INFINITE);
+    }
+    bench_report("mutex_unlock_wake");
+
+    // 5 cond signal to the waiter running
+    bench_worker[0].proc = bench_cond_proc;
+    tos_sem_give(&bench_worker[0].start);
+    for (i = 0; i < BENCH_SAMPLE_NUM; i++) {
+        bench_stamp = bench_cycle();
+        tos_cond_signal(&bench_cond);
+    }
+    tos_sem_take(&bench_done, TOS_SEM_WAIT_INFINITE);
+    bench_report("cond_signal_wake");
+
+    // 6 sem give to the waiter running
+    bench_worker[0].proc = bench_sem_proc;
+    tos_sem_give(&bench_worker[0].start);
+    for (i = 0; i < BENCH_SAMPLE_NUM; i++) {
+        bench_stamp = bench_cycle();
+        tos_sem_give(&bench_sem);
+    }
+    tos_sem_take(&bench_done, TOS_SEM_WAIT_INFINITE);
+    bench_report("sem_give_wake");
+
+    // 7 memory
+    for (i = 0; i < BENCH_SAMPLE_NUM; i++) {
+        t0  = bench_cycle();
+        mem = tos_mem_alloc(32);
+        t1  = bench_cycle();
+        tos_mem_dealloc(mem, 32);
+        bench_sample_add(t1 - t0);
+    }
+    bench_report("mem_alloc_32");
+    for (i = 0; i < BENCH_SAMPLE_NUM; i++) {
+        mem = tos_mem_alloc(32);
+        t0  = bench_cycle();
+        tos_mem_dealloc(mem, 32);
+        bench_sample_add(bench_cycle() - t0);
+    }
+    bench_report("mem_dealloc_32");
+    for (i = 0; i < BENCH_SAMPLE_NUM; i++) {
+        t0  = bench_cycle();
+        mem = tos_malloc(60);
+        tos_free(mem);
+        bench_sample_add(bench_cycle() - t0);
+    }
+    bench_report("malloc_free_60");
+    for (i = 0; i < BENCH_SAMPLE_NUM; i++) {
+        t0  = bench_cycle();
+        mem = tos_malloc(300);   // TLSF
+        tos_free(mem);
+        bench_sample_add(bench_cycle() - t0);
+    }
+    bench_report("malloc_free_300");
+
+    // 8 tick ISR with sleeping tasks
+    for (i = 0; i <= BENCH_SLEEPER_NUM; i++) {
+        if (i > 0) {
+            tos_task_attr_t task = {0};
+
+            task.task_stack      = bench_sleeper_stack[i - 1];
+            task.task_stack_size = sizeof(bench_sleeper_stack[i - 1]);
+            task.task_prio       = BENCH_CTRL_PRIO - 1;
+            task.task_name       = "bench_sleeper";
+            tos_task_create(bench_sleeper_task, nullptr, &task);
+        }
+        bench_tick_isr();
+        snprintf(line, sizeof(line), "tick_isr_sleep%u", (unsigned)i);
+        bench_report(line);
+    }
+
+    uart_dbg_send_string("BENCH_END\n");
+
+#if BENCH_EXIT_ENABLE
+    exit(0);
+#else
+    while (true) {
+        tos_task_sleep(1000);
+    }
+#endif
+}
+
+
+static void bench_init(void) {
+    tos_task_attr_t task = {0};
+    tos_sem_attr_t  sem  = {0, 0};
+    uint32_t        i;
+
+    tos_mutex_module_init();
+    tos_cond_module_init();
+    tos_sem_module_init();
+    tos_mem_module_init((uintptr_t)bench_mem_space, sizeof(bench_mem_space));
+
+    tos_mutex_init(&bench_mutex, nullptr);
+    tos_cond_init(&bench_cond, nullptr);
+    tos_sem_init(&bench_sem, &sem);
+    tos_sem_init(&bench_done, &sem);
+
+    for (i = 0; i < BENCH_WORKER_NUM; i++) {
+        tos_sem_init(&bench_worker[i].start, &sem);
+
+        task.task_stack      = bench_worker_stack[i];
+        task.task_stack_size = sizeof(bench_worker_stack[i]);
+        task.task_prio       = BENCH_WORKER_PRIO;
+        task.task_time_slice = 0xFFFFFFFFu;   // switch only by yield
+        task.task_name       = "bench_worker";
+        bench_worker[i].task_hdl = tos_task_create(bench_worker_task, &bench_worker[i], &task);
+    }
+
+    task.task_stack      = bench_ctrl_stack;
+    task.task_stack_size = sizeof(bench_ctrl_stack);
+    task.task_prio       = BENCH_CTRL_PRIO;
+    task.task_time_slice = 0;
+    task.task_name       = "bench_ctrl";
+    tos_task_create(bench_ctrl_task, nullptr, &task);
+}
+
+
+int main() {
+    sysclk_init();
+    sysirq_init();
+    uart_dbg_init(115200);
+
+    tos_init();
+    bench_init();
+    tos_start();
+}
+
+
+int main_cmd(int argc, char* argv[]) {
+    return 0;
+}
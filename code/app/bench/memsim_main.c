@@ -0,0 +1,749 @@
+/**
+ * @file memsim_main.c
+ * @brief host allocator benchmark and fragmentation simulator of tos_mem, built by make memsim
+ * @note tos_mem.c and tos_tlsf.c are linked alone, with the cpu functions below instead of a port, on a static
+ *       array as the RAM of a device. a trace of ops is generated (or read from a file) once, then replayed on
+ *       every allocator front end in memsim_frontend:
+ *           tos_mem     tos_mem_alloc / tos_mem_dealloc
+ *           tos_malloc  tos_malloc / tos_free
+ *           tlsf        all sizes from one tos_tlsf pool, no small block lists
+ *       add an entry to compare another allocator. small block settings of tos_config.h are given by
+ *       make memsim MEMSIM_DEFS="-DTOS_MEM_BLOCK_MAX=64u -DTOS_MEM_CHUNK_BLKS=8u"
+ *
+ *       trace file, one op in a line, id is any number such as the address printed by the device. other lines
+ *       are ignored, so a log captured from the debug uart is read as it is:
+ *           a <id> <size>
+ *           f <id>
+ *
+ *       results, one line for each front end, samples and failures when -v:
+ *           MEMSIM <frontend> ops=<> fail=<> mops=<> alloc_avg=<> alloc_p99=<> alloc_max=<> free_avg=<> ...
+ *           SAMPLE <frontend> op=<> live=<> used=<> cached=<> free=<> largest=<> extents=<> frag=<%>
+ *           FAIL <frontend> op=<> size=<> live=<> used=<> free=<> largest=<>
+ *       time is host ns, the overhead of reading clock is subtracted. used is bytes of RAM not in the free area,
+ *       cached is free bytes in small block lists, frag is 1 - largest / free of the free area. live and used
+ *       are peaks in the result line, used is checked when live gets a new peak and every sample.
+ *       leak is used after all objects are freed and compacted, minus used after init.
+ *       tos_mem never compacts in alloc, the failed alloc is counted, then the front end is drained out of the
+ *       timing like the idle task does before the next op
+ */
+
+#include "tos_core_.h"
+#include "tos_cpu.h"
+#include "tos_mem.h"
+#include "tos_tlsf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+#define MEMSIM_RAM_MAX     (1u << TOS_MEM_TLSF_FL_MAX)
+#define MEMSIM_FAIL_SHOW   8u      // failures printed by -v
+#define MEMSIM_ID_BUCKETS  4096u   // hash of trace file ids, power of 2
+#define MEMSIM_ID_HASH(id) (((id) ^ ((id) >> 12)) & (MEMSIM_ID_BUCKETS - 1))
+#define MEMSIM_OP_ALLOC    0u
+#define MEMSIM_OP_FREE     1u
+#define MEMSIM_LINE_SIZE   256u
+
+
+typedef struct {
+    uint32_t type;   // MEMSIM_OP_ALLOC or MEMSIM_OP_FREE
+    uint32_t slot;   // object, a slot is reused after free
+    uint32_t size;   // bytes to alloc, 0 for free
+} memsim_op_t;
+
+typedef struct {
+    memsim_op_t* ops;
+    uint32_t     num;
+    uint32_t     cap;
+    uint32_t     slot_num;   // max objects alive at the same time
+    uint32_t     ignored;    // lines of trace file not replayed, free of unknown id or alloc of live id
+} memsim_trace_t;
+
+typedef struct {
+    void*    ptr;
+    uint32_t size;
+} memsim_obj_t;
+
+typedef struct {
+    tos_size_t used;      // bytes of RAM not in the free area
+    tos_size_t cached;    // free bytes in small block lists
+    tos_size_t free;      // bytes in the free area
+    tos_size_t largest;   // largest free extent
+    uint32_t   extents;   // free extents
+} memsim_heap_t;
+
+typedef struct {
+    const char* name;
+    int         (*init)(uint8_t* ram, tos_size_t size);
+    void*       (*alloc)(tos_size_t size);
+    void        (*free)(void* ptr, tos_size_t size);
+    void        (*heap)(memsim_heap_t* heap);
+    void        (*drain)(void);   // give cached blocks back after a failure and before the leak check, nullptr if none
+} memsim_frontend_t;
+
+typedef struct {
+    const char* name;
+    uint32_t    (*size)(void);
+} memsim_dist_t;
+
+
+static uint8_t        memsim_ram[MEMSIM_RAM_MAX] __attribute__((aligned(8)));
+static tos_size_t     memsim_ram_size = 16384u;
+static tos_tlsf_t     memsim_tlsf;
+static uint32_t       memsim_rand_state;
+static uint32_t       memsim_uniform_min, memsim_uniform_max;
+static uint32_t       memsim_overhead;
+static uint32_t       memsim_interval;
+static bool           memsim_verbose;
+static memsim_obj_t*  memsim_obj;
+static uint32_t*      memsim_alloc_ns;
+static uint32_t*      memsim_free_ns;
+static uint64_t*      memsim_id_key;    // trace file id of each slot
+static int32_t*       memsim_id_next;   // hash chain, or free slot list
+static int32_t        memsim_id_bucket[MEMSIM_ID_BUCKETS];
+static int32_t        memsim_id_free = -1;
+
+
+/**
+ * cpu functions used by tos_mem and tos_tlsf, replay is single threaded so no irq to mask
+ */
+uint32_t tos_irq_diable(void) {
+    return 0;
+}
+
+void tos_irq_restore(uint32_t primask) {
+    (void)primask;
+}
+
+uint32_t tos_irq_mask(uint32_t prio) {
+    (void)prio;
+    return 0;
+}
+
+void tos_irq_unmask(uint32_t mask) {
+    (void)mask;
+}
+
+uint32_t tos_cpu_clz(uint32_t val) {
+    return (val == 0) ? 32u : (uint32_t)__builtin_clz(val);
+}
+
+bool tos_cpu_cas(volatile uint32_t* ptr, uint32_t expected, uint32_t desired) {
+    return __sync_bool_compare_and_swap(ptr, expected, desired);
+}
+
+tos_run_state_t tos_state;   // intr_level 0, tos_mem_compact is called in task context
+
+
+static inline uint64_t memsim_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+
+/**
+ * @brief xorshift, the same trace for the same seed
+ *
+ * @return uint32_t
+ */
+static uint32_t memsim_rand(void) {
+    uint32_t x = memsim_rand_state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    memsim_rand_state = x;
+    return x;
+}
+
+static uint32_t memsim_rand_range(uint32_t min, uint32_t max) {
+    return min + memsim_rand() % (max - min + 1);
+}
+
+
+/**
+ * front ends
+ */
+static int memsim_tos_mem_init(uint8_t* ram, tos_size_t size) {
+    return tos_mem_module_init((uintptr_t)ram, size);
+}
+
+static void memsim_tos_malloc_free(void* ptr, tos_size_t size) {
+    (void)size;
+    tos_free(ptr);
+}
+
+static void memsim_tos_mem_heap(memsim_heap_t* heap) {
+    tos_mem_stat_t stat;
+    uint32_t       i;
+
+    tos_mem_stat_get(&stat);
+    heap->used    = memsim_ram_size - stat.free_area_bytes;
+    heap->cached  = 0;
+    heap->free    = stat.free_area_bytes;
+    heap->largest = stat.largest_free;
+    heap->extents = stat.free_extent_num;
+    for (i = 0; i < TOS_MEM_CLASS_NUM; i++) {
+        heap->cached += stat.class_free_bytes[i];
+    }
+}
+
+static void memsim_tos_mem_drain(void) {
+    tos_mem_compact();
+}
+
+static int memsim_tlsf_init(uint8_t* ram, tos_size_t size) {
+    return tos_tlsf_init(&memsim_tlsf, (uintptr_t)ram, size);
+}
+
+static void* memsim_tlsf_alloc(tos_size_t size) {
+    return tos_tlsf_alloc(&memsim_tlsf, size);
+}
+
+static void memsim_tlsf_free(void* ptr, tos_size_t size) {
+    (void)size;
+    tos_tlsf_free(&memsim_tlsf, ptr);
+}
+
+static void memsim_tlsf_heap(memsim_heap_t* heap) {
+    void*      blk;
+    tos_size_t size;
+
+    memset(heap, 0, sizeof(*heap));
+    for (blk = tos_tlsf_block_next(&memsim_tlsf, nullptr); blk != nullptr; blk = tos_tlsf_block_next(&memsim_tlsf, blk)) {
+        if (tos_tlsf_block_is_free(blk)) {
+            size = tos_tlsf_block_size(blk);
+            heap->free += size;
+            heap->extents++;
+            if (size > heap->largest) {
+                heap->largest = size;
+            }
+        }
+    }
+    heap->used = memsim_ram_size - heap->free;
+}
+
+static const memsim_frontend_t memsim_frontend[] = {
+    {"tos_mem", memsim_tos_mem_init, tos_mem_alloc, tos_mem_dealloc, memsim_tos_mem_heap, memsim_tos_mem_drain},
+    {"tos_malloc", memsim_tos_mem_init, tos_malloc, memsim_tos_malloc_free, memsim_tos_mem_heap, memsim_tos_mem_drain},
+    {"tlsf", memsim_tlsf_init, memsim_tlsf_alloc, memsim_tlsf_free, memsim_tlsf_heap, nullptr},
+};
+
+
+/**
+ * size distributions of synthetic traces
+ */
+static uint32_t memsim_dist_small(void) {
+    uint32_t r = memsim_rand() % 100u;
+
+    return (r < 60u) ? memsim_rand_range(4u, 32u) : memsim_rand_range(33u, 128u);
+}
+
+static uint32_t memsim_dist_mixed(void) {
+    uint32_t r = memsim_rand() % 100u;
+
+    if (r < 80u) {
+        return memsim_dist_small();
+    }
+    return (r < 95u) ? memsim_rand_range(129u, 512u) : memsim_rand_range(513u, 2048u);
+}
+
+static uint32_t memsim_dist_large(void) {
+    return memsim_rand_range(129u, 2048u);
+}
+
+static uint32_t memsim_dist_uniform(void) {
+    return memsim_rand_range(memsim_uniform_min, memsim_uniform_max);
+}
+
+static const memsim_dist_t memsim_dist[] = {
+    {"small", memsim_dist_small},   // 60% 4~32 bytes, 40% 33~128 bytes
+    {"mixed", memsim_dist_mixed},   // 80% small, 15% 129~512 bytes, 5% 513~2048 bytes
+    {"large", memsim_dist_large},   // 129~2048 bytes
+    {"uniform", memsim_dist_uniform},   // uniform:<min>:<max>
+};
+
+
+static void memsim_trace_add(memsim_trace_t* trace, uint32_t type, uint32_t slot, uint32_t size) {
+    if (trace->num == trace->cap) {
+        trace->cap = (trace->cap == 0) ? 4096u : trace->cap * 2u;
+        trace->ops = realloc(trace->ops, trace->cap * sizeof(memsim_op_t));
+        if (trace->ops == nullptr) {
+            fprintf(stderr, "memsim: out of host memory\n");
+            exit(1);
+        }
+    }
+    trace->ops[trace->num].type = type;
+    trace->ops[trace->num].slot = slot;
+    trace->ops[trace->num].size = size;
+    trace->num++;
+    if (slot >= trace->slot_num) {
+        trace->slot_num = slot + 1;
+    }
+}
+
+
+/**
+ * @brief generate a synthetic trace
+ *
+ * @param trace
+ * @param pattern steady: live objects wander around half of live_max, each op frees a random one or allocs
+ *                burst:  alloc up to live_max, then free 3/4 of them at random, again and again
+ *                pinned: like steady, but 1 of 8 objects is never freed until the end
+ * @param size
+ * @param op_num
+ * @param live_max
+ * @return int 0 when succeed, -1 when pattern is unknown
+ * @note all live objects are freed at the end, in addition to op_num ops
+ */
+static int memsim_trace_gen(memsim_trace_t* trace, const char* pattern, uint32_t (*size)(void), uint32_t op_num,
+                            uint32_t live_max) {
+    uint32_t* live;   // slots of live objects, pinned ones in front
+    uint32_t* idle;   // slots not used
+    uint32_t  live_num = 0, idle_num = 0, pinned = 0, i, pick, slot;
+    bool      alloc, freeing = false;
+
+    if (strcmp(pattern, "steady") != 0 && strcmp(pattern, "burst") != 0 && strcmp(pattern, "pinned") != 0) {
+        return -1;
+    }
+    live = malloc(live_max * sizeof(uint32_t));
+    idle = malloc(live_max * sizeof(uint32_t));
+    if (live == nullptr || idle == nullptr) {
+        free(live);
+        free(idle);
+        return -1;
+    }
+    for (i = live_max; i > 0; i--) {
+        idle[idle_num++] = i - 1;
+    }
+
+    for (i = 0; i < op_num; i++) {
+        if (strcmp(pattern, "burst") == 0) {
+            if (live_num == live_max) {
+                freeing = true;
+            } else if (live_num <= live_max / 4u) {
+                freeing = false;
+            }
+            alloc = !freeing;
+        } else {
+            alloc = (live_num == pinned) || (memsim_rand() % live_max >= live_num);
+        }
+
+        if (alloc) {
+            if (live_num == live_max) {
+                break;   // all pinned
+            }
+            slot             = idle[--idle_num];
+            live[live_num++] = slot;
+            memsim_trace_add(trace, MEMSIM_OP_ALLOC, slot, size());
+            if (strcmp(pattern, "pinned") == 0 && memsim_rand() % 8u == 0) {
+                live[live_num - 1] = live[pinned];
+                live[pinned++]     = slot;
+            }
+        } else {
+            pick             = pinned + memsim_rand() % (live_num - pinned);
+            slot             = live[pick];
+            live[pick]       = live[--live_num];
+            idle[idle_num++] = slot;
+            memsim_trace_add(trace, MEMSIM_OP_FREE, slot, 0);
+        }
+    }
+    while (live_num > 0) {
+        memsim_trace_add(trace, MEMSIM_OP_FREE, live[--live_num], 0);
+    }
+
+    free(live);
+    free(idle);
+    return 0;
+}
+
+
+/**
+ * @brief find the slot of a live id in trace file
+ *
+ * @param id
+ * @param unlink remove it from hash when found
+ * @return int32_t slot, -1 when not found
+ */
+static int32_t memsim_id_find(uint64_t id, bool unlink) {
+    int32_t* link = &memsim_id_bucket[MEMSIM_ID_HASH(id)];
+    int32_t  slot;
+
+    for (slot = *link; slot >= 0; link = &memsim_id_next[slot], slot = *link) {
+        if (memsim_id_key[slot] == id) {
+            if (unlink) {
+                *link = memsim_id_next[slot];
+            }
+            return slot;
+        }
+    }
+    return -1;
+}
+
+
+/**
+ * @brief read a trace file, ids are mapped to slots, a slot is reused after the id is freed
+ *
+ * @param trace
+ * @param path
+ * @return int 0 when succeed, -1 when fail
+ * @note live objects are freed at the end, like synthetic traces
+ */
+static int memsim_trace_load(memsim_trace_t* trace, const char* path) {
+    FILE*    file = fopen(path, "r");
+    char     line[MEMSIM_LINE_SIZE];
+    char*    arg;
+    char*    end;
+    uint64_t id;
+    uint32_t size, i;
+    int32_t  slot, slot_cap = 0, old_cap;
+
+    if (file == nullptr) {
+        return -1;
+    }
+    for (i = 0; i < MEMSIM_ID_BUCKETS; i++) {
+        memsim_id_bucket[i] = -1;
+    }
+
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        arg = line + strspn(line, " \t");
+        if ((arg[0] != 'a' && arg[0] != 'f') || (arg[1] != ' ' && arg[1] != '\t')) {
+            continue;
+        }
+        id = strtoull(arg + 2, &end, 0);
+        if (end == arg + 2) {
+            continue;
+        }
+
+        if (arg[0] == 'f') {
+            slot = memsim_id_find(id, true);
+            if (slot < 0) {
+                trace->ignored++;
+                continue;
+            }
+            memsim_id_next[slot] = memsim_id_free;
+            memsim_id_free       = slot;
+            memsim_trace_add(trace, MEMSIM_OP_FREE, (uint32_t)slot, 0);
+            continue;
+        }
+
+        size = (uint32_t)strtoul(end, &arg, 0);
+        if (arg == end || size == 0 || memsim_id_find(id, false) >= 0) {
+            trace->ignored++;
+            continue;
+        }
+        if (memsim_id_free < 0) {
+            // no idle slot, add more
+            old_cap        = slot_cap;
+            slot_cap       = (slot_cap == 0) ? 256 : slot_cap * 2;
+            memsim_id_key  = realloc(memsim_id_key, (size_t)slot_cap * sizeof(uint64_t));
+            memsim_id_next = realloc(memsim_id_next, (size_t)slot_cap * sizeof(int32_t));
+            if (memsim_id_key == nullptr || memsim_id_next == nullptr) {
+                fclose(file);
+                return -1;
+            }
+            for (slot = slot_cap - 1; slot >= old_cap; slot--) {
+                memsim_id_next[slot] = memsim_id_free;
+                memsim_id_free       = slot;
+            }
+        }
+        slot                 = memsim_id_free;
+        memsim_id_free       = memsim_id_next[slot];
+        memsim_id_key[slot]  = id;
+        memsim_id_next[slot] = memsim_id_bucket[MEMSIM_ID_HASH(id)];
+        memsim_id_bucket[MEMSIM_ID_HASH(id)] = slot;
+        memsim_trace_add(trace, MEMSIM_OP_ALLOC, (uint32_t)slot, size);
+    }
+    fclose(file);
+
+    // free the rest
+    for (i = 0; i < MEMSIM_ID_BUCKETS; i++) {
+        for (slot = memsim_id_bucket[i]; slot >= 0; slot = memsim_id_next[slot]) {
+            memsim_trace_add(trace, MEMSIM_OP_FREE, (uint32_t)slot, 0);
+        }
+    }
+    return 0;
+}
+
+
+static int memsim_cmp_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+
+/**
+ * @brief sort times and get avg, p99 and max
+ *
+ * @param ns
+ * @param n
+ * @param sum out: total ns
+ * @param line
+ * @param prefix
+ */
+static void memsim_time_report(uint32_t* ns, uint32_t n, uint64_t* sum, char* line, const char* prefix) {
+    uint32_t i;
+
+    *sum = 0;
+    if (n == 0) {
+        sprintf(line, " %s_avg=0 %s_p99=0 %s_max=0", prefix, prefix, prefix);
+        return;
+    }
+    qsort(ns, n, sizeof(uint32_t), memsim_cmp_u32);
+    for (i = 0; i < n; i++) {
+        *sum += ns[i];
+    }
+    sprintf(line, " %s_avg=%u %s_p99=%u %s_max=%u", prefix, (unsigned)(*sum / n), prefix,
+            (unsigned)ns[(uint64_t)n * 99u / 100u], prefix, (unsigned)ns[n - 1]);
+}
+
+
+static inline uint8_t memsim_fill(uint32_t slot) {
+    return (uint8_t)(slot * 7u + 1u);
+}
+
+
+/**
+ * @brief replay a trace on a front end and print the result
+ *
+ * @param frontend
+ * @param trace
+ * @return int 0 when succeed, -1 when front end fails to init
+ */
+static int memsim_run(const memsim_frontend_t* frontend, const memsim_trace_t* trace) {
+    memsim_heap_t heap;
+    memsim_op_t*  op;
+    uint64_t      start, cost, alloc_sum, free_sum;
+    uint64_t      live = 0, live_peak = 0;
+    tos_size_t    used_init, used_peak = 0;
+    uint32_t      frag, frag_max = 0, fail = 0, corrupt = 0, first_fail = 0;
+    uint32_t      alloc_num = 0, free_num = 0, i;
+    char          alloc_line[96], free_line[96];
+    void*         ptr;
+
+    memset(memsim_ram, 0, memsim_ram_size);
+    memset(memsim_obj, 0, trace->slot_num * sizeof(memsim_obj_t));
+    if (frontend->init(memsim_ram, memsim_ram_size) != 0) {
+        return -1;
+    }
+    frontend->heap(&heap);
+    used_init = heap.used;
+
+    for (i = 0; i < trace->num; i++) {
+        op = &trace->ops[i];
+
+        if (op->type == MEMSIM_OP_ALLOC) {
+            start = memsim_ns();
+            ptr   = frontend->alloc(op->size);
+            cost  = memsim_ns() - start;
+            memsim_alloc_ns[alloc_num++] = (cost > memsim_overhead) ? (uint32_t)(cost - memsim_overhead) : 0;
+
+            if (ptr == nullptr) {
+                if (fail++ == 0) {
+                    first_fail = i;
+                }
+                if (memsim_verbose && fail <= MEMSIM_FAIL_SHOW) {
+                    frontend->heap(&heap);
+                    printf("FAIL %s op=%u size=%u live=%llu used=%u free=%u largest=%u\n", frontend->name, (unsigned)i,
+                           (unsigned)op->size, (unsigned long long)live, (unsigned)heap.used, (unsigned)heap.free,
+                           (unsigned)heap.largest);
+                }
+                if (frontend->drain != nullptr) {
+                    frontend->drain();
+                }
+                continue;
+            }
+            memset(ptr, memsim_fill(op->slot), op->size);
+            memsim_obj[op->slot].ptr  = ptr;
+            memsim_obj[op->slot].size = op->size;
+            live += op->size;
+            if (live > live_peak) {
+                live_peak = live;
+                frontend->heap(&heap);
+                used_peak = (heap.used > used_peak) ? heap.used : used_peak;
+            }
+        } else {
+            memsim_obj_t* obj = &memsim_obj[op->slot];
+
+            if (obj->ptr == nullptr) {
+                continue;   // alloc failed
+            }
+            // a block given to two objects is found by the fill of the other one
+            if (((uint8_t*)obj->ptr)[0] != memsim_fill(op->slot) ||
+                ((uint8_t*)obj->ptr)[obj->size - 1] != memsim_fill(op->slot)) {
+                corrupt++;
+            }
+            start = memsim_ns();
+            frontend->free(obj->ptr, obj->size);
+            cost = memsim_ns() - start;
+            memsim_free_ns[free_num++] = (cost > memsim_overhead) ? (uint32_t)(cost - memsim_overhead) : 0;
+            live -= obj->size;
+            obj->ptr = nullptr;
+        }
+
+        if (memsim_interval != 0 && (i + 1) % memsim_interval == 0) {
+            frontend->heap(&heap);
+            used_peak = (heap.used > used_peak) ? heap.used : used_peak;
+            frag      = (heap.free == 0) ? 0 : (uint32_t)(100u - (uint64_t)heap.largest * 100u / heap.free);
+            frag_max  = (frag > frag_max) ? frag : frag_max;
+            if (memsim_verbose) {
+                printf("SAMPLE %s op=%u live=%llu used=%u cached=%u free=%u largest=%u extents=%u frag=%u\n",
+                       frontend->name, (unsigned)(i + 1), (unsigned long long)live, (unsigned)heap.used,
+                       (unsigned)heap.cached, (unsigned)heap.free, (unsigned)heap.largest, (unsigned)heap.extents,
+                       (unsigned)frag);
+            }
+        }
+    }
+
+    if (frontend->drain != nullptr) {
+        frontend->drain();
+    }
+    frontend->heap(&heap);
+
+    memsim_time_report(memsim_alloc_ns, alloc_num, &alloc_sum, alloc_line, "alloc");
+    memsim_time_report(memsim_free_ns, free_num, &free_sum, free_line, "free");
+    printf("MEMSIM %s ops=%u fail=%u mops=%.1f%s%s live=%llu used=%u frag=%u first_fail=%u corrupt=%u leak=%d\n",
+           frontend->name, (unsigned)(alloc_num + free_num), (unsigned)fail,
+           (alloc_sum + free_sum == 0) ? 0.0 : (double)(alloc_num + free_num) * 1000.0 / (double)(alloc_sum + free_sum),
+           alloc_line, free_line, (unsigned long long)live_peak, (unsigned)used_peak, (unsigned)frag_max,
+           (unsigned)first_fail, (unsigned)corrupt, (int)(heap.used - used_init));
+    return 0;
+}
+
+
+/**
+ * @brief min cost of reading clock, subtracted from every op
+ */
+static void memsim_calibrate(void) {
+    uint64_t start, cost;
+    uint32_t i;
+
+    memsim_overhead = 0xFFFFFFFFu;
+    for (i = 0; i < 1000u; i++) {
+        start = memsim_ns();
+        cost  = memsim_ns() - start;
+        if (cost < memsim_overhead) {
+            memsim_overhead = (uint32_t)cost;
+        }
+    }
+}
+
+
+static void memsim_usage(void) {
+    fprintf(stderr,
+            "usage: tos_memsim [options]\n"
+            "  -a <frontend>  tos_mem, tos_malloc, tlsf or all (default)\n"
+            "  -r <bytes>     RAM size, default 16384, max %u\n"
+            "  -t <file>      replay trace file, lines of 'a <id> <size>' and 'f <id>'\n"
+            "  -d <dist>      size of synthetic trace: small, mixed (default), large, uniform:<min>:<max>\n"
+            "  -p <pattern>   steady (default), burst or pinned\n"
+            "  -n <ops>       ops of synthetic trace, default 100000\n"
+            "  -l <objects>   max live objects of synthetic trace, default 100\n"
+            "  -s <seed>      default 1\n"
+            "  -i <ops>       sample heap every ops, default ops / 50\n"
+            "  -v             print samples and failures\n",
+            (unsigned)MEMSIM_RAM_MAX);
+}
+
+
+int main(int argc, char* argv[]) {
+    memsim_trace_t trace    = {0};
+    const char*    front    = "all";
+    const char*    path     = nullptr;
+    const char*    dist     = "mixed";
+    const char*    pattern  = "steady";
+    uint32_t       op_num   = 100000u;
+    uint32_t       live_max = 100u;
+    uint32_t       i;
+    int            opt, found = 0;
+    uint32_t       (*size)(void) = nullptr;
+
+    memsim_rand_state = 1;
+    while ((opt = getopt(argc, argv, "a:r:t:d:p:n:l:s:i:v")) != -1) {
+        switch (opt) {
+            case 'a': front = optarg; break;
+            case 'r': memsim_ram_size = (tos_size_t)strtoul(optarg, nullptr, 0); break;
+            case 't': path = optarg; break;
+            case 'd': dist = optarg; break;
+            case 'p': pattern = optarg; break;
+            case 'n': op_num = (uint32_t)strtoul(optarg, nullptr, 0); break;
+            case 'l': live_max = (uint32_t)strtoul(optarg, nullptr, 0); break;
+            case 's': memsim_rand_state = (uint32_t)strtoul(optarg, nullptr, 0) | 1u; break;
+            case 'i': memsim_interval = (uint32_t)strtoul(optarg, nullptr, 0); break;
+            case 'v': memsim_verbose = true; break;
+            default: memsim_usage(); return 1;
+        }
+    }
+    if (memsim_ram_size == 0 || memsim_ram_size > MEMSIM_RAM_MAX || live_max == 0) {
+        memsim_usage();
+        return 1;
+    }
+
+    if (path != nullptr) {
+        if (memsim_trace_load(&trace, path) != 0) {
+            fprintf(stderr, "memsim: fail to read %s\n", path);
+            return 1;
+        }
+    } else {
+        for (i = 0; i < sizeof(memsim_dist) / sizeof(memsim_dist[0]); i++) {
+            if (strncmp(dist, memsim_dist[i].name, strlen(memsim_dist[i].name)) == 0) {
+                size = memsim_dist[i].size;
+            }
+        }
+        if (size == memsim_dist_uniform &&
+            (sscanf(dist, "uniform:%u:%u", &memsim_uniform_min, &memsim_uniform_max) != 2 || memsim_uniform_min == 0 ||
+             memsim_uniform_min > memsim_uniform_max)) {
+            size = nullptr;
+        }
+        if (size == nullptr || memsim_trace_gen(&trace, pattern, size, op_num, live_max) != 0) {
+            memsim_usage();
+            return 1;
+        }
+    }
+    if (memsim_interval == 0) {
+        memsim_interval = (trace.num / 50u > 0) ? trace.num / 50u : 1u;
+    }
+
+    memsim_obj      = calloc(trace.slot_num + 1u, sizeof(memsim_obj_t));
+    memsim_alloc_ns = malloc((trace.num + 1u) * sizeof(uint32_t));
+    memsim_free_ns  = malloc((trace.num + 1u) * sizeof(uint32_t));
+    if (memsim_obj == nullptr || memsim_alloc_ns == nullptr || memsim_free_ns == nullptr) {
+        fprintf(stderr, "memsim: out of host memory\n");
+        return 1;
+    }
+    memsim_calibrate();
+
+    printf("MEMSIM_BEGIN ram=%u ops=%u objects=%u ignored=%u block_max=%u chunk_blks=%u page=%u overhead=%u\n",
+           (unsigned)memsim_ram_size, (unsigned)trace.num, (unsigned)trace.slot_num, (unsigned)trace.ignored,
+           (unsigned)TOS_MEM_BLOCK_MAX, (unsigned)TOS_MEM_CHUNK_BLKS, (unsigned)(1u << TOS_MEM_PAGE_LOG2),
+           (unsigned)memsim_overhead);
+    for (i = 0; i < sizeof(memsim_frontend) / sizeof(memsim_frontend[0]); i++) {
+        if (strcmp(front, "all") != 0 && strcmp(front, memsim_frontend[i].name) != 0) {
+            continue;
+        }
+        found = 1;
+        if (memsim_run(&memsim_frontend[i], &trace) != 0) {
+            fprintf(stderr, "memsim: %s fails to init %u bytes\n", memsim_frontend[i].name,
+                    (unsigned)memsim_ram_size);
+        }
+    }
+    printf("MEMSIM_END\n");
+
+    free(trace.ops);
+    free(memsim_obj);
+    free(memsim_alloc_ns);
+    free(memsim_free_ns);
+    free(memsim_id_key);
+    free(memsim_id_next);
+    if (!found) {
+        memsim_usage();
+        return 1;
+    }
+    return 0;
+}
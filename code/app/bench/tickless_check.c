@@ -0,0 +1,92 @@
+/**
+ * @file tickless_check.c
+ * @brief wake accuracy check of tickless idle, an application instead of app/main.c, built by make check
+ * @note the only task sleeps N ticks for some N, so idle task stops the periodic tick and sleeps N ticks at once.
+ *       sys ticks must advance by exactly N, and the wall time by N ticks. host may run the process late but never
+ *       early, which adds ticks and time, so each N is repeated, some sleep must be exact and the shortest wall
+ *       time is checked. one line for each N is sent to debug uart, then the process exits with the number of
+ *       failed N:
+ *           CHECK tickless ticks=<N> exact=<sleeps which passed N ticks>/<repeat> us=<shortest wall time> ok|FAIL
+ */
+
+#include "bsp.h"
+
+#include "tos_core.h"
+#include "tos_cpu.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+#if !TOS_TICKLESS_ENABLE
+#error "build with -DTOS_TICKLESS_ENABLE=1"
+#endif
+
+#define CHECK_TASK_PRIO  3u
+#define CHECK_JITTER_US  5000u   // plus 1/4 of the sleep
+#define CHECK_REPEAT     5u
+#define CHECK_CYCLES_US  (MCU_SYS_CLOCK / 1000000u)
+
+
+static tos_stack_t check_stack[512];
+static uint32_t    check_ticks[] = {TOS_TICKLESS_MIN_TICKS, 3u, 10u, 37u, 100u};
+
+
+static void check_task(void* arg) {
+    char     line[96];
+    uint32_t fail = 0, i, j, start, cycles, passed, us, want, exact;
+    bool     ok;
+
+    for (i = 0; i < sizeof(check_ticks) / sizeof(check_ticks[0]); i++) {
+        exact = 0;
+        us    = 0xFFFFFFFFu;
+        for (j = 0; j < CHECK_REPEAT; j++) {
+            tos_task_sleep(TOS_TICK_MS);   // start at a tick boundary
+
+            start  = tos_get_sys_ticks();
+            cycles = tos_cpu_cycle_get();
+            tos_task_sleep(check_ticks[i] * TOS_TICK_MS);
+            cycles = tos_cpu_cycle_get() - cycles;
+            passed = tos_get_sys_ticks() - start;
+
+            exact += (passed == check_ticks[i]) ? 1u : 0u;
+            us = (cycles / CHECK_CYCLES_US < us) ? cycles / CHECK_CYCLES_US : us;
+        }
+        want = check_ticks[i] * TOS_TICK_MS * 1000u;
+
+        // the sleep starts a little after a tick, so it may be up to one tick shorter
+        ok = (exact > 0) && (us + TOS_TICK_MS * 1000u >= want) && (us <= want + want / 4u + CHECK_JITTER_US);
+        if (!ok) {
+            fail++;
+        }
+        snprintf(line, sizeof(line), "CHECK tickless ticks=%u exact=%u/%u us=%u %s\n", (unsigned)check_ticks[i],
+                 (unsigned)exact, (unsigned)CHECK_REPEAT, (unsigned)us, ok ? "ok" : "FAIL");
+        uart_dbg_send_string(line);
+    }
+
+    exit((int)fail);
+}
+
+
+int main() {
+    tos_task_attr_t task = {0};
+
+    sysclk_init();
+    sysirq_init();
+    uart_dbg_init(115200);
+
+    tos_init();
+
+    task.task_stack      = check_stack;
+    task.task_stack_size = sizeof(check_stack);
+    task.task_prio       = CHECK_TASK_PRIO;
+    task.task_name       = "check";
+    tos_task_create(check_task, nullptr, &task);
+
+    tos_start();
+}
+
+
+int main_cmd(int argc, char* argv[]) {
+    return 0;
+}
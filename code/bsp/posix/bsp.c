@@ -0,0 +1,110 @@
+/**
+ * @file bsp.c
+ * @brief bsp for linux host simulation
+ * @note debug uart is stdin/stdout, rx irq is SIGIO of stdin
+ */
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bsp.h"
+
+#include "log_core.h"
+#include "shell_core.h"
+#include "tos_core.h"
+#include "tos_dpc.h"
+#include "tos_cpu_posix.h"
+
+
+uint32_t    SystemCoreClock = 0;
+static bool uart_dbg_inited = false;
+
+
+/**
+ * @brief nothing to init on host
+ *
+ */
+void sysclk_init(void) {
+    SystemCoreClock = 72 * 1000000;
+}
+
+
+void sysirq_init(void) {
+}
+
+
+void NVIC_Init(uint8_t GroupPrio, uint8_t SubPrio, uint8_t NvicChannel) {
+}
+
+
+/**
+ * @brief stdin raises SIGIO when data comes
+ *
+ * @param bound no use
+ */
+void uart_dbg_init(uint32_t bound) {
+    tos_posix_irq_install(SIGIO, uart_dbg_isr);
+
+    fcntl(STDIN_FILENO, F_SETOWN, getpid());
+    fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_ASYNC | O_NONBLOCK);
+
+    uart_dbg_inited = true;
+    log_printk("uart inited\n");
+}
+
+
+/**
+ * @brief write to stdout directly, stdio is not safe when task is switched in signal handler
+ *
+ * @param data
+ * @param len
+ */
+void uart_dbg_send_data(const uint8_t* data, uint16_t len) {
+    ssize_t ret;
+
+    if (uart_dbg_inited) {
+        while (len > 0) {
+            ret = write(STDOUT_FILENO, data, len);
+            if (ret <= 0)
+                return;
+            data += ret;
+            len -= ret;
+        }
+    }
+}
+
+
+void uart_dbg_send_string(const char* data) {
+    if (uart_dbg_inited) {
+        if (data == nullptr)
+            return;
+        uart_dbg_send_data((const uint8_t*)data, strlen(data));
+    }
+}
+
+
+/**
+ * @brief pass received char to shell, called in dpc task
+ *
+ * @param arg the char
+ */
+static void uart_dbg_rx_dpc(void* arg) {
+    shell_get_newchar((uint8_t)(uintptr_t)arg);
+}
+
+
+void uart_dbg_isr(void) {
+    uint8_t data;
+
+    tos_enter_isr();
+
+    while (read(STDIN_FILENO, &data, 1) == 1) {
+        tos_dpc_post(uart_dbg_rx_dpc, (void*)(uintptr_t)data);
+    }
+
+    tos_exit_isr();
+}
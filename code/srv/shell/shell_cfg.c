@@ -1,27 +1,128 @@
-#include "shell_cfg.h"
-#include "log_core.h"
-#include "shell_core.h"
-
-extern int main_cmd(int argc, char* argv[]);
-
-static int echo_cmd(int argc, char* argv[]) {
-    int i = 0;
-    for (i = 1; i < argc; i++) {
-        log_printf("%s ", argv[i]);
-    }
-    log_printf("\n");
-    return 0;
-}
-
-
-static const shell_cmd_cfg_t shell_cmd_list[] = {
-    {"echo", echo_cmd, "usage: echo xxx"},
-    {"help", shell_help_info, "usage: help"},
-    {"main", main_cmd, "usage: main ..."},
-};
-
-
-shell_cfg_t shell_cfg = {
-    shell_cmd_list,
-    sizeof(shell_cmd_list) / sizeof(shell_cmd_list[0]),
-};
+#include "shell_cfg.h"
+#include "log_core.h"
+#include "shell_core.h"
+#include "tos_core.h"
+#include "tos_mem.h"
+#include "tos_trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+extern int main_cmd(int argc, char* argv[]);
+
+static int echo_cmd(int argc, char* argv[]) {
+    int i = 0;
+    for (i = 1; i < argc; i++) {
+        log_printf("%s ", argv[i]);
+    }
+    log_printf("\n");
+    return 0;
+}
+
+
+static int ps_cmd(int argc, char* argv[]) {
+    static tos_task_info_t info[TOS_MAX_TASK_NUM_USED + 1];
+    static const char*     state_name[] = {"stop", "run", "ready", "pend", "wait", "inv"};
+    uint32_t               num, i;
+    char                   cpu[16];
+#if TOS_CPU_USAGE_ENABLE
+    uint64_t total = tos_isr_cycles_get();
+    uint32_t permille;
+#endif
+
+    num = tos_task_info_get(info, sizeof(info) / sizeof(info[0]));
+#if TOS_CPU_USAGE_ENABLE
+    for (i = 0; i < num; i++) {
+        total += info[i].task_run_cycles;
+    }
+#endif
+
+    log_printf("id prio state switch    cpu    stack     name\n");
+    for (i = 0; i < num; i++) {
+#if TOS_CPU_USAGE_ENABLE
+        permille = total ? (uint32_t)(info[i].task_run_cycles * 1000u / total) : 0;
+        snprintf(cpu, sizeof(cpu), "%u.%u%%", (unsigned)(permille / 10), (unsigned)(permille % 10));
+#else
+        strcpy(cpu, "n/a");   // cycles are not counted
+#endif
+        log_printf("%2u %2u/%-2u %-5s %-8u %6s %4u/%-4u%c %s\n", (unsigned)info[i].task_id,
+                   (unsigned)info[i].task_prio, (unsigned)info[i].task_base_prio, state_name[info[i].task_state],
+                   (unsigned)info[i].task_switch_cnt, cpu, (unsigned)info[i].task_stack_peak,
+                   (unsigned)info[i].task_stack_size, info[i].task_stack_overflow ? '!' : ' ', info[i].task_name);
+    }
+    // periodic tasks, or tasks missed deadline of tos_task_sleep_until
+    for (i = 0; i < num; i++) {
+        if (info[i].task_period != 0 || info[i].task_deadline_miss != 0) {
+            log_printf("%2u period %u miss %u overrun %u\n", (unsigned)info[i].task_id, (unsigned)info[i].task_period,
+                       (unsigned)info[i].task_deadline_miss, (unsigned)info[i].task_overrun);
+        }
+    }
+#if TOS_CPU_USAGE_ENABLE
+    permille = total ? (uint32_t)(tos_isr_cycles_get() * 1000u / total) : 0;
+    log_printf("isr cpu %u.%u%%\n", (unsigned)(permille / 10), (unsigned)(permille % 10));
+#endif
+    return 0;
+}
+
+
+static int trace_cmd(int argc, char* argv[]) {
+#if TOS_TRACE_ENABLE
+    if (argc == 2 && strcmp(argv[1], "start") == 0) {
+        tos_trace_start();
+        return 0;
+    }
+    if (argc == 2 && strcmp(argv[1], "stop") == 0) {
+        tos_trace_stop();
+        return 0;
+    }
+    log_printf("usage: trace start|stop\n");
+    return -1;
+#else
+    log_printf("trace is disabled\n");
+    return -1;
+#endif
+}
+
+
+static int mem_cmd(int argc, char* argv[]) {
+    tos_mem_stat_t stat;
+    uint32_t       i;
+
+    if (argc == 2 && strcmp(argv[1], "compact") == 0) {
+        log_printf("returned %u bytes\n", (unsigned)tos_mem_compact());
+        return 0;
+    }
+    if (tos_mem_stat_get(&stat) != 0) {
+        log_printf("mem is not inited\n");
+        return -1;
+    }
+
+    log_printf("free area %u largest %u extents %u\n", (unsigned)stat.free_area_bytes, (unsigned)stat.largest_free,
+               (unsigned)stat.free_extent_num);
+    log_printf("chunks %u/%u bytes carved %u\n", (unsigned)stat.chunk_num, (unsigned)stat.chunk_bytes,
+               (unsigned)stat.carve_cnt);
+    log_printf("compact %u returned %u/%u bytes\n", (unsigned)stat.compact_cnt, (unsigned)stat.return_cnt,
+               (unsigned)stat.return_bytes);
+    for (i = 0; i < TOS_MEM_CLASS_NUM; i++) {
+        if (stat.class_free_bytes[i] != 0) {
+            log_printf("%3u: %u bytes free\n", (unsigned)((i + 1) * 8), (unsigned)stat.class_free_bytes[i]);
+        }
+    }
+    return 0;
+}
+
+
+static const shell_cmd_cfg_t shell_cmd_list[] = {
+    {"echo", echo_cmd, "usage: echo xxx"},
+    {"help", shell_help_info, "usage: help"},
+    {"main", main_cmd, "usage: main ..."},
+    {"mem", mem_cmd, "usage: mem [compact], show fragmentation, or return free chunks of small blocks"},
+    {"ps", ps_cmd, "usage: ps, show tasks, cpu usage and stack peak/size"},
+    {"trace", trace_cmd, "usage: trace start|stop, binary trace packets are sent to uart"},
+};
+
+
+shell_cfg_t shell_cfg = {
+    shell_cmd_list,
+    sizeof(shell_cmd_list) / sizeof(shell_cmd_list[0]),
+};
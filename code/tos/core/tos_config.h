@@ -1,28 +1,100 @@
-/**
- * @file tos_config.h
- * @brief task, stack, clock configs
- * 
- */
-
-#ifndef _TOS_CONFIG_H_
-#define _TOS_CONFIG_H_
-
-
-// task config
-#define TOS_MAX_PRIO_NUM_USED   8   // max prio is 31
-#define TOS_MAX_TASK_NUM_USED   8   // without limit
-#define TOS_IDLETASK_STACK_SIZE 512
-
-// clock config
-#define TOS_SYS_HZ              1000u
-#define TOS_TICK_MS             (1000u / TOS_SYS_HZ)
-#define TOS_TIME_WAIT_INFINITY  0xFFFFFFFFu
-#define MCU_SYS_CLOCK           72000000u   // 72 MHz
-
-// mutex
-#define TOS_MAX_MUTEX_NUM       10u
-
-// condition
-#define TOS_MAX_COND_NUM        10u
-
-#endif
+/**
+ * @file tos_config.h
+ * @brief task, stack, clock configs
+ * 
+ */
+
+#ifndef _TOS_CONFIG_H_
+#define _TOS_CONFIG_H_
+
+
+// task config
+#define TOS_PRIO_LEVEL_NUM      32  // 8, 32 or 256 prio levels in ready bitmap, prio 0 is lowest (idle task)
+#define TOS_MAX_PRIO_NUM_USED   8   // max prio is TOS_PRIO_LEVEL_NUM - 1, ready lists are kept up to it
+#define TOS_MAX_TASK_NUM_USED   8   // without limit
+#define TOS_IDLETASK_STACK_SIZE 512
+
+// dynamic task, tcb and stack are allocated from heap by tos_task_create_dynamic, freed when task is deleted.
+// heap functions are called in critical section
+#define TOS_TASK_DYNAMIC_ENABLE 1
+#define TOS_TASK_MALLOC(size)   tos_malloc(size)   // tos_mem should be inited before
+#define TOS_TASK_FREE(ptr)      tos_free(ptr)
+
+// time slice, round robin for ready tasks with same prio
+#define TOS_TIME_SLICE_ENABLE   1
+#define TOS_TIME_SLICE_DEFAULT  10u   // ticks, used when task_time_slice of task attr is 0
+
+// clock config
+#define TOS_SYS_HZ              1000u
+#define TOS_TICK_MS             (1000u / TOS_SYS_HZ)
+#define TOS_TIME_WAIT_INFINITY  0xFFFFFFFFu
+#define MCU_SYS_CLOCK           72000000u   // 72 MHz
+
+// kernel critical section masks irq with NVIC prio value >= TOS_IRQ_MASK_PRIO by BASEPRI (stm32f1 port).
+// irq with higher prio (smaller value) is never delayed by kernel, and must not call kernel api.
+// 0 to mask all irq by PRIMASK. other ports always mask all irq
+#define TOS_IRQ_MASK_PRIO       0x40u       // group prio 0 is not masked with NVIC_PrioGroupCfg(2)
+
+// tickless idle, stop the periodic tick when all tasks are sleeping (stm32f1 and posix ports).
+// may be given by -D, make check builds the host wake accuracy check with it
+#ifndef TOS_TICKLESS_ENABLE
+#define TOS_TICKLESS_ENABLE     0
+#endif
+#define TOS_TICKLESS_MIN_TICKS  2u          // sleep shorter than this keeps the periodic tick
+
+// cpu usage, count cpu cycles of each task and ISR by cycle counter (stm32f1 and posix ports)
+#define TOS_CPU_USAGE_ENABLE    0
+
+// stack check, paint task stack when create, idle task scans the high-watermark and checks overflow periodically
+#define TOS_STACK_CHECK_ENABLE  1
+#define TOS_STACK_CHECK_PERIOD  500u        // ticks
+#define TOS_STACK_FILL_PATTERN  0xDEADBEEFu
+
+// kernel event trace, timestamp by cpu cycle counter (stm32f1 and posix ports)
+#define TOS_TRACE_ENABLE        0
+#define TOS_TRACE_BUFFER_SIZE   128u        // records in ring buffer, power of 2, 8 bytes each
+
+// software timer, callbacks run in timer task
+#define TOS_TIMER_ENABLE          1
+#define TOS_MAX_TIMER_NUM         10u
+#define TOS_TIMER_TASK_PRIO       TOS_MAX_PRIO_NUM_USED   // highest prio by default
+#define TOS_TIMER_TASK_STACK_SIZE 512u
+#define TOS_TIMER_WHEEL_BITS      5u          // 4 levels of (1 << bits) slots, 2^20 ticks in wheel range
+
+// deferred procedure call, posted by ISR, run in dpc task
+#define TOS_DPC_QUEUE_SIZE      16u         // posted and not run calls, power of 2
+#define TOS_DPC_TASK_PRIO       TOS_MAX_PRIO_NUM_USED   // highest prio by default
+#define TOS_DPC_TASK_STACK_SIZE 512u
+
+// mutex
+#define TOS_MAX_MUTEX_NUM       10u
+
+// condition
+#define TOS_MAX_COND_NUM        10u
+
+// semaphore
+#define TOS_MAX_SEM_NUM         10u
+
+// event group
+#define TOS_MAX_EVENT_NUM       10u
+
+// message queue
+#define TOS_MAX_MSGQ_NUM        10u
+
+// memory, blocks over TOS_MEM_BLOCK_MAX bytes are allocated by TLSF (two level segregated fit).
+// small block settings may be given by -D, to compare them with the host allocator simulator (make memsim)
+#define TOS_MEM_TLSF_SL_LOG2    3u          // 8 classes in each power of 2, waste of rounding up <= 1/8
+#define TOS_MEM_TLSF_FL_MAX     16u         // max block and pool size is 2^16 bytes
+#ifndef TOS_MEM_BLOCK_MAX
+#define TOS_MEM_BLOCK_MAX       128u        // max small block, multiple of 8, one lock free list of each 8 bytes
+#endif
+#ifndef TOS_MEM_CHUNK_BLKS
+#define TOS_MEM_CHUNK_BLKS      5u          // small blocks carved at once when a list is empty
+#endif
+#ifndef TOS_MEM_PAGE_LOG2
+#define TOS_MEM_PAGE_LOG2       6u          // small blocks are carved in 64 byte pages, 1 byte map per page
+#endif
+#define TOS_MEM_DEBUG_ENABLE    0           // tos_malloc adds a 4 byte magic header, checked by tos_free
+#define TOS_MEM_IDLE_COMPACT_ENABLE 1       // idle task runs tos_mem_compact after an alloc failed
+
+#endif
@@ -1,585 +1,1267 @@
-/**
- * @file tos_core.c
- * @brief tos core and task management module
- */
-
-#define _IN_TOS_CORE_C_
-
-
-#include "tos_core.h"
-#include "tos_config.h"
-#include "tos_core_.h"
-#include "tos_utils.h"
-
-#include "log_core.h"
-#include <string.h>
-
-
-static uint32_t    tos_get_highest_prio(uint32_t prio_mask);
-static void        tos_idle_task_proc(void* args);
-static tos_task_t* tos_get_free_tcb(void);
-static tos_task_t* tos_task_tcb_init(tos_task_attr_t* taskAttr, tos_stack_t* taskStackPtr);
-
-
-uint32_t           tos_task_prio_current;                                                // task core cpu
-uint32_t           tos_task_prio_switch_to;                                              // core cpu
-tos_task_t*        tos_task_current;                                                     //
-tos_task_t*        tos_task_switch_to;                                                   //
-tos_run_state_t    tos_state = {0};                                                      //
-static tos_stack_t tos_idle_task_stack[TOS_IDLETASK_STACK_SIZE / sizeof(tos_stack_t)];   //
-static tos_task_t  tos_tcb_pool[TOS_MAX_TASK_NUM_USED + 1];                              // add 1 for IDLE task
-
-
-/**
- * @brief init variables used by tos
- *
- * @return true
- * @return false
- */
-bool tos_init(void) {
-    uint32_t        index;
-    tos_task_attr_t taskAttr;
-
-    tos_irq_diable();   // irq will be enable in tos_start
-
-    // state init
-    tos_task_current          = nullptr;
-    tos_task_prio_current     = 0;
-    tos_state.intr_level      = 0;
-    tos_state.schedule_enable = false;
-    tos_state.sys_running     = false;
-    tos_state.sys_ticks       = 0;
-    tos_state.task_number     = 0;
-
-    // init ready_list, waiting_list, all_list
-    tos_state.ready_task_prio_mask = 0;
-    for (index = 0; index <= TOS_MAX_PRIO_NUM_USED; index++) {
-        tos_queue_init(&tos_state.ready_task_list[index]);
-    }
-    tos_queue_init(&tos_state.waiting_task_list);
-    tos_queue_init(&tos_state.all_task_list);
-    tos_queue_init(&tos_state.free_tcb_list);
-
-    // init free tcb list
-    memset(tos_tcb_pool, 0, sizeof(tos_tcb_pool));
-    for (index = 0; index <= TOS_MAX_TASK_NUM_USED; index++) {
-        tos_queue_insert(&tos_state.free_tcb_list, &tos_tcb_pool[index].all_free_link);
-    }
-
-    // create idle task
-    taskAttr.task_name       = "idle_task";
-    taskAttr.task_wait_time  = 0;
-    taskAttr.task_prio       = 0;   // lowest prio
-    taskAttr.task_stack_size = TOS_IDLETASK_STACK_SIZE;
-    taskAttr.task_stack      = tos_idle_task_stack;
-
-    if (tos_task_create(tos_idle_task_proc, nullptr, &taskAttr) == nullptr) {
-        tos_error("idle task create error!");
-        return false;
-    }
-
-    return true;
-}
-
-
-/**
- * @brief start tos
- * @note called after tos_init
- */
-void tos_start(void) {
-    tos_task_prio_switch_to = tos_get_highest_prio(tos_state.ready_task_prio_mask);
-    tos_task_switch_to      = get_task_by_ready_pending_link(tos_state.ready_task_list[tos_task_prio_switch_to].next);
-
-    tos_state.sys_running     = true;
-    tos_state.schedule_enable = true;
-
-    tos_task_switch_to->task_switch_cnt++;
-
-    tos_sys_clock_init();   // tos sys tick clock init
-
-    // CM3 use PendSV IRQ to switch task, use a flag to tell the PendSV ISR if it need to store the context
-    // for other platform, call the `switch_to` asm code derectly
-    tos_task_switch_first();
-}
-
-
-/**
- * @brief start tos clock
- * @note much better to call it in init_task
- */
-void tos_clock_start(void) {
-    tos_sys_clock_init();   // tos sys tick clock init
-}
-
-
-/**
- * @brief called at begin of ISR
- *
- */
-void tos_enter_isr(void) {
-    tos_use_critical_section();
-
-    tos_enter_critical_section();
-    if (tos_state.sys_running) {
-        if (tos_state.intr_level < 255) {
-            tos_state.intr_level++;
-        }
-    }
-
-    tos_leave_critical_section();
-}
-
-
-/**
- * @brief called at end of ISR
- *
- */
-void tos_exit_isr(void) {
-    tos_use_critical_section();
-
-    if (tos_state.sys_running == true) {
-        tos_enter_critical_section();
-
-        if (tos_state.intr_level > 0)
-            tos_state.intr_level--;
-
-        // schedule when all intr exit
-        if (tos_state.intr_level == 0 && tos_state.schedule_enable == true) {
-            tos_task_prio_switch_to = tos_get_highest_prio(tos_state.ready_task_prio_mask);
-            tos_task_switch_to = get_task_by_ready_pending_link(tos_state.ready_task_list[tos_task_prio_switch_to].next);
-
-            if (tos_task_switch_to != tos_task_current) {
-                tos_task_switch_to->task_switch_cnt++;
-                tos_task_switch_intr();
-            }
-        }
-
-        tos_leave_critical_section();
-    }
-}
-
-
-/**
- * @brief enable schedule
- *
- */
-void tos_schedule_enable(void) {
-    tos_use_critical_section();
-
-    tos_enter_critical_section();
-
-    tos_state.schedule_enable = true;
-
-    tos_leave_critical_section();
-}
-
-
-/**
- * @brief disable schedule
- *
- */
-void tos_schedule_disable(void) {
-    tos_use_critical_section();
-
-    tos_enter_critical_section();
-
-    tos_state.schedule_enable = false;
-
-    tos_leave_critical_section();
-}
-
-
-/**
- * @brief create new task
- *
- * @param proc task proc
- * @param args args of task proc
- * @param attr task attr
- * @return tos_task_t* task hdl, return nullptr when failed
- */
-tos_task_t* tos_task_create(tos_task_proc_t proc, void* args, tos_task_attr_t* attr) {
-    tos_task_t*  task_hdl;
-    tos_stack_t* task_stack_ptr;
-    tos_use_critical_section();
-
-    if (attr == nullptr || attr->task_stack == nullptr) {
-        return nullptr;
-    }
-
-    tos_enter_critical_section();
-    if (tos_state.intr_level > 0) {
-        tos_leave_critical_section();
-        return nullptr;
-    }
-
-    tos_leave_critical_section();
-
-    tos_stack_t* stack_end = &attr->task_stack[(attr->task_stack_size / sizeof(tos_stack_t))];
-
-    log_printk("create %15s: [%p, %p) %4d Bytes.\n", attr->task_name, attr->task_stack, stack_end,
-               attr->task_stack_size);
-
-    task_stack_ptr = tos_task_stack_frame_init(proc, args, stack_end - 1);
-    task_hdl       = tos_task_tcb_init(attr, task_stack_ptr);
-
-    if (task_hdl == nullptr) {
-        tos_error("try to create task(%s, id=%d) error", attr->task_name, tos_state.task_number + 1);
-        return nullptr;
-    }
-
-    if (tos_state.sys_running) {
-        tos_schedule();
-    }
-
-    return task_hdl;
-}
-
-
-/**
- * @brief delete task
- *
- * @param task_hdl
- */
-void tos_task_delete(tos_task_t* task_hdl) {
-    tos_use_critical_section();
-
-    // if (tos_state.intr_level > 0 || task_hdl == tos_task_current)
-    if (tos_state.intr_level > 0) {
-        return;
-    }
-
-    tos_enter_critical_section();
-
-    // remove task from read_pending list
-    tos_queue_remove(&task_hdl->ready_pending_link);
-    if (tos_queue_is_empty(&tos_state.ready_task_list[task_hdl->task_prio])) {
-        tos_state.ready_task_prio_mask &= ~task_hdl->task_prio_mask;
-    }
-    // remove task from waiting list
-    tos_queue_remove(&task_hdl->waiting_link);
-
-    // remove task from all_task list
-    tos_state.task_number--;
-    tos_queue_remove(&task_hdl->all_free_link);
-
-    // insert tcb into free list
-    tos_queue_insert(&tos_state.free_tcb_list, &task_hdl->all_free_link);
-
-    task_hdl->task_state = TOS_TASK_STATE_STOP;
-
-    tos_leave_critical_section();
-}
-
-
-/**
- * @brief
- *
- * @param task_hdl
- * @param prio
- * @return int32_t old prio when succeed, -1 when fail
- */
-int32_t tos_set_task_prio(tos_task_t* task_hdl, uint32_t prio) {
-    tos_use_critical_section();
-
-    uint8_t prio_old = task_hdl->task_prio;
-
-    if (prio == task_hdl->task_prio || task_hdl->task_state == TOS_TASK_STATE_STOP) {
-        return -1;
-    }
-
-    // running or ready task, in read_pending list
-    if (task_hdl->task_state == TOS_TASK_STATE_RUNNING || task_hdl->task_state == TOS_TASK_STATE_READY) {
-        tos_enter_critical_section();
-
-        // remove from old list
-        tos_queue_remove(&task_hdl->ready_pending_link);
-        if (tos_queue_is_empty(&tos_state.ready_task_list[task_hdl->task_prio])) {
-            tos_state.ready_task_prio_mask &= ~task_hdl->task_prio_mask;
-        }
-
-        // add into new list
-        tos_queue_insert(&tos_state.ready_task_list[prio], &task_hdl->ready_pending_link);
-        tos_state.ready_task_prio_mask |= 1 << prio;
-
-        tos_leave_critical_section();
-    }
-
-    // sleep or block task, in waiting or sem list, modify prio immediately
-    task_hdl->task_prio      = prio;
-    task_hdl->task_prio_mask = 1 << prio;
-
-    if (task_hdl == tos_task_current) {
-        tos_enter_critical_section();
-
-        tos_task_prio_current = task_hdl->task_prio_mask;
-
-        tos_leave_critical_section();
-    }
-
-    tos_schedule();
-
-    return prio_old;
-}
-
-
-/**
- * @brief
- *
- * @param task_hdl
- * @return int32_t
- */
-int32_t tos_get_task_prio(tos_task_t* task_hdl) {
-    if (task_hdl == nullptr)
-        return -1;
-
-    return task_hdl->task_prio;
-}
-
-
-/**
- * @brief get task state
- *
- * @param task_hdl
- * @return tos_task_state_t
- */
-tos_task_state_t tos_get_task_state(tos_task_t* task_hdl) {
-    if (task_hdl == nullptr)
-        return TOS_TASK_STATE_INVALID;
-
-    return task_hdl->task_state;
-}
-
-
-/**
- * @brief task sleep some time
- *
- * @param nms
- */
-void tos_task_sleep(uint32_t nms) {
-    if (nms == 0)
-        nms = 1;
-
-    tos_use_critical_section();
-
-    if (tos_state.intr_level > 0 || nms == 0) {
-        return;
-    }
-
-    tos_enter_critical_section();
-
-    tos_queue_remove(&tos_task_current->ready_pending_link);
-    if (tos_queue_is_empty(&tos_state.ready_task_list[tos_task_current->task_prio])) {
-        tos_state.ready_task_prio_mask &= ~tos_task_current->task_prio_mask;
-    }
-    tos_queue_init(&tos_task_current->ready_pending_link);
-
-    tos_task_current->task_wait_time = nms / TOS_TICK_MS;
-    tos_queue_insert(&tos_state.waiting_task_list, &tos_task_current->waiting_link);
-
-    tos_leave_critical_section();
-
-    tos_schedule();
-}
-
-
-/**
- * @brief task yield
- *
- */
-void tos_task_yield(void) {
-    tos_use_critical_section();
-    // important to use critical_section
-    // or maybe conflict with systick ISR
-
-    tos_enter_critical_section();
-    // remove from ready list, then add into list tail
-    tos_queue_remove(&tos_task_current->ready_pending_link);
-    tos_queue_insert(&tos_state.ready_task_list[tos_task_current->task_prio], &tos_task_current->ready_pending_link);
-    tos_leave_critical_section();
-
-    tos_schedule();
-}
-
-
-/**
- * @brief
- *
- * @return true
- * @return false
- */
-bool tos_running(void) {
-    return tos_state.sys_running;
-}
-
-
-/**
- * @brief
- *
- * @return tos_task_t*
- */
-tos_task_t* tos_get_current_task(void) {
-    return tos_task_current;
-}
-
-
-/**
- * @brief
- * @note called by cpu timer ISR
- */
-void tos_time_tick(void) {
-    tos_queue_node_t* list_node;
-    tos_queue_node_t* list_next;
-    tos_task_t*       task_hdl;
-    tos_use_critical_section();
-
-    tos_state.sys_ticks++;
-    tos_enter_critical_section();
-
-    // travel the time wait list
-    for (list_node = tos_state.waiting_task_list.next; list_node != &tos_state.waiting_task_list; list_node = list_next) {
-        task_hdl  = get_task_by_waiting_link(list_node);
-        list_next = list_node->next;   // NOTICE: list link maybe changed in the loop
-
-        if (task_hdl->task_wait_time != TOS_TIME_WAIT_INFINITY) {
-            if (--task_hdl->task_wait_time == 0) {
-                // move the task to ready list
-                tos_queue_remove(&task_hdl->ready_pending_link);   // the task may block in a sem list
-                tos_queue_insert(&tos_state.ready_task_list[task_hdl->task_prio], &task_hdl->ready_pending_link);
-                tos_state.ready_task_prio_mask |= task_hdl->task_prio_mask;
-
-                tos_queue_remove(&task_hdl->waiting_link);
-                tos_queue_init(&task_hdl->waiting_link);   // make list_node->next==list_node
-            }
-        }
-    }
-
-    tos_leave_critical_section();
-}
-
-
-/**
- * @brief
- *
- */
-void tos_schedule(void) {
-    tos_use_critical_section();
-
-    tos_enter_critical_section();
-
-    if (tos_state.intr_level == 0 && tos_state.schedule_enable == true) {
-        tos_task_prio_switch_to = tos_get_highest_prio(tos_state.ready_task_prio_mask);
-        tos_task_switch_to = get_task_by_ready_pending_link(tos_state.ready_task_list[tos_task_prio_switch_to].next);
-
-        if (tos_task_switch_to != tos_task_current) {
-            tos_task_switch_to->task_switch_cnt++;
-            tos_task_switch();
-        }
-    }
-
-    tos_leave_critical_section();
-}
-
-
-/**
- * @brief init task TCB
- *
- * @param attr taskattr
- * @param task_stack_ptr ptr to task stack
- * @return tos_task_t* task hdl
- * @note upper caller ensure do not call this when free tcb is used up
- */
-static tos_task_t* tos_task_tcb_init(tos_task_attr_t* attr, tos_stack_t* task_stack_ptr) {
-    tos_task_t* task_hdl;
-    tos_use_critical_section();
-
-    task_hdl = tos_get_free_tcb();
-
-    if (task_hdl == nullptr) {
-        return nullptr;
-    }
-
-    // task stack: stack is high addr to low addr
-    task_hdl->task_stk_ptr  = task_stack_ptr;
-    task_hdl->task_stk_base = &attr->task_stack[(attr->task_stack_size / sizeof(tos_stack_t)) - 1];
-    task_hdl->task_stk_size = attr->task_stack_size;
-    task_hdl->task_stk_top  = attr->task_stack - 1;
-
-    // schdule and other addr
-    task_hdl->task_prio        = attr->task_prio;
-    task_hdl->task_prio_mask   = 1u << attr->task_prio;
-    task_hdl->task_wait_time   = attr->task_wait_time;
-    task_hdl->task_name        = attr->task_name;
-    task_hdl->task_id          = tos_state.task_number;
-    task_hdl->task_state       = TOS_TASK_STATE_READY;
-    task_hdl->task_switch_cnt  = 0;
-    task_hdl->task_total_ticks = 0;
-
-    // modify global var, enter critical section
-    tos_enter_critical_section();
-
-    // inset new task tcb to ready list
-    tos_queue_insert(&tos_state.ready_task_list[task_hdl->task_prio], &task_hdl->ready_pending_link);
-    tos_queue_init(&task_hdl->waiting_link);
-
-    tos_state.ready_task_prio_mask |= task_hdl->task_prio_mask;
-    tos_state.task_number++;
-    tos_queue_insert(&tos_state.all_task_list, &task_hdl->all_free_link);
-
-    tos_leave_critical_section();
-
-    return task_hdl;
-}
-
-
-/**
- * get a free tcb from tos_state.free_tcb_list
- *
- *  @param   void
- *  @return  hdl of a free tcb, or nullptr
- *  @see
- *  @note
- */
-static tos_task_t* tos_get_free_tcb(void) {
-    tos_task_t* task_hdl;
-    tos_use_critical_section();
-
-    if (tos_queue_is_empty(&tos_state.free_tcb_list)) {
-        return nullptr;
-    }
-
-    tos_enter_critical_section();
-
-    task_hdl = get_task_by_all_free_link(tos_state.free_tcb_list.next);
-
-    tos_queue_remove(&task_hdl->all_free_link);
-
-    tos_leave_critical_section();
-
-    return task_hdl;
-}
-
-
-/**
- * @brief get highest prio
- *
- * @param prio_mask
- * @return uint32_t
- */
-static uint32_t tos_get_highest_prio(uint32_t prio_mask) {
-    uint32_t prio = 31;
-    while ((prio_mask & (1u << prio)) == 0) {
-        prio--;
-    }
-    return prio;
-}
-
-
-/**
- * @brief idle task proc
- *
- * @param args
- */
-static void tos_idle_task_proc(void* args) {
-    while (true) {
-    }
-}
+/**
+ * @file tos_core.c
+ * @brief tos core and task management module
+ */
+
+#define _IN_TOS_CORE_C_
+
+
+#include "tos_core.h"
+#include "tos_config.h"
+#include "tos_core_.h"
+#include "tos_pool.h"
+#include "tos_utils.h"
+#include "tos_waitq.h"
+
+#include "log_core.h"
+#include <string.h>
+#if TOS_TASK_DYNAMIC_ENABLE || TOS_MEM_IDLE_COMPACT_ENABLE
+#include "tos_mem.h"
+#endif
+
+
+static uint32_t    tos_get_highest_prio(void);
+static void        tos_idle_task_proc(void* args);
+static void        tos_time_pass(uint32_t ticks);
+#if TOS_TIME_SLICE_ENABLE
+static void tos_time_slice_tick(void);
+#endif
+#if TOS_TICKLESS_ENABLE
+static void tos_tickless_idle(void);
+#endif
+#if TOS_CPU_USAGE_ENABLE
+static void tos_cpu_usage_update(void);
+#endif
+#if TOS_STACK_CHECK_ENABLE
+static uint32_t tos_task_stack_used(tos_task_t* task_hdl);
+static void     tos_stack_check(void);
+#endif
+#if TOS_TASK_DYNAMIC_ENABLE
+static void tos_task_zombie_free(void);
+#endif
+static tos_task_t* tos_get_free_tcb(void);
+static void        tos_task_start(tos_task_t* task_hdl, tos_task_proc_t proc, void* args, tos_task_attr_t* attr);
+static void        tos_task_tcb_init(tos_task_t* task_hdl, tos_task_attr_t* attr, tos_stack_t* task_stack_ptr);
+
+
+uint32_t           tos_task_prio_current;                                                // task core cpu
+uint32_t           tos_task_prio_switch_to;                                              // core cpu
+tos_task_t*        tos_task_current;                                                     //
+tos_task_t*        tos_task_switch_to;                                                   //
+tos_run_state_t    tos_state = {0};                                                      //
+static tos_stack_t tos_idle_task_stack[TOS_IDLETASK_STACK_SIZE / sizeof(tos_stack_t)];   //
+TOS_POOL_DEFINE(tos_tcb_pool, tos_task_t, TOS_MAX_TASK_NUM_USED + 1, TOS_POOL_FLAG_NONE);   // add 1 for IDLE task
+
+
+/**
+ * @brief init variables used by tos
+ *
+ * @return true
+ * @return false
+ */
+bool tos_init(void) {
+    uint32_t        index;
+    tos_task_attr_t taskAttr;
+
+    tos_irq_diable();   // irq will be enable in tos_start
+
+    // state init
+    tos_task_current          = nullptr;
+    tos_task_prio_current     = 0;
+    tos_state.intr_level      = 0;
+    tos_state.schedule_enable = false;
+    tos_state.sys_running     = false;
+    tos_state.sys_ticks       = 0;
+    tos_state.task_number     = 0;
+    tos_state.task_id_next    = 0;
+#if TOS_CPU_USAGE_ENABLE
+    tos_state.cycle_stamp = 0;
+    tos_state.isr_cycles  = 0;
+#endif
+
+    // init ready_list, waiting_list, all_list
+    memset(tos_state.ready_task_prio_mask, 0, sizeof(tos_state.ready_task_prio_mask));
+#if TOS_PRIO_GROUP_NUM > 1
+    tos_state.ready_task_prio_group = 0;
+#endif
+    for (index = 0; index <= TOS_MAX_PRIO_NUM_USED; index++) {
+        tos_queue_init(&tos_state.ready_task_list[index]);
+    }
+    tos_queue_init(&tos_state.waiting_task_list);
+    tos_queue_init(&tos_state.all_task_list);
+#if TOS_TASK_DYNAMIC_ENABLE
+    tos_queue_init(&tos_state.zombie_task_list);
+#endif
+
+    // all tcb are free
+    tos_pool_reset(&tos_tcb_pool);
+
+    // create idle task
+    taskAttr.task_name       = "idle_task";
+    taskAttr.task_wait_time  = 0;
+    taskAttr.task_time_slice = 0;
+    taskAttr.task_period     = 0;
+    taskAttr.task_prio       = 0;   // lowest prio
+    taskAttr.task_stack_size = TOS_IDLETASK_STACK_SIZE;
+    taskAttr.task_stack      = tos_idle_task_stack;
+
+    if (tos_task_create(tos_idle_task_proc, nullptr, &taskAttr) == nullptr) {
+        tos_error("idle task create error!");
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief start tos
+ * @note called after tos_init
+ */
+void tos_start(void) {
+    tos_task_prio_switch_to = tos_get_highest_prio();
+    tos_task_switch_to      = get_task_by_ready_pending_link(tos_state.ready_task_list[tos_task_prio_switch_to].next);
+
+    tos_state.sys_running     = true;
+    tos_state.schedule_enable = true;
+
+    tos_task_switch_to->task_switch_cnt++;
+
+    tos_sys_clock_init();   // tos sys tick clock init
+#if TOS_CPU_USAGE_ENABLE || TOS_TRACE_ENABLE
+    tos_cpu_cycle_init();
+#endif
+
+    // CM3 use PendSV IRQ to switch task, use a flag to tell the PendSV ISR if it need to store the context
+    // for other platform, call the `switch_to` asm code derectly
+    tos_task_switch_first();
+}
+
+
+/**
+ * @brief start tos clock
+ * @note much better to call it in init_task
+ */
+void tos_clock_start(void) {
+    tos_sys_clock_init();   // tos sys tick clock init
+}
+
+
+/**
+ * @brief called at begin of ISR
+ *
+ * @note every ISR which calls kernel api must call it. it stops there if prio of the ISR is higher than
+ *       TOS_IRQ_MASK_PRIO, which is not masked by kernel critical section
+ */
+void tos_enter_isr(void) {
+    tos_use_critical_section();
+
+    // ISR above TOS_IRQ_MASK_PRIO would break critical sections of kernel
+    if (!tos_cpu_isr_managed()) {
+        tos_error("kernel api called in ISR with prio higher than TOS_IRQ_MASK_PRIO");
+        while (1) {
+            ;
+        }
+    }
+
+    tos_enter_critical_section();
+    if (tos_state.sys_running) {
+#if TOS_CPU_USAGE_ENABLE
+        tos_cpu_usage_update();   // cycles before are counted to the interrupted task or outer ISR
+#endif
+        if (tos_state.intr_level < 255) {
+            tos_state.intr_level++;
+        }
+        tos_trace(TOS_TRACE_ISR_ENTER, tos_task_current, tos_state.intr_level);
+    }
+
+    tos_leave_critical_section();
+}
+
+
+/**
+ * @brief called at end of ISR
+ *
+ */
+void tos_exit_isr(void) {
+    tos_use_critical_section();
+
+    if (tos_state.sys_running == true) {
+        tos_enter_critical_section();
+
+#if TOS_CPU_USAGE_ENABLE
+        tos_cpu_usage_update();   // cycles before are counted to ISR
+#endif
+        if (tos_state.intr_level > 0)
+            tos_state.intr_level--;
+        tos_trace(TOS_TRACE_ISR_EXIT, tos_task_current, tos_state.intr_level);
+
+        // schedule when all intr exit
+        if (tos_state.intr_level == 0 && tos_state.schedule_enable == true) {
+            tos_task_prio_switch_to = tos_get_highest_prio();
+            tos_task_switch_to = get_task_by_ready_pending_link(tos_state.ready_task_list[tos_task_prio_switch_to].next);
+
+            if (tos_task_switch_to != tos_task_current) {
+                tos_task_switch_to->task_switch_cnt++;
+                tos_task_switch_intr();
+            }
+        }
+
+        tos_leave_critical_section();
+    }
+}
+
+
+/**
+ * @brief enable schedule
+ *
+ */
+void tos_schedule_enable(void) {
+    tos_use_critical_section();
+
+    tos_enter_critical_section();
+
+    tos_state.schedule_enable = true;
+
+    tos_leave_critical_section();
+}
+
+
+/**
+ * @brief disable schedule
+ *
+ */
+void tos_schedule_disable(void) {
+    tos_use_critical_section();
+
+    tos_enter_critical_section();
+
+    tos_state.schedule_enable = false;
+
+    tos_leave_critical_section();
+}
+
+
+/**
+ * @brief create new task
+ *
+ * @param proc task proc
+ * @param args args of task proc
+ * @param attr task attr
+ * @return tos_task_t* task hdl, return nullptr when failed
+ */
+tos_task_t* tos_task_create(tos_task_proc_t proc, void* args, tos_task_attr_t* attr) {
+    tos_task_t* task_hdl;
+    tos_use_critical_section();
+
+    if (attr == nullptr || attr->task_stack == nullptr || attr->task_prio > TOS_MAX_PRIO_NUM_USED) {
+        return nullptr;
+    }
+
+    tos_enter_critical_section();
+    if (tos_state.intr_level > 0) {
+        tos_leave_critical_section();
+        return nullptr;
+    }
+
+    tos_leave_critical_section();
+
+    task_hdl = tos_get_free_tcb();
+
+    if (task_hdl == nullptr) {
+        tos_error("try to create task(%s, id=%d) error", attr->task_name, tos_state.task_id_next);
+        return nullptr;
+    }
+
+#if TOS_TASK_DYNAMIC_ENABLE
+    task_hdl->task_dynamic = false;
+#endif
+    tos_task_start(task_hdl, proc, args, attr);
+
+    return task_hdl;
+}
+
+
+#if TOS_TASK_DYNAMIC_ENABLE
+/**
+ * @brief create new task, tcb and stack are allocated from heap
+ *
+ * @param proc task proc
+ * @param args args of task proc
+ * @param attr task attr, task_stack is ignored, task_stack_size bytes of stack are allocated
+ * @return tos_task_t* task hdl, return nullptr when failed
+ * @note number of dynamic tasks is not limited by TOS_MAX_TASK_NUM_USED. memory is freed when the task is
+ *       deleted or its proc returns
+ */
+tos_task_t* tos_task_create_dynamic(tos_task_proc_t proc, void* args, tos_task_attr_t* attr) {
+    tos_task_t*     task_hdl;
+    tos_task_attr_t task_attr;
+    uint32_t        tcb_size = (sizeof(tos_task_t) + 7u) & ~7u;   // stack follows tcb, 8 bytes align
+    tos_use_critical_section();
+
+    if (attr == nullptr || attr->task_stack_size < sizeof(tos_stack_t) || attr->task_prio > TOS_MAX_PRIO_NUM_USED) {
+        return nullptr;
+    }
+
+    tos_enter_critical_section();
+    if (tos_state.intr_level > 0) {
+        tos_leave_critical_section();
+        return nullptr;
+    }
+
+    task_hdl = (tos_task_t*)TOS_TASK_MALLOC(tcb_size + attr->task_stack_size);
+
+    tos_leave_critical_section();
+
+    if (task_hdl == nullptr) {
+        tos_error("no memory for task(%s, %d Bytes stack)", attr->task_name, attr->task_stack_size);
+        return nullptr;
+    }
+
+    memset(task_hdl, 0, sizeof(tos_task_t));
+    task_hdl->task_dynamic = true;
+
+    task_attr            = *attr;
+    task_attr.task_stack = (tos_stack_t*)((uint8_t*)task_hdl + tcb_size);
+    tos_task_start(task_hdl, proc, args, &task_attr);
+
+    return task_hdl;
+}
+#endif
+
+
+/**
+ * @brief delete task
+ *
+ * @param task_hdl
+ */
+void tos_task_delete(tos_task_t* task_hdl) {
+    bool woken;
+    tos_use_critical_section();
+
+    // if (tos_state.intr_level > 0 || task_hdl == tos_task_current)
+    if (tos_state.intr_level > 0) {
+        return;
+    }
+
+    tos_enter_critical_section();
+
+    tos_trace(TOS_TRACE_TASK_DELETE, task_hdl, 0);
+
+    // remove task from read_pending list
+    if (task_hdl->task_pend_waitq != nullptr) {
+        tos_waitq_remove(task_hdl);
+    }
+    woken = tos_mutex_task_delete(task_hdl);   // release owned mutexes
+    tos_ready_list_remove(task_hdl);
+    // remove task from waiting list
+    tos_waiting_list_remove(task_hdl);
+
+    // remove task from all_task list
+    tos_state.task_number--;
+    tos_queue_remove(&task_hdl->all_free_link);
+
+    task_hdl->task_state = TOS_TASK_STATE_STOP;
+
+#if TOS_TASK_DYNAMIC_ENABLE
+    if (task_hdl->task_dynamic) {
+        if (task_hdl == tos_task_current) {
+            // still running on the stack, freed by idle task after switched out
+            tos_queue_insert(&tos_state.zombie_task_list, &task_hdl->all_free_link);
+        } else {
+            TOS_TASK_FREE(task_hdl);
+        }
+    } else
+#endif
+    {
+        // put tcb back to pool
+        tos_pool_put(&tos_tcb_pool, task_hdl);
+    }
+
+    if (task_hdl == tos_task_current) {
+        // a deleted task can not hold the schedule lock, switch out and never come back
+        tos_state.schedule_enable = true;
+        tos_schedule();
+    }
+
+    tos_leave_critical_section();
+
+    // new owner of a released mutex may have higher prio
+    if (woken) {
+        tos_schedule();
+    }
+}
+
+
+/**
+ * @brief delete current task, called when task proc returns
+ *
+ * @note never returns
+ */
+void tos_task_exit(void) {
+    tos_task_delete(tos_get_current_task());
+
+    while (true) {
+        ;
+    }
+}
+
+
+/**
+ * @brief
+ *
+ * @param task_hdl
+ * @param prio
+ * @return int32_t old prio when succeed, -1 when fail
+ */
+int32_t tos_set_task_prio(tos_task_t* task_hdl, uint32_t prio) {
+    tos_use_critical_section();
+
+    uint8_t prio_old = task_hdl->task_base_prio;
+
+    if (prio == prio_old || prio > TOS_MAX_PRIO_NUM_USED || task_hdl->task_state == TOS_TASK_STATE_STOP) {
+        return -1;
+    }
+
+    tos_enter_critical_section();
+
+    // prio raised by owned mutexes is kept until unlock
+    task_hdl->task_base_prio = prio;
+    tos_mutex_prio_update(task_hdl);
+
+    tos_leave_critical_section();
+
+    tos_schedule();
+
+    return prio_old;
+}
+
+
+/**
+ * @brief
+ *
+ * @param task_hdl
+ * @return int32_t
+ * @note return the running prio, which may be raised by mutex
+ */
+int32_t tos_get_task_prio(tos_task_t* task_hdl) {
+    if (task_hdl == nullptr)
+        return -1;
+
+    return task_hdl->task_prio;
+}
+
+
+/**
+ * @brief get task state
+ *
+ * @param task_hdl
+ * @return tos_task_state_t
+ */
+tos_task_state_t tos_get_task_state(tos_task_t* task_hdl) {
+    if (task_hdl == nullptr)
+        return TOS_TASK_STATE_INVALID;
+
+    return task_hdl->task_state;
+}
+
+
+/**
+ * @brief task sleep some time
+ *
+ * @param nms
+ */
+void tos_task_sleep(uint32_t nms) {
+    if (nms == 0)
+        nms = 1;
+
+    tos_use_critical_section();
+
+    if (tos_state.intr_level > 0) {
+        return;
+    }
+
+    tos_enter_critical_section();
+
+    tos_trace(TOS_TRACE_TASK_SLEEP, tos_task_current, (nms / TOS_TICK_MS > 0xFFFFu) ? 0xFFFFu : nms / TOS_TICK_MS);
+    tos_ready_list_remove(tos_task_current);
+    tos_task_current->task_state = TOS_TASK_STATE_WAITING;
+
+    tos_waiting_list_insert(tos_task_current, nms / TOS_TICK_MS);
+
+    tos_leave_critical_section();
+
+    tos_schedule();
+}
+
+
+/**
+ * @brief sleep until *last_wake + period ticks, drift free for periodic loop
+ *
+ * @param last_wake tick of last release, init by tos_get_sys_ticks() before the loop, updated to the new release
+ * @param period ticks
+ * @note returns at once when the release has passed, counts a deadline miss of the task if it is later than
+ *       the release tick. releases passed before the latest one are skipped and counted as overrun
+ */
+void tos_task_sleep_until(uint32_t* last_wake, uint32_t period) {
+    uint32_t elapsed;
+    uint32_t periods;
+    tos_use_critical_section();
+
+    if (tos_state.intr_level > 0 || last_wake == nullptr || period == 0) {
+        return;
+    }
+
+    tos_enter_critical_section();
+
+    // unsigned diff is right when sys ticks wraps
+    elapsed = tos_state.sys_ticks - *last_wake;
+
+    if (elapsed < period) {
+        *last_wake += period;
+
+        tos_trace(TOS_TRACE_TASK_SLEEP, tos_task_current, (period - elapsed > 0xFFFFu) ? 0xFFFFu : period - elapsed);
+        tos_ready_list_remove(tos_task_current);
+        tos_task_current->task_state = TOS_TASK_STATE_WAITING;
+
+        tos_waiting_list_insert(tos_task_current, period - elapsed);
+
+        tos_leave_critical_section();
+
+        tos_schedule();
+        return;
+    }
+
+    // release passed, run at once from the latest passed release
+    if (elapsed > period) {
+        tos_task_current->task_deadline_miss++;
+        tos_trace(TOS_TRACE_TASK_DEADLINE, tos_task_current,
+                  (elapsed - period > 0xFFFFu) ? 0xFFFFu : elapsed - period);
+    }
+    periods = elapsed / period;
+    tos_task_current->task_overrun += periods - 1;
+    *last_wake += periods * period;
+
+    tos_leave_critical_section();
+}
+
+
+/**
+ * @brief sleep until the next release of current task, which is created with task_period
+ *
+ * @note same as tos_task_sleep_until with the release and period kept in task, returns at once if task is not
+ *       periodic
+ */
+void tos_task_period_wait(void) {
+    tos_task_sleep_until(&tos_task_current->task_release, tos_task_current->task_period);
+}
+
+
+/**
+ * @brief task yield
+ *
+ */
+void tos_task_yield(void) {
+    tos_use_critical_section();
+    // important to use critical_section
+    // or maybe conflict with systick ISR
+
+    tos_enter_critical_section();
+#if TOS_TIME_SLICE_ENABLE
+    tos_task_current->task_time_slice_left = tos_task_current->task_time_slice;
+#endif
+    // remove from ready list, then add into list tail
+    tos_queue_remove(&tos_task_current->ready_pending_link);
+    tos_queue_insert(&tos_state.ready_task_list[tos_task_current->task_prio], &tos_task_current->ready_pending_link);
+    tos_leave_critical_section();
+
+    tos_schedule();
+}
+
+
+/**
+ * @brief
+ *
+ * @return true
+ * @return false
+ */
+bool tos_running(void) {
+    return tos_state.sys_running;
+}
+
+
+/**
+ * @brief get ticks since tos start
+ *
+ * @return uint32_t
+ */
+uint32_t tos_get_sys_ticks(void) {
+    return tos_state.sys_ticks;
+}
+
+
+/**
+ * @brief get information of all tasks (idle task included)
+ *
+ * @param info array to store the information
+ * @param info_num size of info array
+ * @return uint32_t number of tasks stored in info
+ */
+uint32_t tos_task_info_get(tos_task_info_t* info, uint32_t info_num) {
+    tos_use_critical_section();
+    tos_queue_node_t* link;
+    tos_task_t*       task_hdl;
+    uint32_t          num = 0;
+
+    if (info == nullptr)
+        return 0;
+
+    tos_enter_critical_section();
+#if TOS_CPU_USAGE_ENABLE
+    if (tos_state.sys_running)
+        tos_cpu_usage_update();   // count cycles of the running task until now
+#endif
+    for (link = tos_state.all_task_list.next; link != &tos_state.all_task_list && num < info_num; link = link->next) {
+        task_hdl                  = get_task_by_all_free_link(link);
+        info[num].task_hdl        = task_hdl;
+        info[num].task_name       = task_hdl->task_name;
+        info[num].task_id         = task_hdl->task_id;
+        info[num].task_prio       = task_hdl->task_prio;
+        info[num].task_base_prio  = task_hdl->task_base_prio;
+        info[num].task_state      = task_hdl->task_state;
+        info[num].task_switch_cnt = task_hdl->task_switch_cnt;
+#if TOS_CPU_USAGE_ENABLE
+        info[num].task_run_cycles = task_hdl->task_run_cycles;
+#else
+        info[num].task_run_cycles = 0;
+#endif
+        info[num].task_stack_size = task_hdl->task_stk_size;
+#if TOS_STACK_CHECK_ENABLE
+        info[num].task_stack_peak     = task_hdl->task_stk_peak;
+        info[num].task_stack_overflow = task_hdl->task_stk_overflow;
+#else
+        info[num].task_stack_peak     = 0;
+        info[num].task_stack_overflow = false;
+#endif
+        info[num].task_period        = task_hdl->task_period;
+        info[num].task_deadline_miss = task_hdl->task_deadline_miss;
+        info[num].task_overrun       = task_hdl->task_overrun;
+        num++;
+    }
+    tos_leave_critical_section();
+
+    return num;
+}
+
+
+/**
+ * @brief get cpu cycles spent in ISR (between tos_enter_isr and tos_exit_isr)
+ *
+ * @return uint64_t 0 if TOS_CPU_USAGE_ENABLE is 0
+ */
+uint64_t tos_isr_cycles_get(void) {
+#if TOS_CPU_USAGE_ENABLE
+    tos_use_critical_section();
+    uint64_t cycles;
+
+    tos_enter_critical_section();
+    cycles = tos_state.isr_cycles;
+    tos_leave_critical_section();
+
+    return cycles;
+#else
+    return 0;
+#endif
+}
+
+
+/**
+ * @brief called by port just before switch to tos_task_switch_to
+ *
+ * @note tos_task_current is still the old task (nullptr for the first switch), called with irq disabled
+ */
+void tos_task_switch_hook(void) {
+#if TOS_CPU_USAGE_ENABLE
+    tos_cpu_usage_update();
+#endif
+    tos_trace(TOS_TRACE_TASK_SWITCH, tos_task_current, tos_task_switch_to->task_id);
+}
+
+
+#if TOS_CPU_USAGE_ENABLE
+/**
+ * @brief count cycles since last update to the running ISR or task
+ *
+ * @note called in critical section. the counter wraps at 2^32 cycles, which is much longer than a tick,
+ *       and tick ISR updates it every tick
+ */
+static void tos_cpu_usage_update(void) {
+    uint32_t now = tos_cpu_cycle_get();
+
+    if (tos_state.intr_level > 0) {
+        tos_state.isr_cycles += (uint32_t)(now - tos_state.cycle_stamp);
+    } else if (tos_task_current != nullptr) {
+        tos_task_current->task_run_cycles += (uint32_t)(now - tos_state.cycle_stamp);
+    }
+    tos_state.cycle_stamp = now;
+}
+#endif
+
+
+/**
+ * @brief
+ *
+ * @return tos_task_t*
+ */
+tos_task_t* tos_get_current_task(void) {
+    return tos_task_current;
+}
+
+
+/**
+ * @brief
+ * @note called by cpu timer ISR
+ */
+void tos_time_tick(void) {
+    tos_use_critical_section();
+
+    tos_state.sys_ticks++;
+    tos_enter_critical_section();
+
+#if TOS_TIME_SLICE_ENABLE
+    tos_time_slice_tick();
+#endif
+    tos_time_pass(1);
+
+    tos_leave_critical_section();
+}
+
+
+#if TOS_TIME_SLICE_ENABLE
+/**
+ * @brief count down time slice of current task, move it to the tail of ready list when used up
+ * @note called in critical section
+ */
+static void tos_time_slice_tick(void) {
+    tos_task_t*       task_hdl = tos_task_current;
+    tos_queue_node_t* ready_list;
+
+    if (task_hdl == nullptr || task_hdl->task_state != TOS_TASK_STATE_READY) {
+        return;
+    }
+    if (--task_hdl->task_time_slice_left != 0) {
+        return;
+    }
+    task_hdl->task_time_slice_left = task_hdl->task_time_slice;
+
+    // other tasks with same prio are ready, switch to the next one when exit ISR
+    ready_list = &tos_state.ready_task_list[task_hdl->task_prio];
+    if (ready_list->next == &task_hdl->ready_pending_link && task_hdl->ready_pending_link.next != ready_list) {
+        tos_queue_remove(&task_hdl->ready_pending_link);
+        tos_queue_insert(ready_list, &task_hdl->ready_pending_link);
+    }
+}
+#endif
+
+
+/**
+ * @brief count down the waiting list, wake up tasks whose time is up, advance the timer wheel
+ *
+ * @param ticks ticks passed, no more than the wait time of the head task
+ * @note called in critical section
+ */
+static void tos_time_pass(uint32_t ticks) {
+    tos_queue_node_t* list_node;
+    tos_task_t*       task_hdl;
+
+    // waiting list is a delta queue, only the head counts down
+    list_node = tos_state.waiting_task_list.next;
+    if (list_node != &tos_state.waiting_task_list) {
+        task_hdl = get_task_by_waiting_link(list_node);
+        task_hdl->task_wait_time -= (ticks < task_hdl->task_wait_time) ? ticks : task_hdl->task_wait_time;
+    }
+
+    // wake up the head tasks whose time is up
+    while (list_node != &tos_state.waiting_task_list) {
+        task_hdl = get_task_by_waiting_link(list_node);
+        if (task_hdl->task_wait_time != 0) {
+            break;
+        }
+        list_node = list_node->next;   // NOTICE: list link will be changed below
+
+        // move the task to ready list
+        tos_trace(TOS_TRACE_TASK_WAKE, task_hdl, 0);
+        tos_waitq_remove(task_hdl);   // the task may pend in wait queue of a kernel object
+        tos_ready_list_insert(task_hdl);
+
+        tos_queue_remove(&task_hdl->waiting_link);
+        tos_queue_init(&task_hdl->waiting_link);   // make list_node->next==list_node
+    }
+
+#if TOS_TIMER_ENABLE
+    tos_timer_tick(ticks);
+#endif
+}
+
+
+/**
+ * @brief insert task into tail of ready list, mark task ready
+ *
+ * @param task_hdl
+ * @note called in critical section, task should not be in any ready or pending list
+ */
+void tos_ready_list_insert(tos_task_t* task_hdl) {
+    tos_queue_insert(&tos_state.ready_task_list[task_hdl->task_prio], &task_hdl->ready_pending_link);
+
+    tos_state.ready_task_prio_mask[tos_prio_group(task_hdl->task_prio)] |= task_hdl->task_prio_mask;
+#if TOS_PRIO_GROUP_NUM > 1
+    tos_state.ready_task_prio_group |= tos_prio_mask(tos_prio_group(task_hdl->task_prio));
+#endif
+
+    task_hdl->task_state = TOS_TASK_STATE_READY;
+#if TOS_TIME_SLICE_ENABLE
+    task_hdl->task_time_slice_left = task_hdl->task_time_slice;
+#endif
+    tos_trace(TOS_TRACE_TASK_READY, task_hdl, task_hdl->task_prio);
+}
+
+
+/**
+ * @brief remove task from ready or pending list
+ *
+ * @param task_hdl
+ * @note called in critical section
+ */
+void tos_ready_list_remove(tos_task_t* task_hdl) {
+    uint32_t group = tos_prio_group(task_hdl->task_prio);
+
+    tos_queue_remove(&task_hdl->ready_pending_link);
+    tos_queue_init(&task_hdl->ready_pending_link);
+
+    if (tos_queue_is_empty(&tos_state.ready_task_list[task_hdl->task_prio])) {
+        tos_state.ready_task_prio_mask[group] &= ~task_hdl->task_prio_mask;
+#if TOS_PRIO_GROUP_NUM > 1
+        if (tos_state.ready_task_prio_mask[group] == 0) {
+            tos_state.ready_task_prio_group &= ~tos_prio_mask(group);
+        }
+#endif
+    }
+}
+
+
+/**
+ * @brief change running prio of task
+ *
+ * @param task_hdl
+ * @param prio
+ * @note called in critical section, task_base_prio is not changed
+ */
+void tos_task_prio_change(tos_task_t* task_hdl, uint8_t prio) {
+    if (prio == task_hdl->task_prio) {
+        return;
+    }
+    tos_trace(TOS_TRACE_TASK_PRIO, task_hdl, prio);
+
+    if (task_hdl->task_state == TOS_TASK_STATE_RUNNING || task_hdl->task_state == TOS_TASK_STATE_READY) {
+        // running or ready task, move to ready list of new prio
+        tos_ready_list_remove(task_hdl);
+        task_hdl->task_prio      = prio;
+        task_hdl->task_prio_mask = tos_prio_mask(prio);
+        tos_ready_list_insert(task_hdl);
+    } else {
+        // sleep or block task, in waiting or pending list, modify prio immediately, keep wait queue sorted
+        task_hdl->task_prio      = prio;
+        task_hdl->task_prio_mask = tos_prio_mask(prio);
+        tos_waitq_reposition(task_hdl);
+    }
+
+    if (task_hdl == tos_task_current) {
+        tos_task_prio_current = task_hdl->task_prio;
+    }
+}
+
+
+/**
+ * @brief insert task into time waiting list
+ *
+ * @param task_hdl
+ * @param ticks ticks to wait
+ * @note called in critical section.
+ *       the waiting list is sorted by wake up time, task_wait_time of each node is the delta to the previous node
+ */
+void tos_waiting_list_insert(tos_task_t* task_hdl, uint32_t ticks) {
+    tos_queue_node_t* list_node;
+    tos_task_t*       next_task;
+
+    if (ticks == TOS_TIME_WAIT_INFINITY) {
+        return;   // never wake up by time
+    }
+    if (ticks == 0) {
+        ticks = 1;   // wait one tick at least
+    }
+
+    // find the first task which wakes up later, tasks with same wake up time keep FIFO order
+    for (list_node = tos_state.waiting_task_list.next; list_node != &tos_state.waiting_task_list;
+         list_node = list_node->next) {
+        next_task = get_task_by_waiting_link(list_node);
+        if (ticks < next_task->task_wait_time) {
+            next_task->task_wait_time -= ticks;
+            break;
+        }
+        ticks -= next_task->task_wait_time;
+    }
+
+    task_hdl->task_wait_time = ticks;
+    tos_queue_insert(list_node, &task_hdl->waiting_link);   // insert in front of list_node
+}
+
+
+/**
+ * @brief remove task from time waiting list
+ *
+ * @param task_hdl
+ * @note called in critical section. no effect if the task is not in the list
+ */
+void tos_waiting_list_remove(tos_task_t* task_hdl) {
+    if (tos_queue_is_empty(&task_hdl->waiting_link)) {
+        return;
+    }
+
+    // give the left time to the next task
+    if (task_hdl->waiting_link.next != &tos_state.waiting_task_list) {
+        get_task_by_waiting_link(task_hdl->waiting_link.next)->task_wait_time += task_hdl->task_wait_time;
+    }
+
+    tos_queue_remove(&task_hdl->waiting_link);
+    tos_queue_init(&task_hdl->waiting_link);
+}
+
+
+/**
+ * @brief
+ *
+ */
+void tos_schedule(void) {
+    tos_use_critical_section();
+
+    tos_enter_critical_section();
+
+    if (tos_state.intr_level == 0 && tos_state.schedule_enable == true) {
+        tos_task_prio_switch_to = tos_get_highest_prio();
+        tos_task_switch_to = get_task_by_ready_pending_link(tos_state.ready_task_list[tos_task_prio_switch_to].next);
+
+        if (tos_task_switch_to != tos_task_current) {
+            tos_task_switch_to->task_switch_cnt++;
+            tos_task_switch();
+        }
+    }
+
+    tos_leave_critical_section();
+}
+
+
+/**
+ * @brief init stack and tcb of new task, make it ready
+ *
+ * @param task_hdl tcb from free list or heap
+ * @param proc task proc
+ * @param args args of task proc
+ * @param attr task attr, task_stack is valid
+ */
+static void tos_task_start(tos_task_t* task_hdl, tos_task_proc_t proc, void* args, tos_task_attr_t* attr) {
+    tos_stack_t* task_stack_ptr;
+    tos_stack_t* stack_end = &attr->task_stack[(attr->task_stack_size / sizeof(tos_stack_t))];
+
+    log_printk("create %15s: [%p, %p) %4d Bytes.\n", attr->task_name, attr->task_stack, stack_end,
+               attr->task_stack_size);
+
+#if TOS_STACK_CHECK_ENABLE
+    // paint whole stack, the words never written show the unused space
+    for (tos_stack_t* stk = attr->task_stack; stk < stack_end; stk++) {
+        *stk = TOS_STACK_FILL_PATTERN;
+    }
+#endif
+
+    task_stack_ptr = tos_task_stack_frame_init(proc, args, stack_end - 1);
+    tos_task_tcb_init(task_hdl, attr, task_stack_ptr);
+
+    if (tos_state.sys_running) {
+        tos_schedule();
+    }
+}
+
+
+/**
+ * @brief init task TCB
+ *
+ * @param task_hdl
+ * @param attr taskattr
+ * @param task_stack_ptr ptr to task stack
+ */
+static void tos_task_tcb_init(tos_task_t* task_hdl, tos_task_attr_t* attr, tos_stack_t* task_stack_ptr) {
+    tos_use_critical_section();
+
+    // task stack: stack is high addr to low addr
+    task_hdl->task_stk_ptr  = task_stack_ptr;
+    task_hdl->task_stk_base = &attr->task_stack[(attr->task_stack_size / sizeof(tos_stack_t)) - 1];
+    task_hdl->task_stk_size = attr->task_stack_size;
+    task_hdl->task_stk_top  = attr->task_stack - 1;
+
+    // schdule and other addr
+    task_hdl->task_prio        = attr->task_prio;
+    task_hdl->task_base_prio   = attr->task_prio;
+    task_hdl->task_pend_waitq  = nullptr;
+    task_hdl->task_pend_mutex  = nullptr;
+    task_hdl->task_pend_status = TOS_PEND_OK;
+    task_hdl->task_pend_option = 0;
+    task_hdl->task_pend_value  = 0;
+    task_hdl->task_pend_data   = nullptr;
+#if TOS_STACK_CHECK_ENABLE
+    task_hdl->task_stk_peak     = 0;
+    task_hdl->task_stk_overflow = false;
+#endif
+    tos_queue_init(&task_hdl->task_mutex_list);
+    task_hdl->task_prio_mask   = tos_prio_mask(attr->task_prio);
+    task_hdl->task_wait_time   = attr->task_wait_time;
+#if TOS_TIME_SLICE_ENABLE
+    task_hdl->task_time_slice = (attr->task_time_slice != 0) ? attr->task_time_slice : TOS_TIME_SLICE_DEFAULT;
+#endif
+    task_hdl->task_period        = attr->task_period;
+    task_hdl->task_release       = tos_state.sys_ticks;
+    task_hdl->task_deadline_miss = 0;
+    task_hdl->task_overrun       = 0;
+
+    task_hdl->task_name        = attr->task_name;
+    task_hdl->task_id          = tos_state.task_id_next;
+    task_hdl->task_switch_cnt  = 0;
+#if TOS_CPU_USAGE_ENABLE
+    task_hdl->task_run_cycles = 0;
+#endif
+
+    // modify global var, enter critical section
+    tos_enter_critical_section();
+
+    tos_trace(TOS_TRACE_TASK_CREATE, task_hdl, task_hdl->task_prio);
+
+    // inset new task tcb to ready list
+    tos_ready_list_insert(task_hdl);
+    tos_queue_init(&task_hdl->waiting_link);
+
+    tos_state.task_number++;
+    tos_state.task_id_next++;
+    tos_queue_insert(&tos_state.all_task_list, &task_hdl->all_free_link);
+
+    tos_leave_critical_section();
+}
+
+
+/**
+ * get a free tcb from tos_tcb_pool
+ *
+ *  @param   void
+ *  @return  hdl of a free tcb, or nullptr
+ *  @see
+ *  @note
+ */
+static tos_task_t* tos_get_free_tcb(void) {
+    tos_task_t* task_hdl;
+    tos_use_critical_section();
+
+    tos_enter_critical_section();
+
+    task_hdl = tos_pool_get(&tos_tcb_pool);
+
+    tos_leave_critical_section();
+
+    return task_hdl;
+}
+
+
+/**
+ * @brief get highest prio of ready tasks
+ *
+ * @return uint32_t
+ * @note idle task is always ready, so the bitmap is never empty
+ */
+static uint32_t tos_get_highest_prio(void) {
+#if TOS_PRIO_GROUP_NUM > 1
+    uint32_t group = 31u - tos_cpu_clz(tos_state.ready_task_prio_group);
+    return (group << 5) + 31u - tos_cpu_clz(tos_state.ready_task_prio_mask[group]);
+#else
+    return 31u - tos_cpu_clz(tos_state.ready_task_prio_mask[0]);
+#endif
+}
+
+
+/**
+ * @brief idle task proc
+ *
+ * @param args
+ */
+static void tos_idle_task_proc(void* args) {
+    while (true) {
+#if TOS_TASK_DYNAMIC_ENABLE
+        tos_task_zombie_free();
+#endif
+#if TOS_STACK_CHECK_ENABLE
+        tos_stack_check();
+#endif
+#if TOS_MEM_IDLE_COMPACT_ENABLE
+        if (tos_mem_compact_wanted()) {
+            tos_mem_compact();
+        }
+#endif
+#if TOS_TICKLESS_ENABLE
+        tos_tickless_idle();
+#endif
+    }
+}
+
+
+#if TOS_TASK_DYNAMIC_ENABLE
+/**
+ * @brief free dynamic tasks which deleted themselves
+ * @note called by idle task, the tasks have been switched out. only idle task removes tasks from zombie list
+ */
+static void tos_task_zombie_free(void) {
+    tos_task_t* task_hdl;
+    tos_use_critical_section();
+
+    while (!tos_queue_is_empty(&tos_state.zombie_task_list)) {
+        tos_enter_critical_section();
+
+        task_hdl = get_task_by_all_free_link(tos_state.zombie_task_list.next);
+        tos_queue_remove(&task_hdl->all_free_link);
+        TOS_TASK_FREE(task_hdl);
+
+        tos_leave_critical_section();
+    }
+}
+#endif
+
+
+#if TOS_STACK_CHECK_ENABLE
+/**
+ * @brief get max used bytes of task stack
+ *
+ * @param task_hdl
+ * @return uint32_t
+ * @note stack grows from high addr to low addr, scan from the lowest word until the pattern is overwritten
+ */
+static uint32_t tos_task_stack_used(tos_task_t* task_hdl) {
+    tos_stack_t* stk = task_hdl->task_stk_top + 1;
+    tos_stack_t* end = task_hdl->task_stk_base + 1;
+
+    while (stk < end && *stk == TOS_STACK_FILL_PATTERN) {
+        stk++;
+    }
+
+    return (uint32_t)(end - stk) * sizeof(tos_stack_t);
+}
+
+
+/**
+ * @brief update stack peak of all tasks and check overflow, every TOS_STACK_CHECK_PERIOD ticks
+ * @note called by idle task. one task is scanned in one critical section to keep irq latency short
+ */
+static void tos_stack_check(void) {
+    static uint32_t   last_ticks = 0;
+    tos_task_t*       task_hdl;
+    tos_queue_node_t* link;
+    uint32_t          used;
+    uint32_t          idx;
+    uint32_t          num;
+    tos_use_critical_section();
+
+    if (tos_state.sys_ticks - last_ticks < TOS_STACK_CHECK_PERIOD) {
+        return;
+    }
+    last_ticks = tos_state.sys_ticks;
+
+    // the task list may be changed when irq is enabled, find the idx-th task from list head again each time.
+    // a task created or deleted meanwhile may be skipped or checked twice
+    for (idx = 0;; idx++) {
+        tos_enter_critical_section();
+
+        link = tos_state.all_task_list.next;
+        for (num = 0; num < idx && link != &tos_state.all_task_list; num++) {
+            link = link->next;
+        }
+        if (link == &tos_state.all_task_list) {
+            tos_leave_critical_section();
+            break;
+        }
+
+        task_hdl = get_task_by_all_free_link(link);
+
+        used = tos_task_stack_used(task_hdl);
+        if (used > task_hdl->task_stk_peak) {
+            task_hdl->task_stk_peak = used;
+        }
+
+        // the saved stack ptr of current task is out of date
+        if (!task_hdl->task_stk_overflow &&
+            (used == task_hdl->task_stk_size ||
+             (task_hdl != tos_task_current && task_hdl->task_stk_ptr <= task_hdl->task_stk_top))) {
+            task_hdl->task_stk_overflow = true;
+            tos_trace(TOS_TRACE_TASK_STACK_OVF, task_hdl, used);
+            tos_error("task %s stack overflow", task_hdl->task_name);
+        }
+
+        tos_leave_critical_section();
+    }
+}
+#endif
+
+
+#if TOS_TICKLESS_ENABLE
+/**
+ * @brief sleep without periodic tick until the next task wakes up
+ * @note called by idle task
+ */
+static void tos_tickless_idle(void) {
+    uint32_t ticks;
+#if TOS_TIMER_ENABLE
+    uint32_t timer_ticks;
+#endif
+    tos_use_critical_section();
+
+    tos_enter_critical_section();
+
+    // some other task is ready
+    if (tos_get_highest_prio() != tos_task_current->task_prio ||
+        tos_state.ready_task_list[tos_task_current->task_prio].next->next !=
+            &tos_state.ready_task_list[tos_task_current->task_prio]) {
+        tos_leave_critical_section();
+        return;
+    }
+
+    // the head of waiting list wakes up first
+    if (tos_queue_is_empty(&tos_state.waiting_task_list)) {
+        ticks = TOS_TIME_WAIT_INFINITY;
+    } else {
+        ticks = get_task_by_waiting_link(tos_state.waiting_task_list.next)->task_wait_time;
+    }
+#if TOS_TIMER_ENABLE
+    // or the timer wheel needs processing first
+    timer_ticks = tos_timer_next_ticks();
+    if (timer_ticks < ticks) {
+        ticks = timer_ticks;
+    }
+#endif
+
+    if (ticks < TOS_TICKLESS_MIN_TICKS) {
+        tos_leave_critical_section();
+        return;
+    }
+
+    // irq which wakes cpu up will be handled after leave critical section
+    ticks = tos_cpu_tickless_sleep(ticks);
+    tos_state.sys_ticks += ticks;
+    tos_time_pass(ticks);
+
+    tos_leave_critical_section();
+
+    tos_schedule();
+}
+#endif
@@ -1,158 +1,261 @@
-
-/**
- * @file tos_core.h
- * @brief tos core and task management module
- *
- */
-
-#ifndef _TOS_CORE_H_
-#define _TOS_CORE_H_
-
-
-#include "tos_cpu.h"
-#include "tos_types.h"
-
-
-#define tos_use_critical_section() uint32_t cpu_primask
-
-// store PRIMASK, close irq
-#define tos_enter_critical_section()                                                                                   \
-    do {                                                                                                               \
-        cpu_primask = tos_irq_diable();                                                                                \
-    } while (0)
-
-// restore PRIMASK
-#define tos_leave_critical_section()                                                                                   \
-    do {                                                                                                               \
-        tos_irq_restore(cpu_primask);                                                                                  \
-    } while (0)
-
-
-typedef struct tos_task_t tos_task_t;
-
-typedef enum {
-    TOS_TASK_STATE_STOP = 0x00,   // origin state
-    TOS_TASK_STATE_RUNNING,       // running now
-    TOS_TASK_STATE_READY,         // ready but not scheduled yet
-    TOS_TASK_STATE_PENDING,       // pending in mutex or sem
-    TOS_TASK_STATE_WAITING,       // sleep for some time
-    TOS_TASK_STATE_INVALID,
-} tos_task_state_t;
-
-typedef struct {
-    tos_stack_t* task_stack;        // begin address of task area (lowest addr mostly, 4B align)
-    uint32_t     task_stack_size;   // n bytes
-    uint8_t      task_prio;
-    uint32_t     task_wait_time;
-    char*        task_name;
-} tos_task_attr_t;
-
-
-/**
- * @brief init variables used by tos
- *
- * @return true
- * @return false
- */
-bool tos_init(void);
-
-/**
- * @brief start tos
- * @note called after tos_init
- */
-void tos_start(void);
-
-/**
- * @brief start tos clock
- * @note much better to call it in init_task
- */
-void tos_clock_start(void);
-
-/**
- * @brief called at begin of ISR
- *
- */
-void tos_enter_isr(void);
-
-/**
- * @brief called at end of ISR
- *
- */
-void tos_exit_isr(void);
-
-/**
- * @brief enable schedule
- *
- */
-void tos_schedule_enable(void);
-
-/**
- * @brief disable schedule
- *
- */
-void tos_schedule_disable(void);
-
-/**
- * @brief create new task
- *
- * @param proc task proc
- * @param args args of task proc
- * @param attr task attr
- * @return tos_task_t* task hdl, return nullptr when failed
- */
-tos_task_t* tos_task_create(tos_task_proc_t proc, void* args, tos_task_attr_t* attr);
-
-/**
- * @brief delete task
- *
- * @param task_hdl
- */
-void tos_task_delete(tos_task_t* task_hdl);
-
-/**
- * @brief
- *
- * @param task_hdl
- * @param prio
- * @return int32_t old prio when succeed, -1 when fail
- */
-int32_t tos_set_task_prio(tos_task_t* task_hdl, uint32_t prio);
-
-/**
- * @brief
- *
- * @param task_hdl
- * @return int32_t
- */
-int32_t tos_get_task_prio(tos_task_t* task_hdl);
-
-/**
- * @brief get task state
- *
- * @param task_hdl
- * @return tos_task_state_t
- */
-tos_task_state_t tos_get_task_state(tos_task_t* task_hdl);
-
-/**
- * @brief task sleep some time
- *
- * @param nms
- */
-void tos_task_sleep(uint32_t nms);
-
-/**
- * @brief task yield
- *
- */
-void tos_task_yield(void);
-
-/**
- * @brief
- *
- * @return true
- * @return false
- */
-bool tos_running(void);
-
-#endif
+
+/**
+ * @file tos_core.h
+ * @brief tos core and task management module
+ *
+ */
+
+#ifndef _TOS_CORE_H_
+#define _TOS_CORE_H_
+
+
+#include "tos_cpu.h"
+#include "tos_types.h"
+
+
+#define tos_use_critical_section() uint32_t cpu_primask
+
+#if TOS_IRQ_MASK_PRIO
+// store BASEPRI, mask irq with prio value >= TOS_IRQ_MASK_PRIO
+#define tos_enter_critical_section()                                                                                   \
+    do {                                                                                                               \
+        cpu_primask = tos_irq_mask(TOS_IRQ_MASK_PRIO);                                                                 \
+    } while (0)
+
+// restore BASEPRI
+#define tos_leave_critical_section()                                                                                   \
+    do {                                                                                                               \
+        tos_irq_unmask(cpu_primask);                                                                                   \
+    } while (0)
+#else
+// store PRIMASK, close irq
+#define tos_enter_critical_section()                                                                                   \
+    do {                                                                                                               \
+        cpu_primask = tos_irq_diable();                                                                                \
+    } while (0)
+
+// restore PRIMASK
+#define tos_leave_critical_section()                                                                                   \
+    do {                                                                                                               \
+        tos_irq_restore(cpu_primask);                                                                                  \
+    } while (0)
+#endif
+
+
+typedef struct tos_task_t tos_task_t;
+
+typedef enum {
+    TOS_TASK_STATE_STOP = 0x00,   // origin state
+    TOS_TASK_STATE_RUNNING,       // running now
+    TOS_TASK_STATE_READY,         // ready but not scheduled yet
+    TOS_TASK_STATE_PENDING,       // pending in mutex or sem
+    TOS_TASK_STATE_WAITING,       // sleep for some time
+    TOS_TASK_STATE_INVALID,
+} tos_task_state_t;
+
+typedef struct {
+    tos_stack_t* task_stack;        // begin address of task area (lowest addr mostly, 4B align)
+    uint32_t     task_stack_size;   // n bytes
+    uint8_t      task_prio;
+    uint32_t     task_wait_time;
+    uint32_t     task_time_slice;   // ticks, 0 for TOS_TIME_SLICE_DEFAULT, no effect if time slice disabled
+    uint32_t     task_period;       // ticks, 0 for not periodic. released at create and every period after
+    char*        task_name;
+} tos_task_attr_t;
+
+typedef struct {
+    tos_task_t*      task_hdl;
+    char*            task_name;
+    uint32_t         task_id;
+    uint8_t          task_prio;         // running prio
+    uint8_t          task_base_prio;    // prio set by user
+    tos_task_state_t task_state;
+    uint32_t         task_switch_cnt;
+    uint64_t         task_run_cycles;   // 0 if TOS_CPU_USAGE_ENABLE is 0
+    uint32_t         task_stack_size;   // bytes
+    uint32_t         task_stack_peak;   // max used bytes until last stack check, 0 if TOS_STACK_CHECK_ENABLE is 0
+    bool             task_stack_overflow;
+    uint32_t         task_period;          // ticks, 0 if not periodic
+    uint32_t         task_deadline_miss;   // periods finished after the next release
+    uint32_t         task_overrun;         // releases skipped because the task was too late
+} tos_task_info_t;
+
+
+/**
+ * @brief init variables used by tos
+ *
+ * @return true
+ * @return false
+ */
+bool tos_init(void);
+
+/**
+ * @brief start tos
+ * @note called after tos_init
+ */
+void tos_start(void);
+
+/**
+ * @brief start tos clock
+ * @note much better to call it in init_task
+ */
+void tos_clock_start(void);
+
+/**
+ * @brief called at begin of ISR
+ *
+ * @note every ISR which calls kernel api must call it. it stops there if prio of the ISR is higher than
+ *       TOS_IRQ_MASK_PRIO, which is not masked by kernel critical section
+ */
+void tos_enter_isr(void);
+
+/**
+ * @brief called at end of ISR
+ *
+ */
+void tos_exit_isr(void);
+
+/**
+ * @brief enable schedule
+ *
+ */
+void tos_schedule_enable(void);
+
+/**
+ * @brief disable schedule
+ *
+ */
+void tos_schedule_disable(void);
+
+/**
+ * @brief create new task
+ *
+ * @param proc task proc
+ * @param args args of task proc
+ * @param attr task attr
+ * @return tos_task_t* task hdl, return nullptr when failed
+ */
+tos_task_t* tos_task_create(tos_task_proc_t proc, void* args, tos_task_attr_t* attr);
+
+#if TOS_TASK_DYNAMIC_ENABLE
+/**
+ * @brief create new task, tcb and stack are allocated from heap
+ *
+ * @param proc task proc
+ * @param args args of task proc
+ * @param attr task attr, task_stack is ignored, task_stack_size bytes of stack are allocated
+ * @return tos_task_t* task hdl, return nullptr when failed
+ * @note number of dynamic tasks is not limited by TOS_MAX_TASK_NUM_USED. memory is freed when the task is
+ *       deleted or its proc returns
+ */
+tos_task_t* tos_task_create_dynamic(tos_task_proc_t proc, void* args, tos_task_attr_t* attr);
+#endif
+
+/**
+ * @brief delete task
+ *
+ * @param task_hdl
+ * @note deleting current task switches to other task and never returns. memory of a dynamic task deleting
+ *       itself is freed later by idle task. mutexes owned by the task are released, each is given to its first
+ *       pending task, so a task returning from its proc with a mutex locked does not block others. a task deleted
+ *       inside tos_mutex_lock or tos_mutex_unlock of a mutex without protocol, between the lock state and the
+ *       owner being written, may leave the mutex locked
+ */
+void tos_task_delete(tos_task_t* task_hdl);
+
+/**
+ * @brief delete current task, called when task proc returns
+ *
+ * @note never returns
+ */
+void tos_task_exit(void);
+
+/**
+ * @brief
+ *
+ * @param task_hdl
+ * @param prio
+ * @return int32_t old prio when succeed, -1 when fail
+ */
+int32_t tos_set_task_prio(tos_task_t* task_hdl, uint32_t prio);
+
+/**
+ * @brief
+ *
+ * @param task_hdl
+ * @return int32_t
+ */
+int32_t tos_get_task_prio(tos_task_t* task_hdl);
+
+/**
+ * @brief get task state
+ *
+ * @param task_hdl
+ * @return tos_task_state_t
+ */
+tos_task_state_t tos_get_task_state(tos_task_t* task_hdl);
+
+/**
+ * @brief task sleep some time
+ *
+ * @param nms
+ */
+void tos_task_sleep(uint32_t nms);
+
+/**
+ * @brief sleep until *last_wake + period ticks, drift free for periodic loop
+ *
+ * @param last_wake tick of last release, init by tos_get_sys_ticks() before the loop, updated to the new release
+ * @param period ticks
+ * @note returns at once when the release has passed, counts a deadline miss of the task if it is later than
+ *       the release tick. releases passed before the latest one are skipped and counted as overrun
+ */
+void tos_task_sleep_until(uint32_t* last_wake, uint32_t period);
+
+/**
+ * @brief sleep until the next release of current task, which is created with task_period
+ *
+ * @note same as tos_task_sleep_until with the release and period kept in task, returns at once if task is not
+ *       periodic
+ */
+void tos_task_period_wait(void);
+
+/**
+ * @brief task yield
+ *
+ */
+void tos_task_yield(void);
+
+/**
+ * @brief
+ *
+ * @return true
+ * @return false
+ */
+bool tos_running(void);
+
+/**
+ * @brief get ticks since tos start
+ *
+ * @return uint32_t
+ */
+uint32_t tos_get_sys_ticks(void);
+
+/**
+ * @brief get information of all tasks (idle task included)
+ *
+ * @param info array to store the information
+ * @param info_num size of info array
+ * @return uint32_t number of tasks stored in info
+ */
+uint32_t tos_task_info_get(tos_task_info_t* info, uint32_t info_num);
+
+/**
+ * @brief get cpu cycles spent in ISR (between tos_enter_isr and tos_exit_isr)
+ *
+ * @return uint64_t 0 if TOS_CPU_USAGE_ENABLE is 0
+ * @note cpu usage of a task is task_run_cycles / (sum of task_run_cycles of all tasks + isr cycles)
+ */
+uint64_t tos_isr_cycles_get(void);
+
+#endif
@@ -1,77 +1,217 @@
-/**
- * @file tos_core_.h
- * @brief tos core and task management module
- * @note private, not for user
- */
-
-#ifndef _TOS_CORE__H_
-#define _TOS_CORE__H_
-
-
-#include "tos_config.h"
-#include "tos_core.h"
-#include "tos_utils.h"
-
-
-#define get_task_by_ready_pending_link(link)                                                                           \
-    ((tos_task_t*)((uint8_t*)(link) - (uint32_t) & ((tos_task_t*)0)->ready_pending_link))
-#define get_task_by_waiting_link(link)  ((tos_task_t*)((uint8_t*)(link) - (uint32_t) & ((tos_task_t*)0)->waiting_link))
-#define get_task_by_all_free_link(link) ((tos_task_t*)((uint8_t*)(link) - (uint32_t) & ((tos_task_t*)0)->all_free_link))
-
-
-struct tos_task_t {
-    tos_stack_t*     task_stk_ptr;         // stack ptr
-    tos_stack_t*     task_stk_base;        // stack base addr (highest mostly)
-    tos_stack_t*     task_stk_top;         // stack top addr (next addr after stack space)
-    uint32_t         task_stk_size;        // stack size
-    tos_queue_node_t ready_pending_link;   // link to Ready list or Pending list
-    tos_queue_node_t waiting_link;         // link to time Waiting list
-    tos_queue_node_t all_free_link;        // link to All list or Free list
-    uint8_t          task_prio;            // prio
-    uint32_t         task_prio_mask;       // same as (1 << prio)
-    uint32_t         task_wait_time;       // sleep or wait
-    char*            task_name;            // other information
-    uint32_t         task_id;
-    tos_task_state_t task_state;
-    uint32_t         task_switch_cnt;
-    uint32_t         task_total_ticks;
-};
-
-typedef struct {
-    uint32_t         task_number;                                  // valid task number
-    uint32_t         intr_level;                                   //
-    uint32_t         sys_ticks;                                    //
-    uint32_t         ready_task_prio_mask;                         //
-    bool             schedule_enable;                              //
-    bool             sys_running;                                  //
-    tos_queue_node_t free_tcb_list;                                //
-    tos_queue_node_t all_task_list;                                // All tasks
-    tos_queue_node_t waiting_task_list;                            // Time Waiting tasks
-    tos_queue_node_t ready_task_list[TOS_MAX_PRIO_NUM_USED + 1];   // Ready tasks (like hash table)
-} tos_run_state_t;
-
-
-extern tos_run_state_t tos_state;
-
-
-/**
- * @brief
- *
- * @return tos_task_t*
- */
-tos_task_t* tos_get_current_task(void);
-
-/**
- * @brief
- * @note called by cpu timer ISR
- */
-void tos_time_tick(void);
-
-/**
- * @brief
- *
- */
-void tos_schedule(void);
-
-
-#endif
+/**
+ * @file tos_core_.h
+ * @brief tos core and task management module
+ * @note private, not for user
+ */
+
+#ifndef _TOS_CORE__H_
+#define _TOS_CORE__H_
+
+
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_trace.h"
+#include "tos_utils.h"
+
+
+#define get_task_by_ready_pending_link(link)                                                                           \
+    ((tos_task_t*)((uint8_t*)(link) - (uintptr_t) & ((tos_task_t*)0)->ready_pending_link))
+#define get_task_by_waiting_link(link)  ((tos_task_t*)((uint8_t*)(link) - (uintptr_t) & ((tos_task_t*)0)->waiting_link))
+#define get_task_by_all_free_link(link) ((tos_task_t*)((uint8_t*)(link) - (uintptr_t) & ((tos_task_t*)0)->all_free_link))
+
+#if TOS_PRIO_LEVEL_NUM < 1 || TOS_PRIO_LEVEL_NUM > 256
+#error "TOS_PRIO_LEVEL_NUM should be 1~256"
+#endif
+#if TOS_MAX_PRIO_NUM_USED >= TOS_PRIO_LEVEL_NUM
+#error "TOS_MAX_PRIO_NUM_USED should be less than TOS_PRIO_LEVEL_NUM"
+#endif
+
+// ready prio bitmap: one bit for each prio, 32 prios in one group
+#define TOS_PRIO_GROUP_NUM   ((TOS_PRIO_LEVEL_NUM + 31) / 32)
+#define tos_prio_group(prio) ((uint32_t)(prio) >> 5)
+#define tos_prio_mask(prio)  (1u << ((uint32_t)(prio)&0x1Fu))
+
+typedef struct tos_waitq_t tos_waitq_t;   // implement in tos_waitq.h
+
+// result of pending in wait queue, set by the waker
+#define TOS_PEND_OK      0
+#define TOS_PEND_TIMEOUT 1
+
+
+struct tos_task_t {
+    tos_stack_t*     task_stk_ptr;         // stack ptr
+    tos_stack_t*     task_stk_base;        // stack base addr (highest mostly)
+    tos_stack_t*     task_stk_top;         // stack top addr (next addr after stack space)
+    uint32_t         task_stk_size;        // stack size
+    tos_queue_node_t ready_pending_link;   // link to Ready list or Pending list
+    tos_queue_node_t waiting_link;         // link to time Waiting list
+    tos_queue_node_t all_free_link;        // link to All list or Zombie list
+    uint8_t          task_prio;            // running prio, may be raised by mutex
+    uint8_t          task_base_prio;       // prio set by user
+    uint32_t         task_prio_mask;       // same as (1 << (prio % 32)), bit in prio group
+    uint32_t         task_wait_time;       // sleep or wait, ticks after the previous task in waiting list
+#if TOS_TIME_SLICE_ENABLE
+    uint32_t         task_time_slice;        // ticks to run before yield to task with same prio
+    uint32_t         task_time_slice_left;   //
+#endif
+    char*            task_name;            // other information
+    uint32_t         task_id;
+    tos_task_state_t task_state;
+    uint32_t         task_switch_cnt;
+    uint32_t         task_period;          // ticks, 0 for not periodic
+    uint32_t         task_release;         // tick of last release of periodic task
+    uint32_t         task_deadline_miss;   // sleep until a release which has passed
+    uint32_t         task_overrun;         // releases skipped
+    tos_queue_node_t task_mutex_list;      // mutexes owned by the task
+    tos_waitq_t*     task_pend_waitq;      // wait queue of kernel object the task is pending on
+    void*            task_pend_mutex;      // mutex the task is pending on
+    uint8_t          task_pend_status;     // TOS_PEND_xxx, result of pending on sem or event
+    uint8_t          task_pend_option;     // event wait option
+    uint32_t         task_pend_value;      // event flags to wait, flags got when wake up
+    void*            task_pend_data;       // message to send or address to recv when pending on msgq
+#if TOS_STACK_CHECK_ENABLE
+    uint32_t         task_stk_peak;        // max used bytes found by stack check
+    bool             task_stk_overflow;    // lowest word of stack is overwritten, or stack ptr is out of stack
+#endif
+#if TOS_CPU_USAGE_ENABLE
+    uint64_t         task_run_cycles;      // cpu cycles the task has run, ISR time excluded
+#endif
+#if TOS_TASK_DYNAMIC_ENABLE
+    bool             task_dynamic;         // tcb and stack are allocated in one heap block
+#endif
+};
+
+typedef struct {
+    uint32_t         task_number;                                  // valid task number
+    uint32_t         task_id_next;                                 // id of next created task, ids are not reused
+    uint32_t         intr_level;                                   //
+    volatile uint32_t sys_ticks;                                   // updated by tick irq, polled by idle task
+#if TOS_CPU_USAGE_ENABLE
+    uint32_t         cycle_stamp;                                  // cycle count of last accounting
+    uint64_t         isr_cycles;                                   // cpu cycles in ISR (between enter/exit isr)
+#endif
+#if TOS_PRIO_GROUP_NUM > 1
+    uint32_t         ready_task_prio_group;                        // bit n set when ready_task_prio_mask[n] != 0
+#endif
+    uint32_t         ready_task_prio_mask[TOS_PRIO_GROUP_NUM];     // bit set when ready list of the prio not empty
+    bool             schedule_enable;                              //
+    bool             sys_running;                                  //
+    tos_queue_node_t all_task_list;                                // All tasks
+#if TOS_TASK_DYNAMIC_ENABLE
+    tos_queue_node_t zombie_task_list;                             // dynamic tasks deleted by itself, freed by idle
+#endif
+    tos_queue_node_t waiting_task_list;                            // Time Waiting tasks (delta queue)
+    tos_queue_node_t ready_task_list[TOS_MAX_PRIO_NUM_USED + 1];   // Ready tasks (like hash table)
+} tos_run_state_t;
+
+
+extern tos_run_state_t tos_state;
+
+
+/**
+ * @brief
+ *
+ * @return tos_task_t*
+ */
+tos_task_t* tos_get_current_task(void);
+
+/**
+ * @brief called by port just before switch to tos_task_switch_to
+ *
+ * @note tos_task_current is still the old task (nullptr for the first switch), called with irq disabled
+ */
+void tos_task_switch_hook(void);
+
+/**
+ * @brief
+ * @note called by cpu timer ISR
+ */
+void tos_time_tick(void);
+
+/**
+ * @brief
+ *
+ */
+void tos_schedule(void);
+
+/**
+ * @brief insert task into tail of ready list, mark task ready
+ *
+ * @param task_hdl
+ * @note called in critical section, task should not be in any ready or pending list
+ */
+void tos_ready_list_insert(tos_task_t* task_hdl);
+
+/**
+ * @brief remove task from ready or pending list
+ *
+ * @param task_hdl
+ * @note called in critical section
+ */
+void tos_ready_list_remove(tos_task_t* task_hdl);
+
+/**
+ * @brief change running prio of task
+ *
+ * @param task_hdl
+ * @param prio
+ * @note called in critical section, task_base_prio is not changed
+ */
+void tos_task_prio_change(tos_task_t* task_hdl, uint8_t prio);
+
+/**
+ * @brief recalculate running prio of task by its base prio and owned mutexes, pass the change to mutex owner
+ *        which the task is pending on
+ *
+ * @param task_hdl
+ * @note called in critical section. implement in tos_mutex.c
+ */
+void tos_mutex_prio_update(tos_task_t* task_hdl);
+
+/**
+ * @brief clean up mutexes of a task being deleted. the owner of the mutex which the task was pending on drops the
+ *        inherited prio, mutexes owned by the task are given to their first pending task or unlocked
+ *
+ * @param task_hdl removed from wait queue already
+ * @return true when some task is woken up as the new owner
+ * @note called in critical section. implement in tos_mutex.c
+ */
+bool tos_mutex_task_delete(tos_task_t* task_hdl);
+
+#if TOS_TIMER_ENABLE
+/**
+ * @brief advance the wheel, move expired timers to expired list and wake up timer task
+ *
+ * @param ticks ticks passed
+ * @note called in critical section. implement in tos_timer.c
+ */
+void tos_timer_tick(uint32_t ticks);
+
+/**
+ * @brief ticks to the next tick which expires timers or cascades timers from higher level
+ *
+ * @return uint32_t TOS_TIME_WAIT_INFINITY if there is no timer
+ * @note called in critical section. implement in tos_timer.c
+ */
+uint32_t tos_timer_next_ticks(void);
+#endif
+
+/**
+ * @brief insert task into time waiting list
+ *
+ * @param task_hdl
+ * @param ticks ticks to wait, TOS_TIME_WAIT_INFINITY will not be inserted
+ * @note called in critical section
+ */
+void tos_waiting_list_insert(tos_task_t* task_hdl, uint32_t ticks);
+
+/**
+ * @brief remove task from time waiting list
+ *
+ * @param task_hdl
+ * @note called in critical section
+ */
+void tos_waiting_list_remove(tos_task_t* task_hdl);
+
+
+#endif
@@ -1,75 +1,148 @@
-/**
- * @file tos_cpu.h
- * @brief cpu dependency function declaration
- * @note irq, task switch, task frame, systick
- */
-
-#ifndef _TOS_CPU_H_
-#define _TOS_CPU_H_
-
-#include "tos_core.h"
-#include "tos_types.h"
-
-
-/**
- * @brief OS Tick init
- *
- */
-void tos_sys_clock_init(void);
-
-/**
- * @brief task stack frame init
- *
- * @param proc task proc
- * @param args task arg
- * @param stack_ptr task stack ptr
- * @return tos_stack_t* ptr to current stack
- * @note the stack space and size must be valid
- */
-tos_stack_t* tos_task_stack_frame_init(tos_task_proc_t proc, void* args, tos_stack_t* stack_ptr);
-
-/**
- * @brief switch to tos_task_switch_to, store cpu info of tos_task_current
- *
- * @note implement by asm
- */
-void tos_task_switch(void);
-
-/**
- * @brief task switch when exit ISR
- *
- * @note implement by asm
- */
-void tos_task_switch_intr(void);
-
-/**
- * @brief start first task of TOS, do not store cpu info
- *
- * @note implement by asm
- */
-void tos_task_switch_first(void);
-
-/**
- * @brief disable CPU IRQ, return PRIMASK
- *
- * @return uint32_t
- * @note implement by asm
- */
-uint32_t tos_irq_diable(void);
-
-/**
- * @brief enable CPU IRQ
- *
- * @note implement by asm
- */
-void tos_irq_enable(void);
-
-/**
- * @brief restore CPU IRQ, restore PRIMASK
- *
- * @param primask
- * @note implement by asm
- */
-void tos_irq_restore(uint32_t primask);
-
-#endif
+/**
+ * @file tos_cpu.h
+ * @brief cpu dependency function declaration
+ * @note irq, task switch, task frame, systick
+ */
+
+#ifndef _TOS_CPU_H_
+#define _TOS_CPU_H_
+
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_types.h"
+
+
+/**
+ * @brief OS Tick init
+ *
+ */
+void tos_sys_clock_init(void);
+
+/**
+ * @brief task stack frame init
+ *
+ * @param proc task proc
+ * @param args task arg
+ * @param stack_ptr task stack ptr
+ * @return tos_stack_t* ptr to current stack
+ * @note the stack space and size must be valid
+ */
+tos_stack_t* tos_task_stack_frame_init(tos_task_proc_t proc, void* args, tos_stack_t* stack_ptr);
+
+/**
+ * @brief switch to tos_task_switch_to, store cpu info of tos_task_current
+ *
+ * @note implement by asm
+ */
+void tos_task_switch(void);
+
+/**
+ * @brief task switch when exit ISR
+ *
+ * @note implement by asm
+ */
+void tos_task_switch_intr(void);
+
+/**
+ * @brief start first task of TOS, do not store cpu info
+ *
+ * @note implement by asm
+ */
+void tos_task_switch_first(void);
+
+/**
+ * @brief disable CPU IRQ, return PRIMASK
+ *
+ * @return uint32_t
+ * @note implement by asm
+ */
+uint32_t tos_irq_diable(void);
+
+/**
+ * @brief enable CPU IRQ
+ *
+ * @note implement by asm
+ */
+void tos_irq_enable(void);
+
+/**
+ * @brief restore CPU IRQ, restore PRIMASK
+ *
+ * @param primask
+ * @note implement by asm
+ */
+void tos_irq_restore(uint32_t primask);
+
+/**
+ * @brief mask irq with prio value >= prio, return old mask
+ *
+ * @param prio
+ * @return uint32_t BASEPRI
+ * @note implement by asm, used by critical section when TOS_IRQ_MASK_PRIO is not 0.
+ *       ports without irq prio mask all irq
+ */
+uint32_t tos_irq_mask(uint32_t prio);
+
+/**
+ * @brief restore irq mask
+ *
+ * @param mask returned by tos_irq_mask
+ * @note implement by asm
+ */
+void tos_irq_unmask(uint32_t mask);
+
+/**
+ * @brief check that current ISR is masked by kernel critical section, so it can call kernel api
+ *
+ * @return true
+ * @return false prio of the ISR is higher than TOS_IRQ_MASK_PRIO
+ */
+bool tos_cpu_isr_managed(void);
+
+/**
+ * @brief count leading zeros
+ *
+ * @param val
+ * @return uint32_t 0~31, or 32 when val is 0
+ * @note use CLZ instruction if the cpu has, or tos_clz_generic
+ */
+uint32_t tos_cpu_clz(uint32_t val);
+
+/**
+ * @brief atomic compare and swap, store desired to *ptr only when *ptr equals expected
+ *
+ * @param ptr
+ * @param expected
+ * @param desired
+ * @return true swapped
+ * @return false *ptr is not expected, nothing stored
+ * @note lock free by LDREX/STREX if the cpu has, never disable irq in that case
+ */
+bool tos_cpu_cas(volatile uint32_t* ptr, uint32_t expected, uint32_t desired);
+
+/**
+ * @brief start the free running cpu cycle counter
+ *
+ * @note used by cpu usage, trace and benchmark, can be called more than once
+ */
+void tos_cpu_cycle_init(void);
+
+/**
+ * @brief read the cpu cycle counter
+ *
+ * @return uint32_t cycles, wrap around at 2^32
+ */
+uint32_t tos_cpu_cycle_get(void);
+
+#if TOS_TICKLESS_ENABLE
+/**
+ * @brief stop the periodic tick, sleep until an irq comes or the ticks passed
+ *
+ * @param ticks ticks to sleep, the port may sleep less when the timer can not reach it
+ * @return uint32_t complete ticks passed in sleep, not counted by the tick ISR
+ * @note called with irq disabled, and irq is still disabled when return
+ */
+uint32_t tos_cpu_tickless_sleep(uint32_t ticks);
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * @file tos_dpc.c
+ * @brief deferred procedure call
+ * @note multi producer single consumer ring. a poster reserves a slot by cas on the write position, fills it,
+ *       then publishes it by the sequence of the slot. irq is disabled only to wake the pending dpc task
+ */
+
+#include "tos_dpc.h"
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_core_.h"
+#include "tos_cpu.h"
+#include "tos_utils.h"
+
+
+#define TOS_DPC_QUEUE_MASK (TOS_DPC_QUEUE_SIZE - 1u)
+
+#if TOS_DPC_QUEUE_SIZE == 0 || (TOS_DPC_QUEUE_SIZE & TOS_DPC_QUEUE_MASK) != 0
+#error "TOS_DPC_QUEUE_SIZE should be power of 2"
+#endif
+
+
+typedef struct {
+    tos_dpc_func_t volatile func;
+    void* volatile          arg;
+    volatile uint32_t       seq;   // position to post at when free, position + 1 when posted
+} tos_dpc_slot_t;
+
+
+static void tos_dpc_task_proc(void* args);
+
+
+static tos_dpc_slot_t    tos_dpc_ring[TOS_DPC_QUEUE_SIZE];
+static volatile uint32_t tos_dpc_wr;             // next position to post, reserved by cas
+static uint32_t          tos_dpc_rd;             // next position to call, only used by dpc task
+static tos_task_t*       tos_dpc_task = nullptr;
+static tos_stack_t       tos_dpc_task_stack[TOS_DPC_TASK_STACK_SIZE / sizeof(tos_stack_t)];
+
+
+/**
+ * @brief create the dpc task
+ * @note called after tos_init, before ISR posts anything
+ */
+void tos_dpc_module_init(void) {
+    uint32_t        idx;
+    tos_task_attr_t task_attr;
+
+    for (idx = 0; idx < TOS_DPC_QUEUE_SIZE; idx++) {
+        tos_dpc_ring[idx].func = nullptr;
+        tos_dpc_ring[idx].arg  = nullptr;
+        tos_dpc_ring[idx].seq  = idx;
+    }
+    tos_dpc_wr = 0;
+    tos_dpc_rd = 0;
+
+    task_attr.task_name       = "dpc_task";
+    task_attr.task_wait_time  = 0;
+    task_attr.task_time_slice = 0;
+    task_attr.task_period     = 0;
+    task_attr.task_prio       = TOS_DPC_TASK_PRIO;
+    task_attr.task_stack_size = sizeof(tos_dpc_task_stack);
+    task_attr.task_stack      = tos_dpc_task_stack;
+
+    tos_dpc_task = tos_task_create(tos_dpc_task_proc, nullptr, &task_attr);
+    if (tos_dpc_task == nullptr) {
+        tos_error("dpc task create error!");
+    }
+}
+
+
+/**
+ * @brief post a call to the dpc task, calls run in post order
+ *
+ * @param func
+ * @param arg
+ * @return int 0, TOS_ERR_DPC_NULLPTR or TOS_ERR_DPC_FULL
+ * @note lock free, can be called in ISR (between tos_enter_isr and tos_exit_isr) and task.
+ *       func is called directly if the module is not inited
+ */
+int tos_dpc_post(tos_dpc_func_t func, void* arg) {
+    tos_dpc_slot_t* slot;
+    uint32_t        pos;
+    int32_t         diff;
+    tos_use_critical_section();
+
+    if (func == nullptr) {
+        return TOS_ERR_DPC_NULLPTR;
+    }
+    if (tos_dpc_task == nullptr) {
+        func(arg);
+        return 0;
+    }
+
+    // reserve a slot, retry when a nested ISR or other task takes the position first
+    do {
+        pos  = tos_dpc_wr;
+        slot = &tos_dpc_ring[pos & TOS_DPC_QUEUE_MASK];
+        diff = (int32_t)(slot->seq - pos);
+        if (diff < 0) {
+            return TOS_ERR_DPC_FULL;   // the slot of last round is not called yet
+        }
+    } while (diff != 0 || !tos_cpu_cas(&tos_dpc_wr, pos, pos + 1u));
+
+    slot->func = func;
+    slot->arg  = arg;
+    slot->seq  = pos + 1u;   // publish after filled
+
+    // wake the dpc task, ISR will schedule when exit
+    if (tos_dpc_task->task_state == TOS_TASK_STATE_PENDING) {
+        tos_enter_critical_section();
+        if (tos_dpc_task->task_state == TOS_TASK_STATE_PENDING) {
+            tos_ready_list_insert(tos_dpc_task);
+            tos_schedule();
+        }
+        tos_leave_critical_section();
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief dpc task, call posted functions in order
+ *
+ * @param args
+ */
+static void tos_dpc_task_proc(void* args) {
+    tos_dpc_slot_t* slot;
+    tos_dpc_func_t  func;
+    void*           arg;
+    tos_use_critical_section();
+
+    while (true) {
+        slot = &tos_dpc_ring[tos_dpc_rd & TOS_DPC_QUEUE_MASK];
+
+        // pend until the slot is published, tos_dpc_post makes it ready.
+        // a poster can not run between the check and pending, so no post is missed
+        if (slot->seq != tos_dpc_rd + 1u) {
+            tos_enter_critical_section();
+            if (slot->seq != tos_dpc_rd + 1u) {
+                tos_ready_list_remove(tos_dpc_task);
+                tos_dpc_task->task_state = TOS_TASK_STATE_PENDING;
+            }
+            tos_leave_critical_section();
+
+            tos_schedule();
+            continue;
+        }
+
+        func      = slot->func;
+        arg       = slot->arg;
+        slot->seq = tos_dpc_rd + TOS_DPC_QUEUE_SIZE;   // free for the next round
+        tos_dpc_rd++;
+
+        func(arg);
+    }
+}
@@ -0,0 +1,40 @@
+/**
+ * @file tos_dpc.h
+ * @brief deferred procedure call
+ * @note ISR posts a function and its arg, the dpc task calls it later in task context,
+ *       so ISR stays short and the function can use blocking kernel APIs
+ */
+
+#ifndef _TOS_DPC_H_
+#define _TOS_DPC_H_
+
+
+#include "tos_types.h"
+
+
+#define TOS_ERR_DPC_NULLPTR -1
+#define TOS_ERR_DPC_FULL    -2   // queue is full, the call is dropped
+
+
+typedef void (*tos_dpc_func_t)(void* arg);
+
+
+/**
+ * @brief create the dpc task
+ * @note called after tos_init, before ISR posts anything
+ */
+void tos_dpc_module_init(void);
+
+/**
+ * @brief post a call to the dpc task, calls run in post order
+ *
+ * @param func
+ * @param arg
+ * @return int 0, TOS_ERR_DPC_NULLPTR or TOS_ERR_DPC_FULL
+ * @note lock free, can be called in ISR (between tos_enter_isr and tos_exit_isr) and task.
+ *       func is called directly if the module is not inited
+ */
+int tos_dpc_post(tos_dpc_func_t func, void* arg);
+
+
+#endif
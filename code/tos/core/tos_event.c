@@ -0,0 +1,291 @@
+/**
+ * @file tos_event.c
+ * @brief event group, 32 event flags
+ *
+ */
+
+#include "tos_event.h"
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_core_.h"
+#include "tos_pool.h"
+#include "tos_utils.h"
+#include "tos_waitq.h"
+
+
+#define EVENT_VALID_FLAG   0x5A5A5A5A
+#define EVENT_INVALID_FLAG 0xFFFFFFFF
+
+// wait condition of flags is satisfied
+#define tos_event_satisfied(event_flags, flags, option)                                                                \
+    (((option)&TOS_EVENT_WAIT_ALL) ? (((event_flags) & (flags)) == (flags)) : (((event_flags) & (flags)) != 0))
+
+
+typedef struct tos_event_intenal_t {
+    uint32_t         valid_flag;
+    uint32_t         flags;
+    tos_waitq_t      waitq;   // pending tasks, sorted by prio
+} tos_event_intenal_t;
+
+
+TOS_POOL_DEFINE(tos_event_pool, tos_event_intenal_t, TOS_MAX_EVENT_NUM, TOS_POOL_FLAG_NONE);
+
+
+/**
+ * @brief
+ * @note called before use any event group
+ */
+void tos_event_module_init(void) {
+    tos_pool_reset(&tos_event_pool);
+}
+
+
+/**
+ * @brief
+ *
+ * @param event
+ * @param attr nullptr for no flag set
+ * @return int
+ */
+int tos_event_init(tos_event_t* event, const tos_event_attr_t* attr) {
+    if (event == nullptr) {
+        return TOS_ERR_EVENT_NULLPTR;
+    }
+
+    // get a free event
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    tos_event_intenal_t* event_intenal = tos_pool_get(&tos_event_pool);
+    if (event_intenal == nullptr) {
+        tos_leave_critical_section();
+        *event = nullptr;
+        return TOS_ERR_EVENT_NOFREE;
+    }
+
+    tos_leave_critical_section();
+
+    *event = event_intenal;
+
+    event_intenal->flags = (attr != nullptr) ? attr->init_flags : 0;
+    tos_waitq_init(&event_intenal->waitq);
+    event_intenal->valid_flag = EVENT_VALID_FLAG;
+
+    return 0;
+}
+
+
+/**
+ * @brief wait flags
+ *
+ * @param event
+ * @param flags flags to wait
+ * @param option TOS_EVENT_WAIT_ANY or TOS_EVENT_WAIT_ALL, or with TOS_EVENT_CLEAR
+ * @param recv_flags flags of event group when satisfied (before clear), can be nullptr
+ * @param try_nms TOS_EVENT_WAIT_INFINITE, TOS_EVENT_WAIT_IMMEDIATE or ms to wait
+ * @return int
+ */
+int tos_event_wait(tos_event_t* event, uint32_t flags, uint8_t option, uint32_t* recv_flags, uint32_t try_nms) {
+    if (event == nullptr) {
+        return TOS_ERR_EVENT_NULLPTR;
+    }
+    if (flags == 0) {
+        return TOS_ERR_EVENT_PARAM;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*event == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_EVENT_NULLPTR;
+    }
+    tos_event_intenal_t* event_intenal = *event;
+
+    if (event_intenal->valid_flag != EVENT_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_EVENT_INVALID;
+    }
+
+    tos_task_t* current_task = tos_get_current_task();
+
+    // 1 satisfied already
+    if (tos_event_satisfied(event_intenal->flags, flags, option)) {
+        if (recv_flags != nullptr) {
+            *recv_flags = event_intenal->flags;
+        }
+        if (option & TOS_EVENT_CLEAR) {
+            event_intenal->flags &= ~flags;
+        }
+        tos_trace(TOS_TRACE_EVENT_WAIT, current_task, tos_pool_index(&tos_event_pool, event_intenal));
+        tos_leave_critical_section();
+        return 0;
+    }
+
+    // 2.1 immediately
+    if (try_nms == TOS_EVENT_WAIT_IMMEDIATE) {
+        tos_leave_critical_section();
+        return TOS_ERR_EVENT_TIMEOUT;
+    }
+    if (tos_state.intr_level > 0) {
+        tos_leave_critical_section();
+        return TOS_ERR_EVENT_ISR;
+    }
+
+    // 2.2 wait, the setter checks the condition and clears the flags for current task
+    tos_trace(TOS_TRACE_EVENT_PEND, current_task, tos_pool_index(&tos_event_pool, event_intenal));
+    current_task->task_pend_value  = flags;
+    current_task->task_pend_option = option;
+    tos_waitq_pend(&event_intenal->waitq,
+                   (try_nms == TOS_EVENT_WAIT_INFINITE) ? TOS_TIME_WAIT_INFINITY : try_nms / TOS_TICK_MS);
+    tos_schedule();
+    tos_leave_critical_section();   // switch to other task here
+
+    if (current_task->task_pend_status != TOS_PEND_OK) {
+        tos_trace(TOS_TRACE_EVENT_TIMEOUT, current_task, tos_pool_index(&tos_event_pool, event_intenal));
+        return TOS_ERR_EVENT_TIMEOUT;
+    }
+    if (recv_flags != nullptr) {
+        *recv_flags = current_task->task_pend_value;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief set flags, wake up the satisfied tasks
+ *
+ * @param event
+ * @param flags
+ * @return int
+ * @note can be called in ISR
+ */
+int tos_event_set(tos_event_t* event, uint32_t flags) {
+    if (event == nullptr) {
+        return TOS_ERR_EVENT_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*event == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_EVENT_NULLPTR;
+    }
+    tos_event_intenal_t* event_intenal = *event;
+
+    if (event_intenal->valid_flag != EVENT_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_EVENT_INVALID;
+    }
+
+    tos_trace(TOS_TRACE_EVENT_SET, (tos_state.intr_level > 0) ? nullptr : tos_get_current_task(),
+              tos_pool_index(&tos_event_pool, event_intenal));
+
+    event_intenal->flags |= flags;
+
+    // wake up all satisfied tasks, they all see the flags before clear
+    tos_queue_node_t* queue_node = event_intenal->waitq.task_list.next;
+    uint32_t          clear      = 0;
+    bool              woken      = false;
+    while (queue_node != &event_intenal->waitq.task_list) {
+        tos_task_t* next_task = get_task_by_ready_pending_link(queue_node);
+        queue_node            = queue_node->next;   // NOTICE: list link will be changed below
+
+        if (tos_event_satisfied(event_intenal->flags, next_task->task_pend_value, next_task->task_pend_option)) {
+            if (next_task->task_pend_option & TOS_EVENT_CLEAR) {
+                clear |= next_task->task_pend_value;
+            }
+            next_task->task_pend_value = event_intenal->flags;
+            tos_waitq_wake(next_task);
+            woken = true;
+        }
+    }
+    event_intenal->flags &= ~clear;
+
+    // preempt if woken task has higher prio, ISR will schedule when exit
+    if (woken) {
+        tos_schedule();
+    }
+
+    tos_leave_critical_section();
+
+    return 0;
+}
+
+
+/**
+ * @brief
+ *
+ * @param event
+ * @param flags
+ * @return int
+ * @note can be called in ISR
+ */
+int tos_event_clear(tos_event_t* event, uint32_t flags) {
+    if (event == nullptr) {
+        return TOS_ERR_EVENT_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*event == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_EVENT_NULLPTR;
+    }
+    tos_event_intenal_t* event_intenal = *event;
+
+    if (event_intenal->valid_flag != EVENT_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_EVENT_INVALID;
+    }
+
+    event_intenal->flags &= ~flags;
+
+    tos_leave_critical_section();
+
+    return 0;
+}
+
+
+/**
+ * @brief
+ *
+ * @param event
+ * @return int
+ */
+int tos_event_destroy(tos_event_t* event) {
+    if (event == nullptr) {
+        return TOS_ERR_EVENT_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*event == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_EVENT_NULLPTR;
+    }
+    tos_event_intenal_t* event_intenal = *event;
+
+    if (event_intenal->valid_flag != EVENT_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_EVENT_INVALID;
+    }
+
+    if (!tos_waitq_is_empty(&event_intenal->waitq)) {
+        tos_leave_critical_section();
+        return TOS_ERR_EVENT_BLOCKING;
+    }
+
+    event_intenal->valid_flag = EVENT_INVALID_FLAG;
+    tos_pool_put(&tos_event_pool, event_intenal);
+
+    tos_leave_critical_section();
+
+    *event = nullptr;
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file tos_event.h
+ * @brief event group, 32 event flags
+ *
+ */
+
+#ifndef _TOS_EVENT_H_
+#define _TOS_EVENT_H_
+
+
+#include "tos_types.h"
+
+
+#define TOS_ERR_EVENT_NULLPTR  -1
+#define TOS_ERR_EVENT_NOFREE   -2
+#define TOS_ERR_EVENT_TIMEOUT  -3
+#define TOS_ERR_EVENT_PARAM    -4   // no flags to wait
+#define TOS_ERR_EVENT_BLOCKING -5   // task pending when destroy
+#define TOS_ERR_EVENT_INVALID  -6
+#define TOS_ERR_EVENT_ISR      -7   // try to block in ISR
+
+#define TOS_EVENT_WAIT_INFINITE  0xFFFFFFFFu
+#define TOS_EVENT_WAIT_IMMEDIATE 0
+
+// wait options
+#define TOS_EVENT_WAIT_ANY 0x00   // any of the flags is set
+#define TOS_EVENT_WAIT_ALL 0x01   // all of the flags are set
+#define TOS_EVENT_CLEAR    0x02   // clear the waited flags when satisfied, or with ANY/ALL
+
+
+typedef struct tos_event_intenal_t* tos_event_t;
+
+typedef struct {
+    uint32_t init_flags;
+} tos_event_attr_t;
+
+
+/**
+ * @brief
+ * @note called before use any event group
+ */
+void tos_event_module_init(void);
+
+/**
+ * @brief
+ *
+ * @param event
+ * @param attr nullptr for no flag set
+ * @return int
+ */
+int  tos_event_init(tos_event_t* event, const tos_event_attr_t* attr);
+
+/**
+ * @brief wait flags
+ *
+ * @param event
+ * @param flags flags to wait
+ * @param option TOS_EVENT_WAIT_ANY or TOS_EVENT_WAIT_ALL, or with TOS_EVENT_CLEAR
+ * @param recv_flags flags of event group when satisfied (before clear), can be nullptr
+ * @param try_nms TOS_EVENT_WAIT_INFINITE, TOS_EVENT_WAIT_IMMEDIATE or ms to wait
+ * @return int
+ */
+int  tos_event_wait(tos_event_t* event, uint32_t flags, uint8_t option, uint32_t* recv_flags, uint32_t try_nms);
+
+/**
+ * @brief set flags, wake up the satisfied tasks
+ *
+ * @param event
+ * @param flags
+ * @return int
+ * @note can be called in ISR
+ */
+int  tos_event_set(tos_event_t* event, uint32_t flags);
+
+/**
+ * @brief
+ *
+ * @param event
+ * @param flags
+ * @return int
+ * @note can be called in ISR
+ */
+int  tos_event_clear(tos_event_t* event, uint32_t flags);
+int  tos_event_destroy(tos_event_t* event);
+
+
+#endif
@@ -1,271 +1,789 @@
-/**
- * @file tos_mem.c
- * @brief memory management
- *
- */
-
-#include "tos_mem.h"
-#include "tos_utils.h"
-#include <string.h>
-
-/**
- * like the memory management in SGI STL
- * free momory are organized in:
- *     a table of block list, with size of the 8/16/24/32/.../128
- *     a large free area
- * when alloc
- *     find a suitable block in the table
- *     alloc some blocks in the free area
- *     devide one larger block in the table to some smaller blocks
- *
- * When use tos_malloc & tos_free, the block is like: size(4B) + user_space(user_size).
- *   to make addr align, use uint32_t to store size, but real size will not over 256.
- *   so, use hign 16 bits of size as a magic flag.
- */
-
-
-#define TOS_ADDR_ALIGN         4u
-#define TOS_MEM_INITED_FLAG    0x10241024u
-#define TOS_MEM_BLOCK_MIN      8u                                        // min block size
-#define TOS_MEM_BLOCK_MAX      128u                                      // max block size
-#define TOS_MEM_BLOCK_LIST_NUM (TOS_MEM_BLOCK_MAX / TOS_MEM_BLOCK_MIN)   // block list num
-
-#if 1   // if tos_size_t is uint32_t
-#define BLOCK_MAGIC        0x2048
-#define blk_set_size(size) ((BLOCK_MAGIC << 16) | size)
-#define blk_get_size(size) (0xFFFF & size)
-#define blk_chk_size(size) ((size >> 16) == BLOCK_MAGIC)
-#else
-#define blk_set_size(size) size
-#define blk_get_size(size) size
-#define blk_chk_size(size) true
-#endif
-
-
-typedef union tos_memblk_t {
-    union tos_memblk_t* free_list_link;
-    uint8_t             raw_space[TOS_MEM_BLOCK_MIN];
-    struct {
-        tos_size_t size;
-        uint8_t    user_space[TOS_MEM_BLOCK_MIN - sizeof(tos_size_t)];
-    };
-} tos_memblk_t;
-
-typedef struct {
-    struct   // cfg
-    {
-        uint32_t start;
-        uint32_t end;
-    } mem_pool;
-    tos_memblk_t* free_list[TOS_MEM_BLOCK_LIST_NUM];
-    uint32_t      init_flag;
-} tos_mem_t;
-
-#define TOS_FREELIST_INDEX(bytes) (((bytes) + TOS_MEM_BLOCK_MIN - 1) / TOS_MEM_BLOCK_MIN - 1)
-#define TOS_SIZE_ROUND_UP(bytes)  (((bytes) + TOS_MEM_BLOCK_MIN - 1) & ~(TOS_MEM_BLOCK_MIN - 1))
-
-
-static void*    tos_mem_alloc_new(tos_size_t nbytes);
-static uint8_t* tos_mem_chunk_alloc(tos_size_t size, uint8_t* nblks);
-
-
-static tos_mem_t tos_mem;
-
-
-/**
- * @brief
- *
- * @param mem_start
- * @param mem_size
- * @return int
- * @note 4 byte align, the space size must be divided by min block size
- */
-int tos_mem_module_init(uint32_t mem_start, tos_size_t mem_size) {
-    if ((mem_start % TOS_ADDR_ALIGN != 0) || (mem_size % TOS_MEM_BLOCK_MIN != 0)) {
-        return -1;
-    }
-
-    tos_mem.mem_pool.start = mem_start;
-    tos_mem.mem_pool.end   = mem_start + mem_size;
-    tos_mem.init_flag      = TOS_MEM_INITED_FLAG;
-
-    memset(tos_mem.free_list, 0, sizeof(tos_mem.free_list));
-
-    return 0;
-}
-
-
-/**
- * @brief
- *
- * @param nbytes 0 < nbytes <= 128
- * @return void* nullptr when fail
- */
-void* tos_mem_alloc(tos_size_t nbytes) {
-    if (tos_mem.init_flag != TOS_MEM_INITED_FLAG) {
-        return nullptr;
-    }
-    if (nbytes == 0 || nbytes > 128) {
-        return nullptr;
-    }
-
-    tos_memblk_t** free_list_Nbytes;
-    tos_memblk_t*  result;
-
-    free_list_Nbytes = tos_mem.free_list + TOS_FREELIST_INDEX(nbytes);
-    result           = *free_list_Nbytes;
-
-    if (result == nullptr)   // not find free block, alloc some new blocks
-    {
-        return tos_mem_alloc_new(TOS_SIZE_ROUND_UP(nbytes));
-    }
-
-    *free_list_Nbytes = result->free_list_link;
-
-    return result;
-}
-
-
-/**
- * @brief
- *
- * @param ptr
- * @param size
- */
-void tos_mem_dealloc(void* ptr, tos_size_t size) {
-    if (ptr == nullptr || size > TOS_MEM_BLOCK_MAX) {
-        return;
-    }
-
-    ((tos_memblk_t*)ptr)->free_list_link        = tos_mem.free_list[TOS_FREELIST_INDEX(size)];
-    tos_mem.free_list[TOS_FREELIST_INDEX(size)] = (tos_memblk_t*)ptr;
-}
-
-
-/**
- * @brief
- *
- * @param nbytes
- * @return void*
- */
-void* tos_malloc(tos_size_t nbytes) {
-    uint8_t* mem = tos_mem_alloc(nbytes + sizeof(tos_size_t));
-
-    if (mem == nullptr) {
-        return nullptr;
-    }
-
-    *(tos_size_t*)mem = blk_set_size(nbytes);
-
-    return mem + sizeof(tos_size_t);
-}
-
-/**
- * @brief
- *
- * @param ptr
- */
-void tos_free(void* ptr) {
-    if (ptr == nullptr) {
-        return;
-    }
-
-    uint8_t*   mem    = (uint8_t*)ptr - sizeof(tos_size_t);
-    tos_size_t nbytes = *(tos_size_t*)mem;
-
-    if (blk_chk_size(nbytes)) {
-        nbytes = blk_get_size(nbytes);
-
-        tos_mem_dealloc(mem, nbytes + sizeof(tos_size_t));
-    } else {
-        tos_error("try to free an invalid block\n");
-    }
-}
-
-
-/**
- * @brief try to alloc some nbytes block
- *
- * @param nbytes
- * @return void*
- */
-static void* tos_mem_alloc_new(tos_size_t nbytes) {
-    void*    result;
-    uint8_t  nblks = 5;
-    uint8_t* chunk = tos_mem_chunk_alloc(nbytes, &nblks);   // alloc nblks block of nbytes
-
-    if (nblks == 0) {
-        return nullptr;
-    } else if (nblks == 1) {
-        return chunk;
-    }
-
-    result = chunk;
-
-    /* Build free list in chunk */
-    tos_memblk_t *current_block, *next_block;
-
-    next_block = tos_mem.free_list[TOS_FREELIST_INDEX(nbytes)] = (tos_memblk_t*)(chunk + nbytes);
-
-    // add (nblks-1) blocks to free list
-    for (uint8_t i = 1; i <= nblks - 1; i++) {
-        current_block = next_block;
-        next_block    = (tos_memblk_t*)((uint8_t*)next_block + nbytes);
-
-        current_block->free_list_link = next_block;
-    }
-
-    current_block->free_list_link = nullptr;
-
-    return result;
-}
-
-
-/**
- * @brief try to alloc nblks blocks with size
- *
- * @param size
- * @param nblks
- * @return uint8_t*
- */
-static uint8_t* tos_mem_chunk_alloc(tos_size_t size, uint8_t* nblks) {
-    uint8_t* result;
-    uint32_t total_bytes = size * (*nblks);
-    uint32_t bytes_left  = tos_mem.mem_pool.end - tos_mem.mem_pool.start;
-
-    if (bytes_left >= total_bytes) {
-        result = (uint8_t*)tos_mem.mem_pool.start;
-        tos_mem.mem_pool.start += total_bytes;
-
-        return result;
-    } else if (bytes_left >= size) {
-        *nblks      = bytes_left / size;   // real block num
-        total_bytes = size * (*nblks);
-
-        result = (uint8_t*)tos_mem.mem_pool.start;
-        tos_mem.mem_pool.start += total_bytes;
-
-        return result;
-    } else {
-        // make use of the left-over piece. the left piece must can be add in one block list
-        if (bytes_left > 0) {
-            ((tos_memblk_t*)tos_mem.mem_pool.start)->free_list_link = tos_mem.free_list[TOS_FREELIST_INDEX(bytes_left)];
-            tos_mem.free_list[TOS_FREELIST_INDEX(bytes_left)]       = (tos_memblk_t*)tos_mem.mem_pool.start;
-        }
-
-        // free a larger free block
-        uint8_t blksize;
-        for (blksize = size; blksize <= TOS_MEM_BLOCK_MAX; blksize += TOS_MEM_BLOCK_MIN) {
-            if (tos_mem.free_list[TOS_FREELIST_INDEX(blksize)] != nullptr) {
-                tos_mem.free_list[TOS_FREELIST_INDEX(blksize)] =
-                    tos_mem.free_list[TOS_FREELIST_INDEX(blksize)]->free_list_link;
-                tos_mem.mem_pool.start = (uint32_t)tos_mem.free_list[TOS_FREELIST_INDEX(blksize)];
-                tos_mem.mem_pool.end   = tos_mem.mem_pool.start + blksize;
-
-                return tos_mem_chunk_alloc(size, nblks);
-            }
-        }
-
-        return nullptr;
-    }
-}
+/**
+ * @file tos_mem.c
+ * @brief memory management
+ *
+ */
+
+#include "tos_mem.h"
+#include "tos_core.h"
+#include "tos_core_.h"
+#include "tos_cpu.h"
+#include "tos_tlsf.h"
+#include "tos_utils.h"
+#include <string.h>
+
+/**
+ * like the memory management in SGI STL
+ * free momory are organized in:
+ *     a table of block list, with size of the 8/16/24/32/.../TOS_MEM_BLOCK_MAX (128 by default)
+ *     a large free area, managed by TLSF
+ * when alloc
+ *     find a suitable block in the table
+ *     alloc some blocks in the free area, in a chunk of whole pages
+ * blocks larger than TOS_MEM_BLOCK_MAX bytes are allocated from and freed to the free area directly, in O(1) time.
+ *
+ * the block lists are lock free LIFO, push and pop by compare and swap of list head, so tasks and ISRs can
+ *   alloc and free small blocks at any time without closing irq. a block is addressed by its 8 byte index
+ *   from pool base, the head keeps the index and a tag, which is changed by every pop and push to avoid
+ *   ABA problem (a block popped and pushed back by others between reading its link and swapping the head).
+ *   the free area is used in critical section, only when a list is empty.
+ *
+ * blocks carved from the free area for the lists are not merged when freed. tos_mem_compact takes all lists,
+ *   sorts the blocks by address, and returns every chunk whose blocks are all free to the free area, where it
+ *   merges with free neighbours. a chunk is a TLSF block with the bytes of its pages in its tag, it is found
+ *   from a block by walking back the page map to its first page. blocks of other chunks are pushed back.
+ *   alloc never compacts, a failed alloc only asks for it, and the idle task (or the user) runs it in task
+ *   context, so the lock free path and the irq latency of alloc are not changed by the number of free blocks.
+ *
+ * the pool is divided into pages of 2^TOS_MEM_PAGE_LOG2 bytes. chunks start at a page and cover whole pages,
+ *   the page map keeps the block list of each page (list index + 1), 0 for pages of the free area and large
+ *   blocks, and the first page of a chunk is flagged. so tos_free finds the size of a block by its address,
+ *   tos_malloc needs no header.
+ *
+ * When TOS_MEM_DEBUG_ENABLE, tos_malloc adds a header to a small block, the block is like:
+ *   size(4B) + user_space(user_size). to make addr align, use uint32_t to store size, but the size of a small
+ *   block is not over TOS_MEM_BLOCK_MAX (1016 at most), so the low 16 bits keep it and the high 16 bits are a
+ *   magic flag. a large block has no header and no size, the tag word of TLSF before user_space is set to
+ *   another magic.
+ */
+
+
+#define TOS_ADDR_ALIGN         4u
+#define TOS_MEM_INITED_FLAG    0x10241024u
+#define TOS_MEM_BLOCK_MIN      8u                                        // min block size
+#define TOS_MEM_BLOCK_LIST_NUM (TOS_MEM_BLOCK_MAX / TOS_MEM_BLOCK_MIN)   // block list num
+#define TOS_MEM_PAGE_SIZE      (1u << TOS_MEM_PAGE_LOG2)
+#define TOS_MEM_PAGE_FIRST     0x80u                                     // page map flag of first page of chunk
+
+#if TOS_MEM_DEBUG_ENABLE
+#define TOS_MEM_HEAD_SIZE sizeof(tos_size_t)   // magic header of tos_malloc
+#else
+#define TOS_MEM_HEAD_SIZE 0u
+#endif
+
+#if 1   // if tos_size_t is uint32_t
+#define BLOCK_MAGIC        0x2048
+#define blk_set_size(size) ((BLOCK_MAGIC << 16) | size)
+#define blk_get_size(size) (0xFFFF & size)
+#define blk_chk_size(size) ((size >> 16) == BLOCK_MAGIC)
+#else
+#define blk_set_size(size) size
+#define blk_get_size(size) size
+#define blk_chk_size(size) true
+#endif
+#define BLOCK_MAGIC_LARGE   0x2049
+#define blk_set_large()     ((tos_size_t)BLOCK_MAGIC_LARGE << 16)
+#define blk_chk_large(size) ((size) == blk_set_large())
+#define BLOCK_MAGIC_CHUNK   0x204A
+#define blk_set_chunk(size) (((tos_size_t)BLOCK_MAGIC_CHUNK << 16) | (size))   // bytes of pages
+#define blk_get_chunk(tag)  ((tag)&0xFFFFu)
+#define blk_chk_chunk(tag)  (((tag) >> 16) == BLOCK_MAGIC_CHUNK)
+
+// head of block list: tag (high 16 bits) | index of first block (low 16 bits, 0 for empty list)
+#define TOS_MEM_HEAD_IDX_MASK 0xFFFFu
+#define TOS_MEM_HEAD_TAG_ONE  0x10000u
+#define tos_mem_blk_to_idx(blk)                                                                                        \
+    (((blk) == nullptr) ? 0u : (uint32_t)(((uintptr_t)(blk)-tos_mem.base) / TOS_MEM_BLOCK_MIN + 1))
+#define tos_mem_idx_to_blk(idx)                                                                                        \
+    (((idx) == 0) ? nullptr : (tos_memblk_t*)(tos_mem.base + ((idx)-1) * TOS_MEM_BLOCK_MIN))
+
+#if TOS_MEM_TLSF_FL_MAX > 19
+#error "block index of 16 bits addresses 2^19 bytes pool"
+#endif
+#if TOS_MEM_BLOCK_LIST_NUM != TOS_MEM_CLASS_NUM
+#error "TOS_MEM_CLASS_NUM should be the number of block lists"
+#endif
+#if TOS_MEM_BLOCK_MAX % TOS_MEM_BLOCK_MIN != 0 || TOS_MEM_BLOCK_MAX < 16 || TOS_MEM_BLOCK_MAX > 1016
+#error "TOS_MEM_BLOCK_MAX should be 16~1016 and multiple of 8, list index + 1 is kept in 7 bits of page map"
+#endif
+#if TOS_MEM_PAGE_LOG2 < 5 || TOS_MEM_PAGE_LOG2 > 10
+#error "TOS_MEM_PAGE_LOG2 should be 5~10"
+#endif
+#if TOS_MEM_CHUNK_BLKS < 1 || TOS_MEM_CHUNK_BLKS + TOS_MEM_PAGE_SIZE / TOS_MEM_BLOCK_MIN > 256
+#error "a chunk holds no more than 255 blocks"
+#endif
+#if TOS_MEM_CHUNK_BLKS * TOS_MEM_BLOCK_MAX + TOS_MEM_PAGE_SIZE > 0x10000
+#error "bytes of a chunk are kept in 16 bits"
+#endif
+
+
+typedef union tos_memblk_t {
+    union tos_memblk_t* free_list_link;
+    uint8_t             raw_space[TOS_MEM_BLOCK_MIN];
+    struct {
+        tos_size_t size;
+        uint8_t    user_space[TOS_MEM_BLOCK_MIN - sizeof(tos_size_t)];
+    };
+    struct {
+        uint32_t sort_link;   // index of next block, when taken by compaction
+        uint32_t sort_size;   // block size
+    };
+} tos_memblk_t;
+
+typedef struct {
+    tos_tlsf_t        mem_pool;                            // free area
+    uintptr_t         base;                                // 8 byte align, block index 1 is here
+    volatile uint32_t free_list[TOS_MEM_BLOCK_LIST_NUM];   // head of block lists
+    uint8_t*          page_map;                            // block list index + 1 of each page, 0 if not in chunk,
+                                                           // | TOS_MEM_PAGE_FIRST for first page of chunk
+    uintptr_t         page_base;                           // address of page 0
+    uint32_t          page_num;                            //
+    uint32_t          init_flag;
+    volatile uint32_t compact_busy;                        // 1 when tos_mem_compact is running
+    volatile uint32_t compact_want;                        // 1 when an alloc failed after the last compaction
+    uint32_t          chunk_num;                           // chunks carved for block lists, not returned
+    tos_size_t        chunk_bytes;                         //
+    uint32_t          carve_cnt;                           // chunks carved since init
+    uint32_t          compact_cnt;                         // compaction passes
+    uint32_t          return_cnt;                          // chunks returned by compaction
+    tos_size_t        return_bytes;                        //
+} tos_mem_t;
+
+#define TOS_FREELIST_INDEX(bytes) (((bytes) + TOS_MEM_BLOCK_MIN - 1) / TOS_MEM_BLOCK_MIN - 1)
+#define TOS_SIZE_ROUND_UP(bytes)  (((bytes) + TOS_MEM_BLOCK_MIN - 1) & ~(TOS_MEM_BLOCK_MIN - 1))
+
+
+static tos_memblk_t* tos_mem_list_pop(uint32_t list_idx);
+static void          tos_mem_list_push(uint32_t list_idx, tos_memblk_t* first, tos_memblk_t* last);
+static uint32_t      tos_mem_list_take(uint32_t list_idx);
+static void*         tos_mem_large_alloc(tos_size_t nbytes);
+static void*         tos_mem_alloc_new(tos_size_t nbytes);
+static uint8_t*      tos_mem_chunk_alloc(tos_size_t size, uint8_t* nblks);
+static uint32_t      tos_mem_sort(uint32_t list);
+static uint8_t*      tos_mem_chunk_find(uint8_t* addr);
+static void          tos_mem_page_set(uint8_t* chunk, tos_size_t bytes, uint8_t map);
+static uint32_t      tos_mem_page_get(void* ptr);
+
+
+static tos_mem_t tos_mem;
+
+
+/**
+ * @brief
+ *
+ * @param mem_start
+ * @param mem_size
+ * @return int
+ * @note 4 byte align, the space size must be divided by min block size, and not over 2^TOS_MEM_TLSF_FL_MAX.
+ *       the page map takes 1 byte of every 2^TOS_MEM_PAGE_LOG2 bytes at begin of the space
+ */
+int tos_mem_module_init(uintptr_t mem_start, tos_size_t mem_size) {
+    uint32_t   idx;
+    tos_size_t map_size;
+
+    if ((mem_start % TOS_ADDR_ALIGN != 0) || (mem_size % TOS_MEM_BLOCK_MIN != 0)) {
+        return -1;
+    }
+
+    // page map is at begin of the space
+    tos_mem.page_base = mem_start & ~(uintptr_t)(TOS_MEM_PAGE_SIZE - 1);
+    tos_mem.page_num  = (uint32_t)((mem_start + mem_size - tos_mem.page_base + TOS_MEM_PAGE_SIZE - 1) >> TOS_MEM_PAGE_LOG2);
+    map_size          = TOS_SIZE_ROUND_UP(tos_mem.page_num);
+    if (map_size >= mem_size) {
+        return -1;
+    }
+    tos_mem.page_map = (uint8_t*)mem_start;
+    memset(tos_mem.page_map, 0, map_size);
+
+    if (tos_tlsf_init(&tos_mem.mem_pool, mem_start + map_size, mem_size - map_size) != 0) {
+        return -1;
+    }
+    tos_mem.base         = mem_start & ~(uintptr_t)(TOS_MEM_BLOCK_MIN - 1);
+    tos_mem.init_flag    = TOS_MEM_INITED_FLAG;
+    tos_mem.compact_busy = 0;
+    tos_mem.compact_want = 0;
+    tos_mem.chunk_num    = 0;
+    tos_mem.chunk_bytes  = 0;
+    tos_mem.carve_cnt    = 0;
+    tos_mem.compact_cnt  = 0;
+    tos_mem.return_cnt   = 0;
+    tos_mem.return_bytes = 0;
+
+    for (idx = 0; idx < TOS_MEM_BLOCK_LIST_NUM; idx++) {
+        tos_mem.free_list[idx] = 0;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief
+ *
+ * @param nbytes nbytes > 0, blocks over TOS_MEM_BLOCK_MAX bytes are allocated from the free area
+ * @return void* nullptr when fail
+ */
+void* tos_mem_alloc(tos_size_t nbytes) {
+    if (tos_mem.init_flag != TOS_MEM_INITED_FLAG) {
+        return nullptr;
+    }
+    if (nbytes == 0) {
+        return nullptr;
+    }
+
+    void* result;
+
+    if (nbytes > TOS_MEM_BLOCK_MAX) {
+        return tos_mem_large_alloc(nbytes);
+    }
+
+    result = tos_mem_list_pop(TOS_FREELIST_INDEX(nbytes));
+
+    if (result == nullptr)   // not find free block, alloc some new blocks
+    {
+        result = tos_mem_alloc_new(TOS_SIZE_ROUND_UP(nbytes));
+    }
+
+    return result;
+}
+
+
+/**
+ * @brief
+ *
+ * @param ptr
+ * @param size
+ */
+void tos_mem_dealloc(void* ptr, tos_size_t size) {
+    tos_use_critical_section();
+
+    if (ptr == nullptr) {
+        return;
+    }
+
+    if (size > TOS_MEM_BLOCK_MAX) {
+        tos_enter_critical_section();
+        tos_tlsf_free(&tos_mem.mem_pool, ptr);
+        tos_leave_critical_section();
+    } else {
+        tos_mem_list_push(TOS_FREELIST_INDEX(size), (tos_memblk_t*)ptr, (tos_memblk_t*)ptr);
+    }
+}
+
+
+/**
+ * @brief
+ *
+ * @param nbytes
+ * @return void*
+ */
+void* tos_malloc(tos_size_t nbytes) {
+    uint8_t* mem;
+
+    if (nbytes > TOS_MEM_BLOCK_MAX - TOS_MEM_HEAD_SIZE) {
+        if (tos_mem.init_flag != TOS_MEM_INITED_FLAG) {
+            return nullptr;
+        }
+
+        mem = tos_mem_large_alloc(nbytes);
+#if TOS_MEM_DEBUG_ENABLE
+        if (mem != nullptr) {
+            ((tos_size_t*)mem)[-1] = blk_set_large();   // tag of TLSF block
+        }
+#endif
+
+        return mem;
+    }
+
+    mem = tos_mem_alloc(nbytes + TOS_MEM_HEAD_SIZE);
+
+    if (mem == nullptr) {
+        return nullptr;
+    }
+
+#if TOS_MEM_DEBUG_ENABLE
+    *(tos_size_t*)mem = blk_set_size(nbytes);
+#endif
+
+    return mem + TOS_MEM_HEAD_SIZE;
+}
+
+/**
+ * @brief
+ *
+ * @param ptr
+ */
+void tos_free(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    uint8_t* mem      = (uint8_t*)ptr - TOS_MEM_HEAD_SIZE;
+    uint32_t list_idx = tos_mem_page_get(mem);   // 0 for a large block
+    tos_use_critical_section();
+
+    if (list_idx == 0) {
+#if TOS_MEM_DEBUG_ENABLE
+        if (!blk_chk_large(((tos_size_t*)ptr)[-1])) {
+            tos_error("try to free an invalid block\n");
+            return;
+        }
+        ((tos_size_t*)ptr)[-1] = 0;   // catch double free
+#endif
+        tos_enter_critical_section();
+        tos_tlsf_free(&tos_mem.mem_pool, ptr);
+        tos_leave_critical_section();
+        return;
+    }
+
+#if TOS_MEM_DEBUG_ENABLE
+    // the magic is overwritten by the list link when freed
+    tos_size_t nbytes = *(tos_size_t*)mem;
+    if (!blk_chk_size(nbytes) || TOS_FREELIST_INDEX(blk_get_size(nbytes) + TOS_MEM_HEAD_SIZE) != list_idx - 1) {
+        tos_error("try to free an invalid block\n");
+        return;
+    }
+#endif
+
+    tos_mem_list_push(list_idx - 1, (tos_memblk_t*)mem, (tos_memblk_t*)mem);
+}
+
+
+/**
+ * @brief return chunks of small blocks to the free area when all blocks of the chunk are free
+ *
+ * @return tos_size_t bytes returned, 0 when nothing is returned, another pass is running, or called in ISR
+ * @note task context only, refused in ISR. run by idle task after an alloc failed when
+ *       TOS_MEM_IDLE_COMPACT_ENABLE, or by user on demand.
+ *       O(n log n) of n free small blocks, to take the lists and merge sort the blocks without closing irq,
+ *       plus O(pages of a chunk) to find the chunk of each run of blocks in the page map. irq is closed only to
+ *       return one chunk to TLSF at a time, O(1). small block lists look empty to others during the pass, they
+ *       carve new chunks instead, or fail when the free area is used up
+ */
+tos_size_t tos_mem_compact(void) {
+    uint32_t      list = 0;   // all taken blocks, by index
+    uint32_t      list_idx;
+    uint32_t      idx;
+    uint32_t      first;
+    uint32_t      blk_num;
+    uint8_t*      chunk;
+    uint8_t*      chunk_end;
+    uint8_t*      expect;
+    tos_size_t    bytes;
+    tos_size_t    returned = 0;
+    tos_memblk_t* blk;
+    tos_memblk_t* next_blk;
+    tos_use_critical_section();
+
+    if (tos_mem.init_flag != TOS_MEM_INITED_FLAG || tos_state.intr_level > 0) {
+        return 0;
+    }
+    if (!tos_cpu_cas(&tos_mem.compact_busy, 0, 1)) {   // a pass is running, maybe in the preempted task
+        return 0;
+    }
+    tos_mem.compact_want = 0;
+
+    // take all lists, link the blocks by index and keep their size
+    for (list_idx = 0; list_idx < TOS_MEM_BLOCK_LIST_NUM; list_idx++) {
+        idx = tos_mem_list_take(list_idx);
+        blk = tos_mem_idx_to_blk(idx);
+        while (blk != nullptr) {
+            next_blk       = blk->free_list_link;
+            blk->sort_link = list;
+            blk->sort_size = (list_idx + 1) * TOS_MEM_BLOCK_MIN;
+            list           = tos_mem_blk_to_idx(blk);
+            blk            = next_blk;
+        }
+    }
+    list = tos_mem_sort(list);
+
+    // blocks of a chunk are adjacent in sorted list, the chunk is free if they cover all of it
+    while (list != 0) {
+        chunk = tos_mem_chunk_find((uint8_t*)tos_mem_idx_to_blk(list));
+        if (chunk == nullptr) {   // never happens, keep the block
+            blk  = tos_mem_idx_to_blk(list);
+            list = blk->sort_link;
+            tos_mem_list_push(TOS_FREELIST_INDEX(blk->sort_size), blk, blk);
+            continue;
+        }
+        // blocks from begin of the chunk, the tail shorter than a block is never used
+        bytes     = tos_mem_page_get(chunk) * TOS_MEM_BLOCK_MIN;
+        chunk_end = chunk + blk_get_chunk(((tos_size_t*)chunk)[-1]) / bytes * bytes;
+
+        first   = list;
+        expect  = chunk;
+        blk_num = 0;
+        while (list != 0 && (uint8_t*)tos_mem_idx_to_blk(list) < chunk_end) {
+            blk = tos_mem_idx_to_blk(list);
+            if ((uint8_t*)blk != expect) {
+                expect = nullptr;
+            } else {
+                expect += blk->sort_size;
+            }
+            list = blk->sort_link;
+            blk_num++;
+        }
+
+        if (expect == chunk_end) {
+            tos_enter_critical_section();
+            bytes = tos_tlsf_block_size(chunk);
+            tos_mem_page_set(chunk, blk_get_chunk(((tos_size_t*)chunk)[-1]), 0);
+            tos_tlsf_free(&tos_mem.mem_pool, chunk);
+            tos_mem.chunk_num--;
+            tos_mem.chunk_bytes -= bytes;
+            tos_mem.return_cnt++;
+            tos_mem.return_bytes += bytes;
+            tos_leave_critical_section();
+
+            returned += bytes;
+            continue;
+        }
+        while (blk_num-- > 0) {
+            blk   = tos_mem_idx_to_blk(first);
+            first = blk->sort_link;
+            tos_mem_list_push(TOS_FREELIST_INDEX(blk->sort_size), blk, blk);
+        }
+    }
+
+    tos_mem.compact_cnt++;
+    tos_mem.compact_busy = 0;
+
+    return returned;
+}
+
+
+/**
+ * @brief
+ *
+ * @return bool
+ */
+bool tos_mem_compact_wanted(void) {
+    return tos_mem.compact_want != 0;
+}
+
+
+/**
+ * @brief
+ *
+ * @param stat
+ * @return int
+ */
+int tos_mem_stat_get(tos_mem_stat_t* stat) {
+    uint32_t      list_idx;
+    uint32_t      blk_num;
+    tos_memblk_t* blk;
+    void*         ptr;
+    tos_size_t    size;
+    tos_use_critical_section();
+
+    if (stat == nullptr || tos_mem.init_flag != TOS_MEM_INITED_FLAG) {
+        return -1;
+    }
+
+    tos_enter_critical_section();
+
+    // nobody pops or pushes blocks in critical section
+    for (list_idx = 0; list_idx < TOS_MEM_BLOCK_LIST_NUM; list_idx++) {
+        blk_num = 0;
+        for (blk = tos_mem_idx_to_blk(tos_mem.free_list[list_idx] & TOS_MEM_HEAD_IDX_MASK); blk != nullptr;
+             blk = blk->free_list_link) {
+            blk_num++;
+        }
+        stat->class_free_bytes[list_idx] = blk_num * (list_idx + 1) * TOS_MEM_BLOCK_MIN;
+    }
+
+    stat->free_area_bytes = tos_mem.mem_pool.free_bytes;
+    stat->free_extent_num = 0;
+    stat->largest_free    = 0;
+    for (ptr = tos_tlsf_block_next(&tos_mem.mem_pool, nullptr); ptr != nullptr;
+         ptr = tos_tlsf_block_next(&tos_mem.mem_pool, ptr)) {
+        if (tos_tlsf_block_is_free(ptr)) {
+            size = tos_tlsf_block_size(ptr);
+            stat->free_extent_num++;
+            if (size > stat->largest_free) {
+                stat->largest_free = size;
+            }
+        }
+    }
+
+    stat->chunk_num    = tos_mem.chunk_num;
+    stat->chunk_bytes  = tos_mem.chunk_bytes;
+    stat->carve_cnt    = tos_mem.carve_cnt;
+    stat->compact_cnt  = tos_mem.compact_cnt;
+    stat->return_cnt   = tos_mem.return_cnt;
+    stat->return_bytes = tos_mem.return_bytes;
+
+    tos_leave_critical_section();
+
+    return 0;
+}
+
+
+/**
+ * @brief pop the first block of list
+ *
+ * @param list_idx
+ * @return tos_memblk_t* nullptr when list is empty
+ * @note lock free. the link read may be out of date if the block is popped by others meanwhile, then the tag
+ *       in head has changed and swap fails
+ */
+static tos_memblk_t* tos_mem_list_pop(uint32_t list_idx) {
+    uint32_t      head;
+    uint32_t      new_head;
+    tos_memblk_t* blk;
+
+    do {
+        head = tos_mem.free_list[list_idx];
+        blk  = tos_mem_idx_to_blk(head & TOS_MEM_HEAD_IDX_MASK);
+        if (blk == nullptr) {
+            return nullptr;
+        }
+        new_head = ((head + TOS_MEM_HEAD_TAG_ONE) & ~TOS_MEM_HEAD_IDX_MASK) | tos_mem_blk_to_idx(blk->free_list_link);
+    } while (!tos_cpu_cas(&tos_mem.free_list[list_idx], head, new_head));
+
+    return blk;
+}
+
+
+/**
+ * @brief push linked blocks to the front of list
+ *
+ * @param list_idx
+ * @param first
+ * @param last linked from first by free_list_link
+ * @note lock free
+ */
+static void tos_mem_list_push(uint32_t list_idx, tos_memblk_t* first, tos_memblk_t* last) {
+    uint32_t head;
+    uint32_t new_head;
+
+    do {
+        head                 = tos_mem.free_list[list_idx];
+        last->free_list_link = tos_mem_idx_to_blk(head & TOS_MEM_HEAD_IDX_MASK);
+        new_head             = ((head + TOS_MEM_HEAD_TAG_ONE) & ~TOS_MEM_HEAD_IDX_MASK) | tos_mem_blk_to_idx(first);
+    } while (!tos_cpu_cas(&tos_mem.free_list[list_idx], head, new_head));
+}
+
+
+/**
+ * @brief take all blocks of list
+ *
+ * @param list_idx
+ * @return uint32_t index of the first block, 0 when list is empty
+ * @note lock free
+ */
+static uint32_t tos_mem_list_take(uint32_t list_idx) {
+    uint32_t head;
+
+    do {
+        head = tos_mem.free_list[list_idx];
+    } while (!tos_cpu_cas(&tos_mem.free_list[list_idx], head,
+                          (head + TOS_MEM_HEAD_TAG_ONE) & ~TOS_MEM_HEAD_IDX_MASK));
+
+    return head & TOS_MEM_HEAD_IDX_MASK;
+}
+
+
+/**
+ * @brief alloc a block from the free area
+ *
+ * @param nbytes
+ * @return void*
+ * @note asks for compaction when fail, the memory may be held by free small blocks
+ */
+static void* tos_mem_large_alloc(tos_size_t nbytes) {
+    void* result;
+    tos_use_critical_section();
+
+    tos_enter_critical_section();   // blocks may be passed to and freed by other tasks, such as by tos_msgq
+    result = tos_tlsf_alloc(&tos_mem.mem_pool, nbytes);
+    tos_leave_critical_section();
+
+    if (result == nullptr) {
+        tos_mem.compact_want = 1;
+    }
+
+    return result;
+}
+
+
+/**
+ * @brief try to alloc some nbytes block
+ *
+ * @param nbytes
+ * @return void*
+ */
+static void* tos_mem_alloc_new(tos_size_t nbytes) {
+    void*    result;
+    uint8_t  nblks = TOS_MEM_CHUNK_BLKS;
+    uint8_t* chunk = tos_mem_chunk_alloc(nbytes, &nblks);   // alloc nblks block of nbytes
+
+    if (nblks == 0) {
+        return nullptr;
+    } else if (nblks == 1) {
+        return chunk;
+    }
+
+    result = chunk;
+
+    /* Build free list in chunk */
+    tos_memblk_t *current_block = nullptr, *next_block;
+
+    next_block = (tos_memblk_t*)(chunk + nbytes);
+
+    // link (nblks-1) blocks, then push them to free list at once
+    for (uint8_t i = 1; i <= nblks - 1; i++) {
+        current_block = next_block;
+        next_block    = (tos_memblk_t*)((uint8_t*)next_block + nbytes);
+
+        current_block->free_list_link = next_block;
+    }
+
+    tos_mem_list_push(TOS_FREELIST_INDEX(nbytes), (tos_memblk_t*)(chunk + nbytes), current_block);
+
+    return result;
+}
+
+
+/**
+ * @brief try to alloc nblks blocks with size, in a chunk of whole pages
+ *
+ * @param size
+ * @param nblks in: blocks wanted, out: blocks in the chunk, 0 when fail
+ * @return uint8_t*
+ * @note asks for compaction when fail
+ */
+static uint8_t* tos_mem_chunk_alloc(tos_size_t size, uint8_t* nblks) {
+    uint8_t*   result;
+    tos_size_t chunk_size = (size * (*nblks) + TOS_MEM_PAGE_SIZE - 1) & ~(TOS_MEM_PAGE_SIZE - 1);
+    tos_use_critical_section();
+
+    tos_enter_critical_section();
+    result = tos_tlsf_alloc_aligned(&tos_mem.mem_pool, chunk_size, TOS_MEM_PAGE_SIZE);
+    if (result == nullptr) {
+        chunk_size = (size + TOS_MEM_PAGE_SIZE - 1) & ~(TOS_MEM_PAGE_SIZE - 1);
+        result     = tos_tlsf_alloc_aligned(&tos_mem.mem_pool, chunk_size, TOS_MEM_PAGE_SIZE);
+    }
+    if (result != nullptr) {
+        // make use of the whole pages, a block may cross pages
+        *nblks = (uint8_t)(chunk_size / size);
+
+        ((tos_size_t*)result)[-1] = blk_set_chunk(chunk_size);   // tag of TLSF block, for compaction
+        tos_mem_page_set(result, chunk_size, (uint8_t)(TOS_FREELIST_INDEX(size) + 1));
+        tos_mem.page_map[((uintptr_t)result - tos_mem.page_base) >> TOS_MEM_PAGE_LOG2] |= TOS_MEM_PAGE_FIRST;
+        tos_mem.chunk_num++;
+        tos_mem.chunk_bytes += tos_tlsf_block_size(result);
+        tos_mem.carve_cnt++;
+    } else {
+        *nblks               = 0;
+        tos_mem.compact_want = 1;
+    }
+    tos_leave_critical_section();
+
+    return result;
+}
+
+
+/**
+ * @brief merge sort of a block list by address
+ *
+ * @param list index of the first block, linked by sort_link
+ * @return uint32_t index of the first block of sorted list
+ */
+static uint32_t tos_mem_sort(uint32_t list) {
+    uint32_t run = 1;   // length of sorted runs
+    uint32_t merges;
+    uint32_t p, q, e, tail;
+    uint32_t p_len, q_len;
+
+    if (list == 0) {
+        return 0;
+    }
+
+    // merge pairs of runs, until one run is left
+    do {
+        p      = list;
+        list   = 0;
+        tail   = 0;
+        merges = 0;
+
+        while (p != 0) {
+            merges++;
+            q     = p;
+            p_len = 0;
+            while (p_len < run && q != 0) {
+                p_len++;
+                q = tos_mem_idx_to_blk(q)->sort_link;
+            }
+            q_len = run;
+
+            while (p_len > 0 || (q_len > 0 && q != 0)) {
+                if (p_len == 0 || (q_len > 0 && q != 0 && q < p)) {
+                    e = q;
+                    q = tos_mem_idx_to_blk(q)->sort_link;
+                    q_len--;
+                } else {
+                    e = p;
+                    p = tos_mem_idx_to_blk(p)->sort_link;
+                    p_len--;
+                }
+
+                if (tail != 0) {
+                    tos_mem_idx_to_blk(tail)->sort_link = e;
+                } else {
+                    list = e;
+                }
+                tail = e;
+            }
+            p = q;
+        }
+        tos_mem_idx_to_blk(tail)->sort_link = 0;
+
+        run *= 2;
+    } while (merges > 1);
+
+    return list;
+}
+
+
+/**
+ * @brief find the chunk which holds addr
+ *
+ * @param addr a block taken by compaction
+ * @return uint8_t* nullptr when addr is not in a chunk
+ * @note lock free. the chunk of a taken block is returned by nobody else, so its pages in the map do not change.
+ *       walks back no more than the pages of a chunk
+ */
+static uint8_t* tos_mem_chunk_find(uint8_t* addr) {
+    uintptr_t page = ((uintptr_t)addr - tos_mem.page_base) >> TOS_MEM_PAGE_LOG2;
+    uint8_t*  chunk;
+
+    // page wraps below 0 and stops the walk
+    while (page < tos_mem.page_num && tos_mem.page_map[page] != 0) {
+        if (tos_mem.page_map[page] & TOS_MEM_PAGE_FIRST) {
+            chunk = (uint8_t*)(tos_mem.page_base + (page << TOS_MEM_PAGE_LOG2));
+            return blk_chk_chunk(((tos_size_t*)chunk)[-1]) ? chunk : nullptr;
+        }
+        page--;
+    }
+
+    return nullptr;
+}
+
+
+/**
+ * @brief set page map of the pages in a chunk
+ *
+ * @param chunk page aligned
+ * @param bytes
+ * @param map block list index + 1, 0 when the chunk is returned
+ * @note called in critical section. the first page is flagged by caller
+ */
+static void tos_mem_page_set(uint8_t* chunk, tos_size_t bytes, uint8_t map) {
+    uint32_t page = (uint32_t)(((uintptr_t)chunk - tos_mem.page_base) >> TOS_MEM_PAGE_LOG2);
+
+    memset(&tos_mem.page_map[page], map, (bytes + TOS_MEM_PAGE_SIZE - 1) >> TOS_MEM_PAGE_LOG2);
+}
+
+
+/**
+ * @brief get page map of the page of address
+ *
+ * @param ptr
+ * @return uint32_t block list index + 1, 0 when it is not in a chunk
+ */
+static uint32_t tos_mem_page_get(void* ptr) {
+    uintptr_t page = ((uintptr_t)ptr - tos_mem.page_base) >> TOS_MEM_PAGE_LOG2;
+
+    return (page < tos_mem.page_num) ? (tos_mem.page_map[page] & ~TOS_MEM_PAGE_FIRST) : 0;
+}
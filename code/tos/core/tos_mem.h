@@ -1,56 +1,107 @@
-/**
- * @file tos_mem.h
- * @brief memory management
- *
- */
-
-#ifndef _TOS_MEM_H_
-#define _TOS_MEM_H_
-
-
-#include "tos_types.h"
-
-
-/**
- * @brief
- *
- * @param mem_start
- * @param mem_size
- * @return int
- * @note 4 byte align, the space size must be divided by min block size
- */
-int tos_mem_module_init(uint32_t mem_start, tos_size_t mem_size);
-
-/**
- * @brief
- *
- * @param nbytes 0 < nbytes <= 128
- * @return void* nullptr when fail
- */
-void* tos_mem_alloc(tos_size_t nbytes);
-
-/**
- * @brief
- *
- * @param ptr
- * @param size
- */
-void tos_mem_dealloc(void* ptr, tos_size_t size);
-
-/**
- * @brief
- *
- * @param nbytes
- * @return void*
- */
-void* tos_malloc(tos_size_t nbytes);
-
-/**
- * @brief
- *
- * @param ptr
- */
-void tos_free(void* ptr);
-
-
-#endif
+/**
+ * @file tos_mem.h
+ * @brief memory management
+ *
+ */
+
+#ifndef _TOS_MEM_H_
+#define _TOS_MEM_H_
+
+
+#include "tos_config.h"
+#include "tos_types.h"
+
+
+#define TOS_MEM_CLASS_NUM (TOS_MEM_BLOCK_MAX / 8u)   // lists of small blocks, 8, 16, 24, ... TOS_MEM_BLOCK_MAX bytes
+
+typedef struct {
+    tos_size_t free_area_bytes;                       // free bytes in the free area (TLSF)
+    tos_size_t largest_free;                          // largest free extent in the free area
+    uint32_t   free_extent_num;                       // free extents, many small ones mean fragmentation
+    tos_size_t class_free_bytes[TOS_MEM_CLASS_NUM];   // free bytes in each small block list
+    uint32_t   chunk_num;                             // chunks carved from free area for small blocks, in use
+    tos_size_t chunk_bytes;                           //
+    uint32_t   carve_cnt;                             // chunks carved since init
+    uint32_t   compact_cnt;                           // compaction passes since init
+    uint32_t   return_cnt;                            // chunks returned to free area by compaction
+    tos_size_t return_bytes;                          //
+} tos_mem_stat_t;
+
+
+/**
+ * @brief
+ *
+ * @param mem_start
+ * @param mem_size
+ * @return int
+ * @note 4 byte align, the space size must be divided by min block size, and not over 2^TOS_MEM_TLSF_FL_MAX.
+ *       the page map takes 1 byte of every 2^TOS_MEM_PAGE_LOG2 bytes at begin of the space
+ */
+int tos_mem_module_init(uintptr_t mem_start, tos_size_t mem_size);
+
+/**
+ * @brief
+ *
+ * @param nbytes nbytes > 0, blocks over TOS_MEM_BLOCK_MAX bytes are allocated by TLSF in O(1) time, 8 byte align
+ * @return void* nullptr when fail
+ * @note can be called in ISR, free it by tos_mem_dealloc with the same size. blocks <= TOS_MEM_BLOCK_MAX bytes are
+ *       lock free, irq is closed only when the block list is empty and refilled
+ */
+void* tos_mem_alloc(tos_size_t nbytes);
+
+/**
+ * @brief
+ *
+ * @param ptr
+ * @param size
+ * @note can be called in ISR, lock free for blocks <= TOS_MEM_BLOCK_MAX bytes
+ */
+void tos_mem_dealloc(void* ptr, tos_size_t size);
+
+/**
+ * @brief
+ *
+ * @param nbytes
+ * @return void* nullptr when fail
+ * @note no header, tos_free finds the size by page map. 8 byte align, 4 byte align with a magic header when
+ *       TOS_MEM_DEBUG_ENABLE
+ */
+void* tos_malloc(tos_size_t nbytes);
+
+/**
+ * @brief
+ *
+ * @param ptr
+ */
+void tos_free(void* ptr);
+
+/**
+ * @brief return chunks of small blocks to the free area when all blocks of the chunk are free
+ *
+ * @return tos_size_t bytes returned, 0 when nothing is returned, another pass is running, or called in ISR
+ * @note task context only, refused in ISR. alloc never compacts, it fails and asks for compaction, which is run
+ *       by idle task when TOS_MEM_IDLE_COMPACT_ENABLE, or by user on demand, e.g. in a low prio task.
+ *       O(n log n) of n free small blocks with irq open, irq is closed only to return one chunk at a time.
+ *       small block lists look empty to others during the pass, they carve new chunks instead or fail
+ */
+tos_size_t tos_mem_compact(void);
+
+/**
+ * @brief whether an alloc failed after the last compaction
+ *
+ * @return bool
+ * @note idle task compacts when it is true
+ */
+bool tos_mem_compact_wanted(void);
+
+/**
+ * @brief get fragmentation statistics
+ *
+ * @param stat
+ * @return int 0 when succeed, -1 when fail
+ * @note walks the block lists and the free area in critical section, for diagnosis
+ */
+int tos_mem_stat_get(tos_mem_stat_t* stat);
+
+
+#endif
@@ -0,0 +1,457 @@
+/**
+ * @file tos_msgq.c
+ * @brief message queue, fixed-size copy mode or zero-copy pointer mode
+ *
+ */
+
+#include "tos_msgq.h"
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_core_.h"
+#include "tos_pool.h"
+#include "tos_mem.h"
+#include "tos_utils.h"
+#include "tos_waitq.h"
+
+#include <string.h>
+
+
+#define MSGQ_VALID_FLAG   0x5A5A5A5A
+#define MSGQ_INVALID_FLAG 0xFFFFFFFF
+
+
+/**
+ * messages are stored in a ring buffer, slot is msg_size bytes in copy mode and a pointer in pointer mode.
+ * the queue is never full with recv_waitq not empty, and never empty with send_waitq not empty.
+ * so a sender passes the message to the pending receiver directly, and a receiver moves the message of
+ * the first pending sender to the freed slot. task_pend_data is the message address of the pending task.
+ */
+typedef struct tos_msgq_intenal_t {
+    uint32_t         valid_flag;
+    uint8_t          mode;
+    uint8_t          mem_alloced;   // buffer is alloced by tos_mem_alloc
+    uint16_t         msg_size;
+    uint16_t         slot_size;
+    uint16_t         msg_num;
+    uint16_t         count;
+    uint16_t         head;   // slot to recv
+    uint16_t         tail;   // slot to send
+    uint8_t*         buffer;
+    tos_waitq_t      send_waitq;   // pending tasks, sorted by prio
+    tos_waitq_t      recv_waitq;   // pending tasks, sorted by prio
+} tos_msgq_intenal_t;
+
+
+TOS_POOL_DEFINE(tos_msgq_pool, tos_msgq_intenal_t, TOS_MAX_MSGQ_NUM, TOS_POOL_FLAG_NONE);
+
+
+/**
+ * @brief copy message to address of receiver
+ *
+ * @param msgq_intenal
+ * @param dst receiver address
+ * @param msg sender message, the buffer itself in pointer mode
+ */
+static void tos_msgq_deliver(tos_msgq_intenal_t* msgq_intenal, void* dst, const void* msg) {
+    if (msgq_intenal->mode == TOS_MSGQ_MODE_PTR) {
+        *(void**)dst = (void*)msg;
+    } else {
+        memcpy(dst, msg, msgq_intenal->msg_size);
+    }
+}
+
+
+/**
+ * @brief put message to tail of ring buffer, called in critical section when queue is not full
+ *
+ * @param msgq_intenal
+ * @param msg
+ */
+static void tos_msgq_put(tos_msgq_intenal_t* msgq_intenal, const void* msg) {
+    uint8_t* slot = msgq_intenal->buffer + (uint32_t)msgq_intenal->tail * msgq_intenal->slot_size;
+
+    if (msgq_intenal->mode == TOS_MSGQ_MODE_PTR) {
+        *(const void**)slot = msg;
+    } else {
+        memcpy(slot, msg, msgq_intenal->msg_size);
+    }
+
+    msgq_intenal->tail = (msgq_intenal->tail + 1 == msgq_intenal->msg_num) ? 0 : msgq_intenal->tail + 1;
+    msgq_intenal->count++;
+}
+
+
+/**
+ * @brief get message from head of ring buffer, called in critical section when queue is not empty
+ *
+ * @param msgq_intenal
+ * @param msg
+ */
+static void tos_msgq_get(tos_msgq_intenal_t* msgq_intenal, void* msg) {
+    uint8_t* slot = msgq_intenal->buffer + (uint32_t)msgq_intenal->head * msgq_intenal->slot_size;
+
+    if (msgq_intenal->mode == TOS_MSGQ_MODE_PTR) {
+        *(void**)msg = *(void**)slot;
+    } else {
+        memcpy(msg, slot, msgq_intenal->msg_size);
+    }
+
+    msgq_intenal->head = (msgq_intenal->head + 1 == msgq_intenal->msg_num) ? 0 : msgq_intenal->head + 1;
+    msgq_intenal->count--;
+}
+
+
+/**
+ * @brief
+ * @note called before use any message queue
+ */
+void tos_msgq_module_init(void) {
+    tos_pool_reset(&tos_msgq_pool);
+}
+
+
+/**
+ * @brief
+ *
+ * @param msgq
+ * @param attr
+ * @return int
+ * @note attr->buffer must be 4 byte aligned with size of msg_num * msg_size (copy mode)
+ *       or msg_num * sizeof(void*) (pointer mode). when it is nullptr, the buffer is allocated by tos_mem_alloc
+ */
+int tos_msgq_init(tos_msgq_t* msgq, const tos_msgq_attr_t* attr) {
+    if (msgq == nullptr || attr == nullptr) {
+        return TOS_ERR_MSGQ_NULLPTR;
+    }
+    if (attr->msg_num == 0) {
+        return TOS_ERR_MSGQ_PARAM;
+    }
+    if (attr->mode != TOS_MSGQ_MODE_COPY && attr->mode != TOS_MSGQ_MODE_PTR) {
+        return TOS_ERR_MSGQ_PARAM;
+    }
+    // msg_size of pointer mode is 0 when buffers are not from tos_msgq_alloc, any size is served by tos_mem
+    if (attr->mode == TOS_MSGQ_MODE_COPY && attr->msg_size == 0) {
+        return TOS_ERR_MSGQ_PARAM;
+    }
+
+    uint16_t slot_size = (attr->mode == TOS_MSGQ_MODE_PTR) ? sizeof(void*) : attr->msg_size;
+    uint8_t* buffer    = attr->buffer;
+
+    if (buffer == nullptr) {
+        buffer = tos_mem_alloc((uint32_t)slot_size * attr->msg_num);
+        if (buffer == nullptr) {
+            *msgq = nullptr;
+            return TOS_ERR_MSGQ_NOFREE;
+        }
+    }
+
+    // get a free msgq
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    tos_msgq_intenal_t* msgq_intenal = tos_pool_get(&tos_msgq_pool);
+    if (msgq_intenal == nullptr) {
+        tos_leave_critical_section();
+        if (attr->buffer == nullptr) {
+            tos_mem_dealloc(buffer, (uint32_t)slot_size * attr->msg_num);
+        }
+        *msgq = nullptr;
+        return TOS_ERR_MSGQ_NOFREE;
+    }
+
+    tos_leave_critical_section();
+
+    *msgq = msgq_intenal;
+
+    msgq_intenal->mode        = attr->mode;
+    msgq_intenal->mem_alloced = (attr->buffer == nullptr);
+    msgq_intenal->msg_size    = attr->msg_size;
+    msgq_intenal->slot_size   = slot_size;
+    msgq_intenal->msg_num     = attr->msg_num;
+    msgq_intenal->count       = 0;
+    msgq_intenal->head        = 0;
+    msgq_intenal->tail        = 0;
+    msgq_intenal->buffer      = buffer;
+    tos_waitq_init(&msgq_intenal->send_waitq);
+    tos_waitq_init(&msgq_intenal->recv_waitq);
+    msgq_intenal->valid_flag = MSGQ_VALID_FLAG;
+
+    return 0;
+}
+
+
+/**
+ * @brief send a message to the tail of queue, wait if queue is full
+ *
+ * @param msgq
+ * @param msg copy mode: address of message. pointer mode: the buffer to pass, usually from tos_msgq_alloc
+ * @param try_nms TOS_MSGQ_WAIT_INFINITE, TOS_MSGQ_WAIT_IMMEDIATE or ms to wait
+ * @return int
+ * @note if a task is waiting to recv, the message is passed to it directly
+ */
+int tos_msgq_send(tos_msgq_t* msgq, const void* msg, uint32_t try_nms) {
+    if (msgq == nullptr) {
+        return TOS_ERR_MSGQ_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*msgq == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_MSGQ_NULLPTR;
+    }
+    tos_msgq_intenal_t* msgq_intenal = *msgq;
+
+    if (msgq_intenal->valid_flag != MSGQ_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_MSGQ_INVALID;
+    }
+    if (msgq_intenal->mode == TOS_MSGQ_MODE_COPY && msg == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_MSGQ_NULLPTR;
+    }
+
+    tos_task_t* current_task = (tos_state.intr_level > 0) ? nullptr : tos_get_current_task();
+
+    // 1.1 pass to the first pending receiver, which has the highest prio
+    if (!tos_waitq_is_empty(&msgq_intenal->recv_waitq)) {
+        tos_task_t* next_task = tos_waitq_first(&msgq_intenal->recv_waitq);
+
+        tos_msgq_deliver(msgq_intenal, next_task->task_pend_data, msg);
+        tos_waitq_wake(next_task);
+        tos_trace(TOS_TRACE_MSGQ_SEND, current_task, tos_pool_index(&tos_msgq_pool, msgq_intenal));
+
+        // preempt if the task has higher prio, ISR will schedule when exit
+        tos_schedule();
+        tos_leave_critical_section();
+        return 0;
+    }
+
+    // 1.2 free slot available
+    if (msgq_intenal->count < msgq_intenal->msg_num) {
+        tos_msgq_put(msgq_intenal, msg);
+        tos_trace(TOS_TRACE_MSGQ_SEND, current_task, tos_pool_index(&tos_msgq_pool, msgq_intenal));
+        tos_leave_critical_section();
+        return 0;
+    }
+
+    // 2.1 immediately
+    if (try_nms == TOS_MSGQ_WAIT_IMMEDIATE) {
+        tos_leave_critical_section();
+        return TOS_ERR_MSGQ_TIMEOUT;
+    }
+    if (current_task == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_MSGQ_ISR;
+    }
+
+    // 2.2 wait, the receiver moves the message to queue
+    current_task->task_pend_data = (void*)msg;
+    tos_trace(TOS_TRACE_MSGQ_PEND, current_task, tos_pool_index(&tos_msgq_pool, msgq_intenal));
+    tos_waitq_pend(&msgq_intenal->send_waitq,
+                   (try_nms == TOS_MSGQ_WAIT_INFINITE) ? TOS_TIME_WAIT_INFINITY : try_nms / TOS_TICK_MS);
+    tos_schedule();
+    tos_leave_critical_section();   // switch to other task here
+
+    if (current_task->task_pend_status != TOS_PEND_OK) {
+        tos_trace(TOS_TRACE_MSGQ_TIMEOUT, current_task, tos_pool_index(&tos_msgq_pool, msgq_intenal));
+        return TOS_ERR_MSGQ_TIMEOUT;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief send a message without wait
+ *
+ * @param msgq
+ * @param msg
+ * @return int TOS_ERR_MSGQ_TIMEOUT when queue is full
+ * @note can be called in ISR
+ */
+int tos_msgq_send_isr(tos_msgq_t* msgq, const void* msg) {
+    return tos_msgq_send(msgq, msg, TOS_MSGQ_WAIT_IMMEDIATE);
+}
+
+
+/**
+ * @brief recv a message from the head of queue, wait if queue is empty
+ *
+ * @param msgq
+ * @param msg copy mode: msg_size bytes to store the message. pointer mode: a void* to store the buffer
+ * @param try_nms TOS_MSGQ_WAIT_INFINITE, TOS_MSGQ_WAIT_IMMEDIATE or ms to wait
+ * @return int
+ * @note can be called in ISR with TOS_MSGQ_WAIT_IMMEDIATE
+ */
+int tos_msgq_recv(tos_msgq_t* msgq, void* msg, uint32_t try_nms) {
+    if (msgq == nullptr || msg == nullptr) {
+        return TOS_ERR_MSGQ_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*msgq == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_MSGQ_NULLPTR;
+    }
+    tos_msgq_intenal_t* msgq_intenal = *msgq;
+
+    if (msgq_intenal->valid_flag != MSGQ_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_MSGQ_INVALID;
+    }
+
+    tos_task_t* current_task = (tos_state.intr_level > 0) ? nullptr : tos_get_current_task();
+
+    // 1 message available
+    if (msgq_intenal->count > 0) {
+        tos_msgq_get(msgq_intenal, msg);
+        tos_trace(TOS_TRACE_MSGQ_RECV, current_task, tos_pool_index(&tos_msgq_pool, msgq_intenal));
+
+        // move the message of first pending sender to the freed slot
+        if (!tos_waitq_is_empty(&msgq_intenal->send_waitq)) {
+            tos_task_t* next_task = tos_waitq_first(&msgq_intenal->send_waitq);
+
+            tos_msgq_put(msgq_intenal, next_task->task_pend_data);
+            tos_waitq_wake(next_task);
+            tos_schedule();
+        }
+
+        tos_leave_critical_section();
+        return 0;
+    }
+
+    // 2.1 immediately
+    if (try_nms == TOS_MSGQ_WAIT_IMMEDIATE) {
+        tos_leave_critical_section();
+        return TOS_ERR_MSGQ_TIMEOUT;
+    }
+    if (current_task == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_MSGQ_ISR;
+    }
+
+    // 2.2 wait, the sender passes the message to current task directly
+    current_task->task_pend_data = msg;
+    tos_trace(TOS_TRACE_MSGQ_PEND, current_task, tos_pool_index(&tos_msgq_pool, msgq_intenal));
+    tos_waitq_pend(&msgq_intenal->recv_waitq,
+                   (try_nms == TOS_MSGQ_WAIT_INFINITE) ? TOS_TIME_WAIT_INFINITY : try_nms / TOS_TICK_MS);
+    tos_schedule();
+    tos_leave_critical_section();   // switch to other task here
+
+    if (current_task->task_pend_status != TOS_PEND_OK) {
+        tos_trace(TOS_TRACE_MSGQ_TIMEOUT, current_task, tos_pool_index(&tos_msgq_pool, msgq_intenal));
+        return TOS_ERR_MSGQ_TIMEOUT;
+    }
+
+    tos_trace(TOS_TRACE_MSGQ_RECV, current_task, tos_pool_index(&tos_msgq_pool, msgq_intenal));
+
+    return 0;
+}
+
+
+/**
+ * @brief alloc a buffer of msg_size from tos_mem for pointer mode
+ *
+ * @param msgq
+ * @return void* nullptr when fail
+ * @note can be called in ISR
+ */
+void* tos_msgq_alloc(tos_msgq_t* msgq) {
+    if (msgq == nullptr || *msgq == nullptr || (*msgq)->valid_flag != MSGQ_VALID_FLAG) {
+        return nullptr;
+    }
+    if ((*msgq)->mode != TOS_MSGQ_MODE_PTR) {
+        return nullptr;
+    }
+
+    return tos_mem_alloc((*msgq)->msg_size);
+}
+
+
+/**
+ * @brief free a buffer got by tos_msgq_recv in pointer mode
+ *
+ * @param msgq
+ * @param buf
+ * @note can be called in ISR
+ */
+void tos_msgq_free(tos_msgq_t* msgq, void* buf) {
+    if (msgq == nullptr || *msgq == nullptr || (*msgq)->valid_flag != MSGQ_VALID_FLAG) {
+        return;
+    }
+    if ((*msgq)->mode != TOS_MSGQ_MODE_PTR) {
+        return;
+    }
+
+    tos_mem_dealloc(buf, (*msgq)->msg_size);
+}
+
+
+/**
+ * @brief
+ *
+ * @param msgq
+ * @return int32_t messages in queue, or error code
+ */
+int32_t tos_msgq_get_count(tos_msgq_t* msgq) {
+    if (msgq == nullptr || *msgq == nullptr) {
+        return TOS_ERR_MSGQ_NULLPTR;
+    }
+    if ((*msgq)->valid_flag != MSGQ_VALID_FLAG) {
+        return TOS_ERR_MSGQ_INVALID;
+    }
+
+    return (*msgq)->count;
+}
+
+
+/**
+ * @brief
+ *
+ * @param msgq
+ * @return int
+ * @note messages left in queue are dropped, receive the buffers before destroy in pointer mode
+ */
+int tos_msgq_destroy(tos_msgq_t* msgq) {
+    if (msgq == nullptr) {
+        return TOS_ERR_MSGQ_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*msgq == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_MSGQ_NULLPTR;
+    }
+    tos_msgq_intenal_t* msgq_intenal = *msgq;
+
+    if (msgq_intenal->valid_flag != MSGQ_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_MSGQ_INVALID;
+    }
+
+    if (!tos_waitq_is_empty(&msgq_intenal->send_waitq) ||
+        !tos_waitq_is_empty(&msgq_intenal->recv_waitq)) {
+        tos_leave_critical_section();
+        return TOS_ERR_MSGQ_BLOCKING;
+    }
+
+    void*    buffer      = msgq_intenal->mem_alloced ? msgq_intenal->buffer : nullptr;
+    uint32_t buffer_size = (uint32_t)msgq_intenal->slot_size * msgq_intenal->msg_num;
+
+    msgq_intenal->valid_flag = MSGQ_INVALID_FLAG;
+    tos_pool_put(&tos_msgq_pool, msgq_intenal);
+
+    tos_leave_critical_section();
+
+    tos_mem_dealloc(buffer, buffer_size);   // nothing to do with nullptr
+
+    *msgq = nullptr;
+
+    return 0;
+}
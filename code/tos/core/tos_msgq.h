@@ -0,0 +1,117 @@
+/**
+ * @file tos_msgq.h
+ * @brief message queue, fixed-size copy mode or zero-copy pointer mode
+ *
+ */
+
+#ifndef _TOS_MSGQ_H_
+#define _TOS_MSGQ_H_
+
+
+#include "tos_types.h"
+
+
+#define TOS_ERR_MSGQ_NULLPTR  -1
+#define TOS_ERR_MSGQ_NOFREE   -2   // no free queue, or no memory for the queue buffer
+#define TOS_ERR_MSGQ_TIMEOUT  -3
+#define TOS_ERR_MSGQ_PARAM    -4
+#define TOS_ERR_MSGQ_BLOCKING -5   // task pending when destroy
+#define TOS_ERR_MSGQ_INVALID  -6
+#define TOS_ERR_MSGQ_ISR      -7   // try to block in ISR
+
+#define TOS_MSGQ_WAIT_INFINITE  0xFFFFFFFFu
+#define TOS_MSGQ_WAIT_IMMEDIATE 0
+
+// queue mode
+#define TOS_MSGQ_MODE_COPY 0x00   // msg_size bytes are copied in when send and copied out when recv
+#define TOS_MSGQ_MODE_PTR  0x01   // only pointer is queued, the buffer is owned by receiver after recv
+
+
+typedef struct tos_msgq_intenal_t* tos_msgq_t;
+
+typedef struct {
+    uint8_t  mode;       // TOS_MSGQ_MODE_xxx
+    uint16_t msg_size;   // copy mode: size of one message. pointer mode: size of buffer from tos_msgq_alloc
+    uint16_t msg_num;    // max messages in queue
+    void*    buffer;     // storage of msg_num messages (or pointers), nullptr to alloc by tos_mem_alloc
+} tos_msgq_attr_t;
+
+
+/**
+ * @brief
+ * @note called before use any message queue
+ */
+void tos_msgq_module_init(void);
+
+/**
+ * @brief
+ *
+ * @param msgq
+ * @param attr
+ * @return int
+ * @note attr->buffer must be 4 byte aligned with size of msg_num * msg_size (copy mode)
+ *       or msg_num * sizeof(void*) (pointer mode). when it is nullptr, the buffer is allocated by tos_mem_alloc
+ */
+int  tos_msgq_init(tos_msgq_t* msgq, const tos_msgq_attr_t* attr);
+
+/**
+ * @brief send a message to the tail of queue, wait if queue is full
+ *
+ * @param msgq
+ * @param msg copy mode: address of message. pointer mode: the buffer to pass, usually from tos_msgq_alloc
+ * @param try_nms TOS_MSGQ_WAIT_INFINITE, TOS_MSGQ_WAIT_IMMEDIATE or ms to wait
+ * @return int
+ * @note if a task is waiting to recv, the message is passed to it directly
+ */
+int  tos_msgq_send(tos_msgq_t* msgq, const void* msg, uint32_t try_nms);
+
+/**
+ * @brief send a message without wait
+ *
+ * @param msgq
+ * @param msg
+ * @return int TOS_ERR_MSGQ_TIMEOUT when queue is full
+ * @note can be called in ISR
+ */
+int  tos_msgq_send_isr(tos_msgq_t* msgq, const void* msg);
+
+/**
+ * @brief recv a message from the head of queue, wait if queue is empty
+ *
+ * @param msgq
+ * @param msg copy mode: msg_size bytes to store the message. pointer mode: a void* to store the buffer
+ * @param try_nms TOS_MSGQ_WAIT_INFINITE, TOS_MSGQ_WAIT_IMMEDIATE or ms to wait
+ * @return int
+ * @note can be called in ISR with TOS_MSGQ_WAIT_IMMEDIATE
+ */
+int  tos_msgq_recv(tos_msgq_t* msgq, void* msg, uint32_t try_nms);
+
+/**
+ * @brief alloc a buffer of msg_size from tos_mem for pointer mode
+ *
+ * @param msgq
+ * @return void* nullptr when fail
+ * @note can be called in ISR
+ */
+void* tos_msgq_alloc(tos_msgq_t* msgq);
+
+/**
+ * @brief free a buffer got by tos_msgq_recv in pointer mode
+ *
+ * @param msgq
+ * @param buf
+ * @note can be called in ISR
+ */
+void tos_msgq_free(tos_msgq_t* msgq, void* buf);
+
+/**
+ * @brief
+ *
+ * @param msgq
+ * @return int32_t messages in queue, or error code
+ */
+int32_t tos_msgq_get_count(tos_msgq_t* msgq);
+int  tos_msgq_destroy(tos_msgq_t* msgq);
+
+
+#endif
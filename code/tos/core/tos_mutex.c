@@ -1,265 +1,479 @@
-/**
- * @file tos_mutex.c
- * @brief
- *
- */
-
-#include "tos_mutex.h"
-#include "tos_config.h"
-#include "tos_core.h"
-#include "tos_core_.h"
-#include "tos_utils.h"
-
-#include <string.h>
-
-
-#define MUTEX_VALID_FLAG   0x5A5A5A5A
-#define MUTEX_INVALID_FLAG 0xFFFFFFFF
-
-
-typedef struct tos_mutex_intenal_t {
-    uint32_t         valid_flag;
-    bool             lock_flag;
-    tos_task_t*      owner;
-    tos_queue_node_t pending_list;
-    tos_queue_node_t queue_link;
-} tos_mutex_intenal_t;
-
-
-static tos_mutex_intenal_t tos_mutex_pool[TOS_MAX_MUTEX_NUM];
-static tos_queue_node_t    tos_free_mutex_list;
-
-
-/**
- * @brief
- * @note called before use any mutex
- */
-void tos_mutex_module_init(void) {
-    uint8_t mutex_idx = 0;
-
-    tos_queue_init(&tos_free_mutex_list);
-    memset(&tos_mutex_pool, 0, sizeof(tos_mutex_pool));
-
-    for (mutex_idx = 0; mutex_idx < sizeof(tos_mutex_pool) / sizeof(tos_mutex_pool[0]); mutex_idx++) {
-        tos_queue_insert(&tos_free_mutex_list, &tos_mutex_pool[mutex_idx].queue_link);
-    }
-}
-
-
-/**
- * @brief
- *
- * @param mutex
- * @param attr
- * @return int
- */
-int tos_mutex_init(tos_mutex_t* mutex, const tos_mutex_attr_t* attr) {
-    if (mutex == nullptr) {
-        return TOS_ERR_MUTEX_NULLPTR;
-    }
-
-    // get a free mutex
-    tos_use_critical_section();
-    tos_enter_critical_section();
-
-    if (tos_queue_is_empty(&tos_free_mutex_list)) {
-        tos_leave_critical_section();
-        *mutex = nullptr;
-        return TOS_ERR_MUTEX_NOFREE;
-    }
-    tos_mutex_intenal_t* mutex_intenal = get_object_by_field(tos_mutex_intenal_t, queue_link, tos_free_mutex_list.next);
-    tos_queue_remove(tos_free_mutex_list.next);
-
-    tos_leave_critical_section();
-
-    *mutex = mutex_intenal;
-
-    mutex_intenal->lock_flag  = false;
-    mutex_intenal->valid_flag = MUTEX_VALID_FLAG;
-    mutex_intenal->owner      = nullptr;
-    tos_queue_init(&(mutex_intenal->pending_list));
-
-    return 0;
-}
-
-
-/**
- * @brief
- *
- * @param mutex
- * @return int
- */
-int tos_mutex_lock(tos_mutex_t* mutex) {
-    return tos_mutex_trylock(mutex, TOS_TRY_LOCK_INFINITE);
-}
-
-
-/**
- * @brief
- *
- * @param mutex
- * @param try_nms
- * @return int
- */
-int tos_mutex_trylock(tos_mutex_t* mutex, uint32_t try_nms) {
-    if (mutex == nullptr) {
-        return TOS_ERR_MUTEX_NULLPTR;
-    }
-
-    tos_use_critical_section();
-    tos_enter_critical_section();
-
-    if (*mutex == nullptr) {
-        tos_leave_critical_section();
-        return TOS_ERR_MUTEX_NULLPTR;
-    }
-    tos_mutex_intenal_t* mutex_intenal = *mutex;
-
-    // mutex is invalid
-    if (mutex_intenal->valid_flag != MUTEX_VALID_FLAG) {
-        tos_leave_critical_section();
-        return TOS_ERR_MUTEX_INVALID;
-    }
-
-    // 1 mutex is usable
-    if (mutex_intenal->lock_flag == false) {
-        mutex_intenal->lock_flag = true;
-        mutex_intenal->owner     = tos_get_current_task();   // own task
-        tos_leave_critical_section();
-        return 0;
-    }
-
-    // 2 mutex is locked
-
-    // 2.1 immediately
-    if (try_nms == TOS_TRY_LOCK_IMMEDIATE) {
-        tos_leave_critical_section();
-        return TOS_ERR_MUTEX_TIMEOUT;
-    }
-
-    // 2.2 wait mutex
-    // add current task to pending list
-    tos_task_t* current_task = tos_get_current_task();
-    tos_queue_remove(&current_task->ready_pending_link);
-    if (tos_queue_is_empty(&tos_state.ready_task_list[current_task->task_prio])) {
-        tos_state.ready_task_prio_mask &= ~current_task->task_prio_mask;
-    }
-    tos_queue_insert(&mutex_intenal->pending_list, &current_task->ready_pending_link);
-
-    // add current task into waiting list
-    if (try_nms != TOS_TRY_LOCK_INFINITE) {
-        current_task->task_wait_time = try_nms / TOS_TICK_MS;
-        tos_queue_insert(&tos_state.waiting_task_list, &current_task->waiting_link);
-    }
-    tos_leave_critical_section();
-
-    tos_schedule();
-
-    return (mutex_intenal->owner == current_task) ? 0 : TOS_ERR_MUTEX_TIMEOUT;
-}
-
-
-/**
- * @brief
- *
- * @param mutex
- * @return int
- */
-int tos_mutex_unlock(tos_mutex_t* mutex) {
-    if (mutex == nullptr) {
-        return TOS_ERR_MUTEX_NULLPTR;
-    }
-
-    tos_use_critical_section();
-    tos_enter_critical_section();
-
-    if (*mutex == nullptr) {
-        tos_leave_critical_section();
-        return TOS_ERR_MUTEX_NULLPTR;
-    }
-    tos_mutex_intenal_t* mutex_intenal = *mutex;
-
-    // mutex is invalid
-    if (mutex_intenal->valid_flag != MUTEX_VALID_FLAG) {
-        tos_leave_critical_section();
-        return TOS_ERR_MUTEX_INVALID;
-    }
-
-    // mutex is unlock
-    if (mutex_intenal->lock_flag == false) {
-        tos_leave_critical_section();
-        return TOS_ERR_MUTEX_UNLOCKED;
-    }
-
-    // mutex not own by current task
-    if (mutex_intenal->owner != tos_get_current_task()) {
-        tos_leave_critical_section();
-        return TOS_ERR_MUTEX_PERM;
-    }
-
-    // pending list is empty
-    if (tos_queue_is_empty(&mutex_intenal->pending_list)) {
-        mutex_intenal->lock_flag = false;
-        mutex_intenal->owner     = nullptr;
-        tos_leave_critical_section();
-        return 0;
-    }
-
-    // active next pending task
-    tos_task_t* next_task = get_task_by_ready_pending_link(mutex_intenal->pending_list.next);
-    tos_queue_remove(&next_task->ready_pending_link);   // in blocking list now
-    tos_queue_remove(&next_task->waiting_link);
-    tos_queue_insert(&tos_state.ready_task_list[next_task->task_prio], &next_task->ready_pending_link);
-    tos_state.ready_task_prio_mask |= next_task->task_prio_mask;
-    mutex_intenal->owner = next_task;
-
-    tos_leave_critical_section();
-
-    tos_schedule();
-
-    return 0;
-}
-
-
-/**
- * @brief
- *
- * @param mutex
- * @return int
- */
-int tos_mutex_destroy(tos_mutex_t* mutex) {
-    if (mutex == nullptr) {
-        return TOS_ERR_MUTEX_NULLPTR;
-    }
-
-    tos_use_critical_section();
-    tos_enter_critical_section();
-
-    if (*mutex == nullptr) {
-        tos_leave_critical_section();
-        return TOS_ERR_MUTEX_NULLPTR;
-    }
-    tos_mutex_intenal_t* mutex_intenal = *mutex;
-
-    // mutex is invalid
-    if (mutex_intenal->valid_flag != MUTEX_VALID_FLAG) {
-        tos_leave_critical_section();
-        return TOS_ERR_MUTEX_INVALID;
-    }
-
-    // mutex is locking or pending
-    // if (!tos_queue_is_empty(&mutex_intenal->pending_list) || mutex_intenal->lock_flag == true) {
-    if (mutex_intenal->owner != nullptr) {
-        tos_leave_critical_section();
-        return TOS_ERR_MUTEX_BLOCKING;
-    }
-
-    mutex_intenal->valid_flag = MUTEX_INVALID_FLAG;
-    tos_queue_insert(&tos_free_mutex_list, &mutex_intenal->queue_link);
-
-    tos_leave_critical_section();
-
-    *mutex = nullptr;
-
-    return 0;
-}
+/**
+ * @file tos_mutex.c
+ * @brief
+ *
+ */
+
+#include "tos_mutex.h"
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_core_.h"
+#include "tos_pool.h"
+#include "tos_utils.h"
+#include "tos_waitq.h"
+
+
+#define MUTEX_VALID_FLAG   0x5A5A5A5A
+#define MUTEX_INVALID_FLAG 0xFFFFFFFF
+
+// lock_state, changed by tos_cpu_cas out of critical section when protocol is TOS_MUTEX_PROTOCOL_NONE
+#define MUTEX_STATE_UNLOCKED  0u
+#define MUTEX_STATE_LOCKED    1u
+#define MUTEX_STATE_CONTENDED 2u   // locked, and some task may be pending, unlock must take the slow path
+
+
+typedef struct tos_mutex_intenal_t {
+    uint32_t          valid_flag;
+    volatile uint32_t lock_state;   // MUTEX_STATE_xxx
+    uint8_t           protocol;
+    uint8_t           prio_ceiling;
+    tos_task_t*       owner;
+    tos_waitq_t       waitq;        // pending tasks
+    tos_queue_node_t  owner_link;   // link to mutex list of owner
+} tos_mutex_intenal_t;
+
+
+static void        tos_mutex_owner_set(tos_mutex_intenal_t* mutex_intenal, tos_task_t* task_hdl);
+static tos_task_t* tos_mutex_handover(tos_mutex_intenal_t* mutex_intenal);
+static uint8_t     tos_mutex_pending_prio(tos_mutex_intenal_t* mutex_intenal);
+
+
+TOS_POOL_DEFINE(tos_mutex_pool, tos_mutex_intenal_t, TOS_MAX_MUTEX_NUM, TOS_POOL_FLAG_NONE);
+
+
+/**
+ * @brief
+ * @note called before use any mutex
+ */
+void tos_mutex_module_init(void) {
+    tos_pool_reset(&tos_mutex_pool);
+}
+
+
+/**
+ * @brief
+ *
+ * @param mutex
+ * @param attr
+ * @return int
+ */
+int tos_mutex_init(tos_mutex_t* mutex, const tos_mutex_attr_t* attr) {
+    if (mutex == nullptr) {
+        return TOS_ERR_MUTEX_NULLPTR;
+    }
+    if (attr != nullptr && attr->protocol == TOS_MUTEX_PROTOCOL_CEILING && attr->prio_ceiling > TOS_MAX_PRIO_NUM_USED) {
+        return TOS_ERR_MUTEX_INVALID;
+    }
+
+    // get a free mutex
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    tos_mutex_intenal_t* mutex_intenal = tos_pool_get(&tos_mutex_pool);
+    if (mutex_intenal == nullptr) {
+        tos_leave_critical_section();
+        *mutex = nullptr;
+        return TOS_ERR_MUTEX_NOFREE;
+    }
+
+    tos_leave_critical_section();
+
+    *mutex = mutex_intenal;
+
+    mutex_intenal->lock_state = MUTEX_STATE_UNLOCKED;
+    mutex_intenal->valid_flag = MUTEX_VALID_FLAG;
+    mutex_intenal->owner      = nullptr;
+    tos_waitq_init(&(mutex_intenal->waitq));
+    tos_queue_init(&(mutex_intenal->owner_link));
+
+    if (attr != nullptr) {
+        mutex_intenal->protocol     = attr->protocol;
+        mutex_intenal->prio_ceiling = attr->prio_ceiling;
+    } else {
+        mutex_intenal->protocol     = TOS_MUTEX_PROTOCOL_NONE;
+        mutex_intenal->prio_ceiling = 0;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief
+ *
+ * @param mutex
+ * @return int
+ */
+int tos_mutex_lock(tos_mutex_t* mutex) {
+    return tos_mutex_trylock(mutex, TOS_TRY_LOCK_INFINITE);
+}
+
+
+/**
+ * @brief
+ *
+ * @param mutex
+ * @param try_nms
+ * @return int
+ */
+int tos_mutex_trylock(tos_mutex_t* mutex, uint32_t try_nms) {
+    if (mutex == nullptr) {
+        return TOS_ERR_MUTEX_NULLPTR;
+    }
+
+    tos_use_critical_section();
+
+    // fast path, lock a free mutex without protocol by cas, irq is not disabled
+    tos_mutex_intenal_t* mutex_fast = *mutex;
+    if (mutex_fast != nullptr && mutex_fast->valid_flag == MUTEX_VALID_FLAG &&
+        mutex_fast->protocol == TOS_MUTEX_PROTOCOL_NONE &&
+        tos_cpu_cas(&mutex_fast->lock_state, MUTEX_STATE_UNLOCKED, MUTEX_STATE_LOCKED)) {
+        mutex_fast->owner = tos_get_current_task();   // only the owner can unlock, no one else writes it now
+#if TOS_TRACE_ENABLE
+        tos_enter_critical_section();
+        tos_trace(TOS_TRACE_MUTEX_LOCK, mutex_fast->owner, tos_pool_index(&tos_mutex_pool, mutex_fast));
+        tos_leave_critical_section();
+#endif
+        return 0;
+    }
+
+    // slow path
+    tos_enter_critical_section();
+
+    if (*mutex == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_MUTEX_NULLPTR;
+    }
+    tos_mutex_intenal_t* mutex_intenal = *mutex;
+
+    // mutex is invalid
+    if (mutex_intenal->valid_flag != MUTEX_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_MUTEX_INVALID;
+    }
+
+    tos_task_t* current_task = tos_get_current_task();
+
+    // task prio is higher than ceiling
+    if (mutex_intenal->protocol == TOS_MUTEX_PROTOCOL_CEILING && current_task->task_base_prio > mutex_intenal->prio_ceiling) {
+        tos_leave_critical_section();
+        return TOS_ERR_MUTEX_CEILING;
+    }
+
+    // 1 mutex is usable
+    if (mutex_intenal->lock_state == MUTEX_STATE_UNLOCKED) {
+        mutex_intenal->lock_state = MUTEX_STATE_LOCKED;
+        tos_mutex_owner_set(mutex_intenal, current_task);   // own task
+        tos_trace(TOS_TRACE_MUTEX_LOCK, current_task, tos_pool_index(&tos_mutex_pool, mutex_intenal));
+        tos_leave_critical_section();
+        return 0;
+    }
+
+    // 2 mutex is locked
+
+    // 2.1 immediately
+    if (try_nms == TOS_TRY_LOCK_IMMEDIATE) {
+        tos_leave_critical_section();
+        return TOS_ERR_MUTEX_TIMEOUT;
+    }
+
+    // 2.2 wait mutex, the cas of owner fails from now on, so it unlocks by the slow path and wakes current task
+    mutex_intenal->lock_state = MUTEX_STATE_CONTENDED;
+
+    // add current task to wait queue
+    tos_trace(TOS_TRACE_MUTEX_PEND, current_task, tos_pool_index(&tos_mutex_pool, mutex_intenal));
+    current_task->task_pend_mutex = mutex_intenal;
+    tos_waitq_pend(&mutex_intenal->waitq,
+                   (try_nms == TOS_TRY_LOCK_INFINITE) ? TOS_TIME_WAIT_INFINITY : try_nms / TOS_TICK_MS);
+
+    // owner inherits prio of current task
+    if (mutex_intenal->protocol == TOS_MUTEX_PROTOCOL_INHERIT) {
+        tos_mutex_prio_update(mutex_intenal->owner);
+    }
+    tos_leave_critical_section();
+
+    tos_schedule();
+
+    tos_enter_critical_section();
+
+    current_task->task_pend_mutex = nullptr;
+
+    // timeout, owner does not inherit prio of current task anymore
+    if (mutex_intenal->owner != current_task) {
+        tos_trace(TOS_TRACE_MUTEX_TIMEOUT, current_task, tos_pool_index(&tos_mutex_pool, mutex_intenal));
+        if (mutex_intenal->protocol == TOS_MUTEX_PROTOCOL_INHERIT && mutex_intenal->owner != nullptr) {
+            tos_mutex_prio_update(mutex_intenal->owner);
+        }
+        tos_leave_critical_section();
+        return TOS_ERR_MUTEX_TIMEOUT;
+    }
+
+    tos_leave_critical_section();
+
+    return 0;
+}
+
+
+/**
+ * @brief
+ *
+ * @param mutex
+ * @return int
+ */
+int tos_mutex_unlock(tos_mutex_t* mutex) {
+    if (mutex == nullptr) {
+        return TOS_ERR_MUTEX_NULLPTR;
+    }
+
+    tos_use_critical_section();
+
+    // fast path, unlock a mutex without protocol and pending task by cas, irq is not disabled
+    tos_mutex_intenal_t* mutex_fast   = *mutex;
+    tos_task_t*          current_task = tos_get_current_task();
+    if (mutex_fast != nullptr && mutex_fast->valid_flag == MUTEX_VALID_FLAG &&
+        mutex_fast->protocol == TOS_MUTEX_PROTOCOL_NONE && mutex_fast->owner == current_task) {
+        mutex_fast->owner = nullptr;   // clear before unlocked, or it may overwrite the next owner
+        if (tos_cpu_cas(&mutex_fast->lock_state, MUTEX_STATE_LOCKED, MUTEX_STATE_UNLOCKED)) {
+#if TOS_TRACE_ENABLE
+            tos_enter_critical_section();
+            tos_trace(TOS_TRACE_MUTEX_UNLOCK, current_task, tos_pool_index(&tos_mutex_pool, mutex_fast));
+            tos_leave_critical_section();
+#endif
+            return 0;
+        }
+        mutex_fast->owner = current_task;   // contended, still locked, wake pending task by the slow path
+    }
+
+    // slow path
+    tos_enter_critical_section();
+
+    if (*mutex == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_MUTEX_NULLPTR;
+    }
+    tos_mutex_intenal_t* mutex_intenal = *mutex;
+
+    // mutex is invalid
+    if (mutex_intenal->valid_flag != MUTEX_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_MUTEX_INVALID;
+    }
+
+    // mutex is unlock
+    if (mutex_intenal->lock_state == MUTEX_STATE_UNLOCKED) {
+        tos_leave_critical_section();
+        return TOS_ERR_MUTEX_UNLOCKED;
+    }
+
+    // mutex not own by current task
+    if (mutex_intenal->owner != current_task) {
+        tos_leave_critical_section();
+        return TOS_ERR_MUTEX_PERM;
+    }
+
+    tos_trace(TOS_TRACE_MUTEX_UNLOCK, current_task, tos_pool_index(&tos_mutex_pool, mutex_intenal));
+
+    tos_task_t* next_task = tos_mutex_handover(mutex_intenal);
+    if (mutex_intenal->protocol != TOS_MUTEX_PROTOCOL_NONE) {
+        tos_mutex_prio_update(current_task);   // drop the raised prio
+    }
+
+    tos_leave_critical_section();
+
+    if (next_task != nullptr || mutex_intenal->protocol != TOS_MUTEX_PROTOCOL_NONE) {
+        tos_schedule();
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief
+ *
+ * @param mutex
+ * @return int
+ */
+int tos_mutex_destroy(tos_mutex_t* mutex) {
+    if (mutex == nullptr) {
+        return TOS_ERR_MUTEX_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*mutex == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_MUTEX_NULLPTR;
+    }
+    tos_mutex_intenal_t* mutex_intenal = *mutex;
+
+    // mutex is invalid
+    if (mutex_intenal->valid_flag != MUTEX_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_MUTEX_INVALID;
+    }
+
+    // mutex is locking or pending, owner may be not set yet by the fast path
+    if (mutex_intenal->lock_state != MUTEX_STATE_UNLOCKED) {
+        tos_leave_critical_section();
+        return TOS_ERR_MUTEX_BLOCKING;
+    }
+
+    mutex_intenal->valid_flag = MUTEX_INVALID_FLAG;
+    tos_pool_put(&tos_mutex_pool, mutex_intenal);
+
+    tos_leave_critical_section();
+
+    *mutex = nullptr;
+
+    return 0;
+}
+
+
+/**
+ * @brief recalculate running prio of task by its base prio and owned mutexes, pass the change to mutex owner
+ *        which the task is pending on
+ *
+ * @param task_hdl
+ * @note called in critical section
+ */
+void tos_mutex_prio_update(tos_task_t* task_hdl) {
+    tos_queue_node_t*    queue_node;
+    tos_mutex_intenal_t* mutex_intenal;
+    uint8_t              prio;
+    uint32_t             depth;
+
+    // the pending chain is no longer than task number, dynamic tasks included
+    for (depth = 0; task_hdl != nullptr && depth <= tos_state.task_number; depth++) {
+        prio = task_hdl->task_base_prio;
+
+        for (queue_node = task_hdl->task_mutex_list.next; queue_node != &task_hdl->task_mutex_list;
+             queue_node = queue_node->next) {
+            mutex_intenal = get_object_by_field(tos_mutex_intenal_t, owner_link, queue_node);
+
+            if (mutex_intenal->protocol == TOS_MUTEX_PROTOCOL_CEILING && mutex_intenal->prio_ceiling > prio) {
+                prio = mutex_intenal->prio_ceiling;
+            } else if (mutex_intenal->protocol == TOS_MUTEX_PROTOCOL_INHERIT) {
+                uint8_t pending_prio = tos_mutex_pending_prio(mutex_intenal);
+                if (pending_prio > prio) {
+                    prio = pending_prio;
+                }
+            }
+        }
+
+        if (prio == task_hdl->task_prio) {
+            break;
+        }
+        tos_task_prio_change(task_hdl, prio);
+
+        // pass to owner of the mutex which the task is pending on
+        mutex_intenal = (tos_mutex_intenal_t*)task_hdl->task_pend_mutex;
+        if (task_hdl->task_state != TOS_TASK_STATE_PENDING || mutex_intenal == nullptr ||
+            mutex_intenal->protocol != TOS_MUTEX_PROTOCOL_INHERIT) {
+            break;
+        }
+        task_hdl = mutex_intenal->owner;
+    }
+}
+
+
+/**
+ * @brief clean up mutexes of a task being deleted. the owner of the mutex which the task was pending on drops the
+ *        inherited prio, mutexes owned by the task are given to their first pending task or unlocked
+ *
+ * @param task_hdl removed from wait queue already
+ * @return true when some task is woken up as the new owner
+ * @note called in critical section. all mutexes are scanned, mutexes locked by the fast path are not linked to
+ *       their owner
+ */
+bool tos_mutex_task_delete(tos_task_t* task_hdl) {
+    tos_mutex_intenal_t* mutex_intenal = (tos_mutex_intenal_t*)task_hdl->task_pend_mutex;
+    bool                 woken         = false;
+    uint32_t             i;
+
+    task_hdl->task_pend_mutex = nullptr;
+    if (mutex_intenal != nullptr && mutex_intenal->owner != task_hdl &&
+        mutex_intenal->protocol == TOS_MUTEX_PROTOCOL_INHERIT && mutex_intenal->owner != nullptr) {
+        tos_mutex_prio_update(mutex_intenal->owner);
+    }
+
+    for (i = 0; i < tos_mutex_pool.carved; i++) {
+        mutex_intenal = &tos_mutex_pool_slots[i].obj;
+        if (mutex_intenal->valid_flag == MUTEX_VALID_FLAG && mutex_intenal->lock_state != MUTEX_STATE_UNLOCKED &&
+            mutex_intenal->owner == task_hdl) {
+            tos_trace(TOS_TRACE_MUTEX_UNLOCK, task_hdl, i);
+            if (tos_mutex_handover(mutex_intenal) != nullptr) {
+                woken = true;
+            }
+        }
+    }
+    return woken;
+}
+
+
+/**
+ * @brief give mutex to the first pending task, which has the highest prio, or unlock it when no task is pending
+ *
+ * @param mutex_intenal
+ * @return tos_task_t* the new owner, nullptr when unlocked
+ * @note called in critical section, prio of the old owner is not updated
+ */
+static tos_task_t* tos_mutex_handover(tos_mutex_intenal_t* mutex_intenal) {
+    tos_task_t* next_task;
+
+    // wait queue is empty, pending tasks may be timeout
+    if (tos_waitq_is_empty(&mutex_intenal->waitq)) {
+        mutex_intenal->lock_state = MUTEX_STATE_UNLOCKED;
+        tos_mutex_owner_set(mutex_intenal, nullptr);
+        return nullptr;
+    }
+
+    next_task = tos_waitq_wake_one(&mutex_intenal->waitq);
+    tos_mutex_owner_set(mutex_intenal, next_task);
+    if (tos_waitq_is_empty(&mutex_intenal->waitq)) {
+        mutex_intenal->lock_state = MUTEX_STATE_LOCKED;   // next owner can unlock by the fast path
+    }
+    tos_trace(TOS_TRACE_MUTEX_LOCK, next_task, tos_pool_index(&tos_mutex_pool, mutex_intenal));
+
+    if (mutex_intenal->protocol != TOS_MUTEX_PROTOCOL_NONE) {
+        tos_mutex_prio_update(next_task);   // raised by ceiling or left pending tasks
+    }
+    return next_task;
+}
+
+
+/**
+ * @brief set owner of mutex, link mutex with protocol into mutex list of owner
+ *
+ * @param mutex_intenal
+ * @param task_hdl nullptr when unlock
+ * @note called in critical section
+ */
+static void tos_mutex_owner_set(tos_mutex_intenal_t* mutex_intenal, tos_task_t* task_hdl) {
+    tos_queue_remove(&mutex_intenal->owner_link);
+    tos_queue_init(&mutex_intenal->owner_link);
+
+    mutex_intenal->owner = task_hdl;
+    // mutex without protocol does not affect prio, and the fast path does not link it
+    if (task_hdl != nullptr && mutex_intenal->protocol != TOS_MUTEX_PROTOCOL_NONE) {
+        tos_queue_insert(&task_hdl->task_mutex_list, &mutex_intenal->owner_link);
+        if (mutex_intenal->protocol == TOS_MUTEX_PROTOCOL_CEILING && mutex_intenal->prio_ceiling > task_hdl->task_prio) {
+            tos_task_prio_change(task_hdl, mutex_intenal->prio_ceiling);
+        }
+    }
+}
+
+
+/**
+ * @brief get highest prio of pending tasks
+ *
+ * @param mutex_intenal
+ * @return uint8_t 0 when no pending task
+ * @note called in critical section
+ */
+static uint8_t tos_mutex_pending_prio(tos_mutex_intenal_t* mutex_intenal) {
+    tos_task_t* first_task = tos_waitq_first(&mutex_intenal->waitq);
+
+    return (first_task != nullptr) ? first_task->task_prio : 0;
+}
@@ -1,45 +1,60 @@
-/**
- * @file tos_mutex.h
- * @brief
- *
- */
-
-#ifndef _TOS_MUTEX_H_
-#define _TOS_MUTEX_H_
-
-
-#include "tos_types.h"
-
-
-#define TOS_ERR_MUTEX_NULLPTR  -1
-#define TOS_ERR_MUTEX_NOFREE   -2
-#define TOS_ERR_MUTEX_TIMEOUT  -3
-#define TOS_ERR_MUTEX_UNLOCKED -4   // try to unlock an unlocked mutex
-#define TOS_ERR_MUTEX_PERM     -5   // permission, not the mutex owner
-#define TOS_ERR_MUTEX_BLOCKING -6   // blocking when destroy
-#define TOS_ERR_MUTEX_INVALID  -7
-
-#define TOS_TRY_LOCK_INFINITE  0xFFFFFFFFu
-#define TOS_TRY_LOCK_IMMEDIATE 0
-
-
-typedef struct tos_mutex_intenal_t* tos_mutex_t;
-
-typedef struct {
-    uint8_t resv;
-} tos_mutex_attr_t;
-
-
-/**
- * @brief
- * @note called before use any mutex
- */
-void tos_mutex_module_init(void);
-int  tos_mutex_init(tos_mutex_t* mutex, const tos_mutex_attr_t* attr);
-int  tos_mutex_lock(tos_mutex_t* mutex);
-int  tos_mutex_trylock(tos_mutex_t* mutex, uint32_t try_nms);
-int  tos_mutex_unlock(tos_mutex_t* mutex);
-int  tos_mutex_destroy(tos_mutex_t* mutex);
-
-
-#endif
+/**
+ * @file tos_mutex.h
+ * @brief
+ *
+ */
+
+#ifndef _TOS_MUTEX_H_
+#define _TOS_MUTEX_H_
+
+
+#include "tos_types.h"
+
+
+#define TOS_ERR_MUTEX_NULLPTR  -1
+#define TOS_ERR_MUTEX_NOFREE   -2
+#define TOS_ERR_MUTEX_TIMEOUT  -3
+#define TOS_ERR_MUTEX_UNLOCKED -4   // try to unlock an unlocked mutex
+#define TOS_ERR_MUTEX_PERM     -5   // permission, not the mutex owner
+#define TOS_ERR_MUTEX_BLOCKING -6   // blocking when destroy
+#define TOS_ERR_MUTEX_INVALID  -7
+#define TOS_ERR_MUTEX_CEILING  -8   // prio of task is higher than prio ceiling
+
+#define TOS_TRY_LOCK_INFINITE  0xFFFFFFFFu
+#define TOS_TRY_LOCK_IMMEDIATE 0
+
+// protocol against priority inversion
+#define TOS_MUTEX_PROTOCOL_NONE    0   // no protocol
+#define TOS_MUTEX_PROTOCOL_INHERIT 1   // owner inherits the highest prio of pending tasks, also through nested mutexes
+#define TOS_MUTEX_PROTOCOL_CEILING 2   // owner runs at prio_ceiling immediately once locked
+
+
+typedef struct tos_mutex_intenal_t* tos_mutex_t;
+
+typedef struct {
+    uint8_t protocol;       // TOS_MUTEX_PROTOCOL_xxx
+    uint8_t prio_ceiling;   // used by TOS_MUTEX_PROTOCOL_CEILING, no less than prio of any task which locks it
+} tos_mutex_attr_t;
+
+
+/**
+ * @brief
+ * @note called before use any mutex
+ */
+void tos_mutex_module_init(void);
+
+/**
+ * @brief
+ *
+ * @param mutex
+ * @param attr nullptr for TOS_MUTEX_PROTOCOL_NONE
+ * @return int
+ */
+int  tos_mutex_init(tos_mutex_t* mutex, const tos_mutex_attr_t* attr);
+int  tos_mutex_lock(tos_mutex_t* mutex);
+int  tos_mutex_trylock(tos_mutex_t* mutex, uint32_t try_nms);
+int  tos_mutex_unlock(tos_mutex_t* mutex);
+int  tos_mutex_destroy(tos_mutex_t* mutex);
+
+
+#endif
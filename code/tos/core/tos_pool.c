@@ -0,0 +1,195 @@
+/**
+ * @file tos_pool.c
+ * @brief fixed size object pool
+ *
+ */
+
+#include "tos_pool.h"
+#include "tos_core.h"
+
+#include <string.h>
+
+
+#define tos_pool_slot_of(pool, obj) ((tos_pool_link_t*)((uint8_t*)(obj) - (pool)->obj_offset))
+
+
+/**
+ * @brief
+ *
+ * @param pool
+ */
+void tos_pool_reset(tos_pool_t* pool) {
+    if (pool == nullptr) {
+        return;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    memset(pool->slots, 0, pool->slot_size * pool->num);
+    pool->free_list = nullptr;
+    pool->carved    = 0;
+    pool->used      = 0;
+    pool->used_peak = 0;
+    pool->get_fail  = 0;
+
+    tos_leave_critical_section();
+}
+
+
+/**
+ * @brief take a slot from free list, or the first slot never got
+ *
+ * @param pool
+ * @return void*
+ * @note caller serializes
+ */
+static void* tos_pool_get_(tos_pool_t* pool) {
+    tos_pool_link_t* slot = nullptr;
+
+    if (pool->free_list != nullptr) {
+        slot            = pool->free_list;
+        pool->free_list = slot->next;
+    } else if (pool->carved < pool->num) {
+        slot = (tos_pool_link_t*)(pool->slots + pool->carved * pool->slot_size);
+        pool->carved++;
+    } else {
+        pool->get_fail++;
+        return nullptr;
+    }
+
+    slot->next = (tos_pool_link_t*)pool;   // mark used, checked by put
+    pool->used++;
+    if (pool->used > pool->used_peak) {
+        pool->used_peak = pool->used;
+    }
+
+    return (uint8_t*)slot + pool->obj_offset;
+}
+
+
+/**
+ * @brief link slot to free list
+ *
+ * @param pool
+ * @param slot
+ * @return int
+ * @note caller serializes
+ */
+static int tos_pool_put_(tos_pool_t* pool, tos_pool_link_t* slot) {
+    // link of a free slot is another slot or nullptr
+    if (slot->next != (tos_pool_link_t*)pool) {
+        return TOS_ERR_POOL_INVALID;
+    }
+
+    slot->next      = pool->free_list;
+    pool->free_list = slot;
+    pool->used--;
+
+    return 0;
+}
+
+
+/**
+ * @brief
+ *
+ * @param pool
+ * @return void*
+ */
+void* tos_pool_get(tos_pool_t* pool) {
+    void* obj = nullptr;
+
+    if (pool == nullptr) {
+        return nullptr;
+    }
+
+    if (!(pool->flags & TOS_POOL_FLAG_ISR_SAFE)) {
+        return tos_pool_get_(pool);
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    obj = tos_pool_get_(pool);
+
+    tos_leave_critical_section();
+
+    return obj;
+}
+
+
+/**
+ * @brief
+ *
+ * @param pool
+ * @param obj
+ * @return int
+ */
+int tos_pool_put(tos_pool_t* pool, void* obj) {
+    int ret = 0;
+
+    if (pool == nullptr || obj == nullptr) {
+        return TOS_ERR_POOL_NULLPTR;
+    }
+
+    tos_pool_link_t* slot   = tos_pool_slot_of(pool, obj);
+    uintptr_t        offset = (uintptr_t)slot - (uintptr_t)pool->slots;
+
+    // out of pool or not at begin of a slot
+    if ((uintptr_t)slot < (uintptr_t)pool->slots || offset >= (uintptr_t)pool->num * pool->slot_size ||
+        offset % pool->slot_size != 0) {
+        return TOS_ERR_POOL_INVALID;
+    }
+
+    if (!(pool->flags & TOS_POOL_FLAG_ISR_SAFE)) {
+        return tos_pool_put_(pool, slot);
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    ret = tos_pool_put_(pool, slot);
+
+    tos_leave_critical_section();
+
+    return ret;
+}
+
+
+/**
+ * @brief
+ *
+ * @param pool
+ * @param obj
+ * @return uint32_t
+ */
+uint32_t tos_pool_index(const tos_pool_t* pool, const void* obj) {
+    return (uint32_t)(((const uint8_t*)obj - pool->obj_offset - pool->slots) / pool->slot_size);
+}
+
+
+/**
+ * @brief
+ *
+ * @param pool
+ * @param stat
+ * @return int
+ */
+int tos_pool_stat_get(tos_pool_t* pool, tos_pool_stat_t* stat) {
+    if (pool == nullptr || stat == nullptr) {
+        return TOS_ERR_POOL_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    stat->slot_size = pool->slot_size;
+    stat->num       = pool->num;
+    stat->used      = pool->used;
+    stat->used_peak = pool->used_peak;
+    stat->get_fail  = pool->get_fail;
+
+    tos_leave_critical_section();
+
+    return 0;
+}
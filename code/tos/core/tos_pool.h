@@ -0,0 +1,124 @@
+/**
+ * @file tos_pool.h
+ * @brief fixed size object pool, N objects of type T are declared at compile time
+ *
+ */
+
+#ifndef _TOS_POOL_H_
+#define _TOS_POOL_H_
+
+
+#include "tos_types.h"
+
+#include <stddef.h>
+
+
+#define TOS_ERR_POOL_NULLPTR -1
+#define TOS_ERR_POOL_INVALID -2   // object is not from the pool, or put twice
+
+// pool flags
+#define TOS_POOL_FLAG_NONE     0x00u   // get and put are serialized by caller, e.g. in critical section or one task
+#define TOS_POOL_FLAG_ISR_SAFE 0x01u   // get and put enter critical section, callable from task and ISR
+
+
+// link before each object, next free slot when free, the pool when used
+typedef struct tos_pool_link_t {
+    struct tos_pool_link_t* next;
+} tos_pool_link_t;
+
+typedef struct {
+    tos_pool_link_t* free_list;   // put slots, LIFO
+    uint8_t*         slots;       // slot array, a slot is the link and an object
+    uint32_t         slot_size;   // bytes
+    uint32_t         obj_offset;  // offset of object in slot
+    uint32_t         num;         // slots in pool
+    uint32_t         carved;      // slots [0, carved) have been got once, the rest are free and not linked
+    uint32_t         used;        // objects got and not put
+    uint32_t         used_peak;   // max used since init
+    uint32_t         get_fail;    // get returns nullptr because pool is empty
+    uint32_t         flags;       // TOS_POOL_FLAG_xxx
+} tos_pool_t;
+
+typedef struct {
+    uint32_t slot_size;   // bytes of object and its link
+    uint32_t num;
+    uint32_t used;
+    uint32_t used_peak;
+    uint32_t get_fail;
+} tos_pool_stat_t;
+
+
+/**
+ * define a pool of num objects of type in file scope, all storage is static and inited at compile time.
+ * free slots are linked when they are put, the first get of each slot takes it from the untouched tail
+ * of slot array, so there is no init loop at startup
+ *
+ * @param name pool variable, tos_pool_t, use &name in tos_pool_xxx
+ * @param type object type
+ * @param num number of objects
+ * @param flags TOS_POOL_FLAG_xxx
+ */
+#define TOS_POOL_DEFINE(name, type, num, flags)                                                                        \
+    typedef struct {                                                                                                   \
+        tos_pool_link_t link;                                                                                          \
+        type            obj;                                                                                           \
+    } name##_slot_t;                                                                                                   \
+    static name##_slot_t name##_slots[(num)];                                                                          \
+    static tos_pool_t    name = {nullptr,                                                                              \
+                                 (uint8_t*)name##_slots,                                                               \
+                                 sizeof(name##_slot_t),                                                                \
+                                 offsetof(name##_slot_t, obj),                                                         \
+                                 (num),                                                                                \
+                                 0,                                                                                    \
+                                 0,                                                                                    \
+                                 0,                                                                                    \
+                                 0,                                                                                    \
+                                 (flags)}
+
+
+/**
+ * @brief put back all objects and clear the statistics, objects are set to 0
+ *
+ * @param pool
+ * @note not needed for a pool defined by TOS_POOL_DEFINE before its first use
+ */
+void tos_pool_reset(tos_pool_t* pool);
+
+/**
+ * @brief get a free object, O(1)
+ *
+ * @param pool
+ * @return void* nullptr when pool is empty. content of the object is left by its last user, 0 for the first get
+ */
+void* tos_pool_get(tos_pool_t* pool);
+
+/**
+ * @brief put an object back to pool, O(1)
+ *
+ * @param pool
+ * @param obj returned by tos_pool_get of the same pool
+ * @return int 0 when succeed, TOS_ERR_POOL_xxx when fail
+ * @note object memory is not changed, so a stale handle can still check valid flag of the object
+ */
+int tos_pool_put(tos_pool_t* pool, void* obj);
+
+/**
+ * @brief index of object in pool, 0 ~ num-1
+ *
+ * @param pool
+ * @param obj
+ * @return uint32_t
+ */
+uint32_t tos_pool_index(const tos_pool_t* pool, const void* obj);
+
+/**
+ * @brief get usage statistics of pool
+ *
+ * @param pool
+ * @param stat
+ * @return int 0 when succeed, TOS_ERR_POOL_NULLPTR when fail
+ */
+int tos_pool_stat_get(tos_pool_t* pool, tos_pool_stat_t* stat);
+
+
+#endif
@@ -0,0 +1,256 @@
+/**
+ * @file tos_sem.c
+ * @brief counting semaphore
+ *
+ */
+
+#include "tos_sem.h"
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_core_.h"
+#include "tos_pool.h"
+#include "tos_utils.h"
+#include "tos_waitq.h"
+
+
+#define SEM_VALID_FLAG   0x5A5A5A5A
+#define SEM_INVALID_FLAG 0xFFFFFFFF
+
+
+typedef struct tos_sem_intenal_t {
+    uint32_t         valid_flag;
+    uint32_t         count;
+    uint32_t         max_count;      // 0xFFFFFFFF for no limit
+    tos_waitq_t      waitq;          // pending tasks, sorted by prio
+} tos_sem_intenal_t;
+
+
+TOS_POOL_DEFINE(tos_sem_pool, tos_sem_intenal_t, TOS_MAX_SEM_NUM, TOS_POOL_FLAG_NONE);
+
+
+/**
+ * @brief
+ * @note called before use any semaphore
+ */
+void tos_sem_module_init(void) {
+    tos_pool_reset(&tos_sem_pool);
+}
+
+
+/**
+ * @brief
+ *
+ * @param sem
+ * @param attr nullptr for count 0 without limit
+ * @return int
+ */
+int tos_sem_init(tos_sem_t* sem, const tos_sem_attr_t* attr) {
+    if (sem == nullptr) {
+        return TOS_ERR_SEM_NULLPTR;
+    }
+    if (attr != nullptr && attr->max_count != 0 && attr->init_count > attr->max_count) {
+        return TOS_ERR_SEM_INVALID;
+    }
+
+    // get a free sem
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    tos_sem_intenal_t* sem_intenal = tos_pool_get(&tos_sem_pool);
+    if (sem_intenal == nullptr) {
+        tos_leave_critical_section();
+        *sem = nullptr;
+        return TOS_ERR_SEM_NOFREE;
+    }
+
+    tos_leave_critical_section();
+
+    *sem = sem_intenal;
+
+    if (attr != nullptr) {
+        sem_intenal->count     = attr->init_count;
+        sem_intenal->max_count = (attr->max_count != 0) ? attr->max_count : 0xFFFFFFFFu;
+    } else {
+        sem_intenal->count     = 0;
+        sem_intenal->max_count = 0xFFFFFFFFu;
+    }
+    tos_waitq_init(&sem_intenal->waitq);
+    sem_intenal->valid_flag = SEM_VALID_FLAG;
+
+    return 0;
+}
+
+
+/**
+ * @brief take one count, wait if count is 0
+ *
+ * @param sem
+ * @param try_nms TOS_SEM_WAIT_INFINITE, TOS_SEM_WAIT_IMMEDIATE or ms to wait
+ * @return int
+ * @note can be called in ISR with TOS_SEM_WAIT_IMMEDIATE
+ */
+int tos_sem_take(tos_sem_t* sem, uint32_t try_nms) {
+    if (sem == nullptr) {
+        return TOS_ERR_SEM_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*sem == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_SEM_NULLPTR;
+    }
+    tos_sem_intenal_t* sem_intenal = *sem;
+
+    if (sem_intenal->valid_flag != SEM_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_SEM_INVALID;
+    }
+
+    tos_task_t* current_task = tos_get_current_task();
+
+    // 1 count available
+    if (sem_intenal->count > 0) {
+        sem_intenal->count--;
+        tos_trace(TOS_TRACE_SEM_TAKE, current_task, tos_pool_index(&tos_sem_pool, sem_intenal));
+        tos_leave_critical_section();
+        return 0;
+    }
+
+    // 2.1 immediately
+    if (try_nms == TOS_SEM_WAIT_IMMEDIATE) {
+        tos_leave_critical_section();
+        return TOS_ERR_SEM_TIMEOUT;
+    }
+    if (tos_state.intr_level > 0) {
+        tos_leave_critical_section();
+        return TOS_ERR_SEM_ISR;
+    }
+
+    // 2.2 wait, the giver passes the count to current task directly
+    tos_trace(TOS_TRACE_SEM_PEND, current_task, tos_pool_index(&tos_sem_pool, sem_intenal));
+    tos_waitq_pend(&sem_intenal->waitq,
+                   (try_nms == TOS_SEM_WAIT_INFINITE) ? TOS_TIME_WAIT_INFINITY : try_nms / TOS_TICK_MS);
+    tos_schedule();
+    tos_leave_critical_section();   // switch to other task here
+
+    if (current_task->task_pend_status != TOS_PEND_OK) {
+        tos_trace(TOS_TRACE_SEM_TIMEOUT, current_task, tos_pool_index(&tos_sem_pool, sem_intenal));
+        return TOS_ERR_SEM_TIMEOUT;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief give one count, or pass it to the highest prio pending task directly
+ *
+ * @param sem
+ * @return int
+ * @note can be called in ISR
+ */
+int tos_sem_give(tos_sem_t* sem) {
+    if (sem == nullptr) {
+        return TOS_ERR_SEM_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*sem == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_SEM_NULLPTR;
+    }
+    tos_sem_intenal_t* sem_intenal = *sem;
+
+    if (sem_intenal->valid_flag != SEM_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_SEM_INVALID;
+    }
+
+    tos_trace(TOS_TRACE_SEM_GIVE, (tos_state.intr_level > 0) ? nullptr : tos_get_current_task(),
+              tos_pool_index(&tos_sem_pool, sem_intenal));
+
+    // pending list is empty
+    if (tos_waitq_is_empty(&sem_intenal->waitq)) {
+        if (sem_intenal->count >= sem_intenal->max_count) {
+            tos_leave_critical_section();
+            return TOS_ERR_SEM_OVERFLOW;
+        }
+        sem_intenal->count++;
+        tos_leave_critical_section();
+        return 0;
+    }
+
+    // active the first pending task, which has the highest prio
+    tos_task_t* next_task = tos_waitq_first(&sem_intenal->waitq);
+    tos_waitq_wake(next_task);
+
+    // preempt if the task has higher prio, ISR will schedule when exit
+    tos_schedule();
+
+    tos_leave_critical_section();
+
+    return 0;
+}
+
+
+/**
+ * @brief
+ *
+ * @param sem
+ * @return int32_t count, or error code
+ */
+int32_t tos_sem_get_count(tos_sem_t* sem) {
+    if (sem == nullptr || *sem == nullptr) {
+        return TOS_ERR_SEM_NULLPTR;
+    }
+    if ((*sem)->valid_flag != SEM_VALID_FLAG) {
+        return TOS_ERR_SEM_INVALID;
+    }
+
+    return ((*sem)->count > 0x7FFFFFFFu) ? 0x7FFFFFFF : (int32_t)(*sem)->count;
+}
+
+
+/**
+ * @brief
+ *
+ * @param sem
+ * @return int
+ */
+int tos_sem_destroy(tos_sem_t* sem) {
+    if (sem == nullptr) {
+        return TOS_ERR_SEM_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*sem == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_SEM_NULLPTR;
+    }
+    tos_sem_intenal_t* sem_intenal = *sem;
+
+    if (sem_intenal->valid_flag != SEM_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_SEM_INVALID;
+    }
+
+    if (!tos_waitq_is_empty(&sem_intenal->waitq)) {
+        tos_leave_critical_section();
+        return TOS_ERR_SEM_BLOCKING;
+    }
+
+    sem_intenal->valid_flag = SEM_INVALID_FLAG;
+    tos_pool_put(&tos_sem_pool, sem_intenal);
+
+    tos_leave_critical_section();
+
+    *sem = nullptr;
+
+    return 0;
+}
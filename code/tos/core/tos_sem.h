@@ -0,0 +1,78 @@
+/**
+ * @file tos_sem.h
+ * @brief counting semaphore
+ *
+ */
+
+#ifndef _TOS_SEM_H_
+#define _TOS_SEM_H_
+
+
+#include "tos_types.h"
+
+
+#define TOS_ERR_SEM_NULLPTR  -1
+#define TOS_ERR_SEM_NOFREE   -2
+#define TOS_ERR_SEM_TIMEOUT  -3
+#define TOS_ERR_SEM_OVERFLOW -4   // count is max_count when give
+#define TOS_ERR_SEM_BLOCKING -5   // task pending when destroy
+#define TOS_ERR_SEM_INVALID  -6
+#define TOS_ERR_SEM_ISR      -7   // try to block in ISR
+
+#define TOS_SEM_WAIT_INFINITE  0xFFFFFFFFu
+#define TOS_SEM_WAIT_IMMEDIATE 0
+
+
+typedef struct tos_sem_intenal_t* tos_sem_t;
+
+typedef struct {
+    uint32_t init_count;
+    uint32_t max_count;   // 0 for no limit, 1 for binary semaphore
+} tos_sem_attr_t;
+
+
+/**
+ * @brief
+ * @note called before use any semaphore
+ */
+void tos_sem_module_init(void);
+
+/**
+ * @brief
+ *
+ * @param sem
+ * @param attr nullptr for count 0 without limit
+ * @return int
+ */
+int  tos_sem_init(tos_sem_t* sem, const tos_sem_attr_t* attr);
+
+/**
+ * @brief take one count, wait if count is 0
+ *
+ * @param sem
+ * @param try_nms TOS_SEM_WAIT_INFINITE, TOS_SEM_WAIT_IMMEDIATE or ms to wait
+ * @return int
+ * @note can be called in ISR with TOS_SEM_WAIT_IMMEDIATE
+ */
+int  tos_sem_take(tos_sem_t* sem, uint32_t try_nms);
+
+/**
+ * @brief give one count, or pass it to the highest prio pending task directly
+ *
+ * @param sem
+ * @return int
+ * @note can be called in ISR
+ */
+int  tos_sem_give(tos_sem_t* sem);
+
+/**
+ * @brief
+ *
+ * @param sem
+ * @return int32_t count, or error code
+ */
+int32_t tos_sem_get_count(tos_sem_t* sem);
+int  tos_sem_destroy(tos_sem_t* sem);
+
+
+#endif
@@ -0,0 +1,482 @@
+/**
+ * @file tos_timer.c
+ * @brief software timer
+ * @note hierarchical timing wheel: level 0 slot is one tick, slot of level n is (1 << TOS_TIMER_WHEEL_BITS) slots of
+ *       level n-1. timers in level n slot cascade to lower levels when level n-1 turns around, so start, stop and
+ *       expire are O(1)
+ */
+
+#include "tos_timer.h"
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_core_.h"
+#include "tos_pool.h"
+#include "tos_utils.h"
+
+
+#if TOS_TIMER_ENABLE
+
+#define TIMER_VALID_FLAG   0x5A5A5A5A
+#define TIMER_INVALID_FLAG 0xFFFFFFFF
+
+#define TIMER_STATE_STOPPED 0   // not in any list
+#define TIMER_STATE_ACTIVE  1   // in wheel
+#define TIMER_STATE_EXPIRED 2   // in expired list, callback not called yet
+
+#define TOS_TIMER_WHEEL_LEVEL 4u
+#define TOS_TIMER_WHEEL_SLOT  (1u << TOS_TIMER_WHEEL_BITS)
+#define TOS_TIMER_WHEEL_MASK  (TOS_TIMER_WHEEL_SLOT - 1u)
+#define TOS_TIMER_WHEEL_MAX   ((1u << (TOS_TIMER_WHEEL_BITS * TOS_TIMER_WHEEL_LEVEL)) - 1u)   // ticks, wheel range
+
+// slot index of level for the tick
+#define tos_timer_wheel_index(tick, level) (((tick) >> (TOS_TIMER_WHEEL_BITS * (level))) & TOS_TIMER_WHEEL_MASK)
+
+#if TOS_TIMER_WHEEL_BITS < 1 || TOS_TIMER_WHEEL_BITS > 8
+#error "TOS_TIMER_WHEEL_BITS should be 1~8"
+#endif
+
+
+typedef struct tos_timer_intenal_t {
+    uint32_t             valid_flag;
+    uint8_t              mode;
+    uint8_t              state;
+    uint32_t             period;       // ticks
+    uint32_t             expire;       // tick to expire
+    tos_timer_callback_t callback;
+    void*                arg;
+    tos_queue_node_t     timer_link;   // link to wheel slot or expired list
+} tos_timer_intenal_t;
+
+
+static void tos_timer_task_proc(void* args);
+static void tos_timer_wheel_insert(tos_timer_intenal_t* timer_intenal);
+static void tos_timer_wheel_remove(tos_timer_intenal_t* timer_intenal);
+static bool tos_timer_wheel_cascade(uint32_t level);
+static void tos_timer_wheel_step(void);
+
+
+TOS_POOL_DEFINE(tos_timer_pool, tos_timer_intenal_t, TOS_MAX_TIMER_NUM, TOS_POOL_FLAG_NONE);
+static tos_queue_node_t    tos_timer_wheel[TOS_TIMER_WHEEL_LEVEL][TOS_TIMER_WHEEL_SLOT];
+static tos_queue_node_t    tos_timer_expired_list;   // expired timers, wait for timer task
+static uint32_t            tos_timer_jiffies;        // next tick to process, the current tick is (jiffies - 1)
+static tos_task_t*         tos_timer_task;           //
+static tos_stack_t         tos_timer_task_stack[TOS_TIMER_TASK_STACK_SIZE / sizeof(tos_stack_t)];
+
+
+/**
+ * @brief create the timer task
+ * @note called after tos_init, before use any timer
+ */
+void tos_timer_module_init(void) {
+    uint32_t        idx;
+    uint32_t        level;
+    tos_task_attr_t task_attr;
+
+    tos_pool_reset(&tos_timer_pool);
+    for (level = 0; level < TOS_TIMER_WHEEL_LEVEL; level++) {
+        for (idx = 0; idx < TOS_TIMER_WHEEL_SLOT; idx++) {
+            tos_queue_init(&tos_timer_wheel[level][idx]);
+        }
+    }
+    tos_queue_init(&tos_timer_expired_list);
+    tos_timer_jiffies = 1;
+
+    task_attr.task_name       = "timer_task";
+    task_attr.task_wait_time  = 0;
+    task_attr.task_time_slice = 0;
+    task_attr.task_period     = 0;
+    task_attr.task_prio       = TOS_TIMER_TASK_PRIO;
+    task_attr.task_stack_size = sizeof(tos_timer_task_stack);
+    task_attr.task_stack      = tos_timer_task_stack;
+
+    tos_timer_task = tos_task_create(tos_timer_task_proc, nullptr, &task_attr);
+    if (tos_timer_task == nullptr) {
+        tos_error("timer task create error!");
+    }
+}
+
+
+/**
+ * @brief
+ *
+ * @param timer
+ * @param attr
+ * @return int
+ * @note the timer is stopped after created
+ */
+int tos_timer_create(tos_timer_t* timer, const tos_timer_attr_t* attr) {
+    if (timer == nullptr || attr == nullptr) {
+        return TOS_ERR_TIMER_NULLPTR;
+    }
+    if (attr->callback == nullptr || attr->mode > TOS_TIMER_AUTO_RELOAD) {
+        return TOS_ERR_TIMER_PARAM;
+    }
+
+    // get a free timer
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    tos_timer_intenal_t* timer_intenal = tos_pool_get(&tos_timer_pool);
+    if (timer_intenal == nullptr) {
+        tos_leave_critical_section();
+        *timer = nullptr;
+        return TOS_ERR_TIMER_NOFREE;
+    }
+
+    tos_leave_critical_section();
+
+    *timer = timer_intenal;
+
+    timer_intenal->mode     = attr->mode;
+    timer_intenal->state    = TIMER_STATE_STOPPED;
+    timer_intenal->period   = (attr->period_nms / TOS_TICK_MS != 0) ? attr->period_nms / TOS_TICK_MS : 1;
+    timer_intenal->expire   = 0;
+    timer_intenal->callback = attr->callback;
+    timer_intenal->arg      = attr->arg;
+    tos_queue_init(&timer_intenal->timer_link);
+    timer_intenal->valid_flag = TIMER_VALID_FLAG;
+
+    return 0;
+}
+
+
+/**
+ * @brief start timer, expire after period from now. restart if it is running
+ *
+ * @param timer
+ * @return int
+ * @note can be called in ISR
+ */
+int tos_timer_start(tos_timer_t* timer) {
+    return tos_timer_reset(timer, 0);
+}
+
+
+/**
+ * @brief
+ *
+ * @param timer
+ * @return int
+ * @note can be called in ISR. an expired timer waiting for timer task is not called, but the callback may run
+ *       once more after stopped, if timer task has taken the timer and is calling it (stopped from ISR or a higher
+ *       prio task)
+ */
+int tos_timer_stop(tos_timer_t* timer) {
+    if (timer == nullptr) {
+        return TOS_ERR_TIMER_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*timer == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_TIMER_NULLPTR;
+    }
+    tos_timer_intenal_t* timer_intenal = *timer;
+
+    if (timer_intenal->valid_flag != TIMER_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_TIMER_INVALID;
+    }
+
+    tos_timer_wheel_remove(timer_intenal);
+
+    tos_leave_critical_section();
+
+    return 0;
+}
+
+
+/**
+ * @brief restart timer with new period
+ *
+ * @param timer
+ * @param period_nms 0 to keep the period
+ * @return int
+ * @note can be called in ISR
+ */
+int tos_timer_reset(tos_timer_t* timer, uint32_t period_nms) {
+    if (timer == nullptr) {
+        return TOS_ERR_TIMER_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*timer == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_TIMER_NULLPTR;
+    }
+    tos_timer_intenal_t* timer_intenal = *timer;
+
+    if (timer_intenal->valid_flag != TIMER_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_TIMER_INVALID;
+    }
+
+    if (period_nms != 0) {
+        timer_intenal->period = (period_nms / TOS_TICK_MS != 0) ? period_nms / TOS_TICK_MS : 1;
+    }
+
+    tos_timer_wheel_remove(timer_intenal);
+    timer_intenal->expire = tos_timer_jiffies - 1 + timer_intenal->period;
+    tos_timer_wheel_insert(timer_intenal);
+
+    tos_leave_critical_section();
+
+    return 0;
+}
+
+
+/**
+ * @brief
+ *
+ * @param timer
+ * @return int
+ */
+int tos_timer_destroy(tos_timer_t* timer) {
+    if (timer == nullptr) {
+        return TOS_ERR_TIMER_NULLPTR;
+    }
+
+    tos_use_critical_section();
+    tos_enter_critical_section();
+
+    if (*timer == nullptr) {
+        tos_leave_critical_section();
+        return TOS_ERR_TIMER_NULLPTR;
+    }
+    tos_timer_intenal_t* timer_intenal = *timer;
+
+    if (timer_intenal->valid_flag != TIMER_VALID_FLAG) {
+        tos_leave_critical_section();
+        return TOS_ERR_TIMER_INVALID;
+    }
+
+    tos_timer_wheel_remove(timer_intenal);
+    timer_intenal->valid_flag = TIMER_INVALID_FLAG;
+    tos_pool_put(&tos_timer_pool, timer_intenal);
+
+    tos_leave_critical_section();
+
+    *timer = nullptr;
+
+    return 0;
+}
+
+
+/**
+ * @brief advance the wheel, move expired timers to expired list and wake up timer task
+ *
+ * @param ticks ticks passed
+ * @note called in critical section. implement in tos_timer.c
+ */
+void tos_timer_tick(uint32_t ticks) {
+    if (tos_timer_task == nullptr) {
+        return;   // module not inited
+    }
+
+    while (ticks-- > 0) {
+        tos_timer_wheel_step();
+    }
+
+    // timer task is pending for expired timers
+    if (!tos_queue_is_empty(&tos_timer_expired_list) && tos_timer_task->task_state == TOS_TASK_STATE_PENDING) {
+        tos_ready_list_insert(tos_timer_task);
+    }
+}
+
+
+/**
+ * @brief ticks to the next tick which expires timers or cascades timers from higher level
+ *
+ * @return uint32_t TOS_TIME_WAIT_INFINITY if there is no timer
+ * @note called in critical section. implement in tos_timer.c
+ */
+uint32_t tos_timer_next_ticks(void) {
+    uint32_t ticks = TOS_TIME_WAIT_INFINITY;
+    uint32_t level;
+    uint32_t idx;
+    uint32_t first;
+    uint32_t block;
+
+    if (tos_timer_task == nullptr) {
+        return ticks;
+    }
+    if (!tos_queue_is_empty(&tos_timer_expired_list)) {
+        return 1;
+    }
+
+    // level 0, slots in one turn from jiffies
+    for (idx = 0; idx < TOS_TIMER_WHEEL_SLOT; idx++) {
+        if (!tos_queue_is_empty(&tos_timer_wheel[0][(tos_timer_jiffies + idx) & TOS_TIMER_WHEEL_MASK])) {
+            ticks = idx + 1;
+            break;
+        }
+    }
+
+    // higher level, the first non-empty slot cascades when the lower level turns around to it.
+    // slot of current block is not cascaded yet if jiffies is at the beginning of the block
+    for (level = 1; level < TOS_TIMER_WHEEL_LEVEL; level++) {
+        block = tos_timer_jiffies >> (TOS_TIMER_WHEEL_BITS * level);
+        first = ((tos_timer_jiffies & ((1u << (TOS_TIMER_WHEEL_BITS * level)) - 1u)) == 0) ? 0 : 1;
+        for (idx = first; idx < first + TOS_TIMER_WHEEL_SLOT; idx++) {
+            if (!tos_queue_is_empty(&tos_timer_wheel[level][(block + idx) & TOS_TIMER_WHEEL_MASK])) {
+                uint32_t cascade_ticks = ((block + idx) << (TOS_TIMER_WHEEL_BITS * level)) - tos_timer_jiffies + 1;
+                if (cascade_ticks < ticks) {
+                    ticks = cascade_ticks;
+                }
+                break;
+            }
+        }
+    }
+
+    return ticks;
+}
+
+
+/**
+ * @brief timer task, call callbacks of expired timers
+ *
+ * @param args
+ */
+static void tos_timer_task_proc(void* args) {
+    tos_timer_intenal_t* timer_intenal;
+    tos_timer_callback_t callback;
+    void*                arg;
+    tos_use_critical_section();
+
+    while (true) {
+        tos_enter_critical_section();
+
+        // pend until timers expire, tos_timer_tick makes it ready
+        if (tos_queue_is_empty(&tos_timer_expired_list)) {
+            tos_ready_list_remove(tos_timer_task);
+            tos_timer_task->task_state = TOS_TASK_STATE_PENDING;
+            tos_leave_critical_section();
+
+            tos_schedule();
+            continue;
+        }
+
+        timer_intenal = get_object_by_field(tos_timer_intenal_t, timer_link, tos_timer_expired_list.next);
+        tos_queue_remove(&timer_intenal->timer_link);
+        tos_queue_init(&timer_intenal->timer_link);
+        timer_intenal->state = TIMER_STATE_STOPPED;
+
+        // restart from the expire time, catch up next tick if the task is late
+        if (timer_intenal->mode == TOS_TIMER_AUTO_RELOAD) {
+            timer_intenal->expire += timer_intenal->period;
+            tos_timer_wheel_insert(timer_intenal);
+        }
+        callback = timer_intenal->callback;
+        arg      = timer_intenal->arg;
+        tos_trace(TOS_TRACE_TIMER_EXPIRE, tos_timer_task, tos_pool_index(&tos_timer_pool, timer_intenal));
+
+        tos_leave_critical_section();
+
+        callback(arg);
+    }
+}
+
+
+/**
+ * @brief insert timer into wheel slot by its expire tick
+ *
+ * @param timer_intenal
+ * @note called in critical section, timer is not in any list
+ */
+static void tos_timer_wheel_insert(tos_timer_intenal_t* timer_intenal) {
+    uint32_t          expire = timer_intenal->expire;
+    uint32_t          delta  = expire - tos_timer_jiffies;
+    tos_queue_node_t* slot;
+
+    if ((int32_t)delta < 0) {
+        slot = &tos_timer_wheel[0][tos_timer_jiffies & TOS_TIMER_WHEEL_MASK];   // already expired, next tick
+    } else if (delta < (1u << TOS_TIMER_WHEEL_BITS)) {
+        slot = &tos_timer_wheel[0][tos_timer_wheel_index(expire, 0)];
+    } else if (delta < (1u << (TOS_TIMER_WHEEL_BITS * 2))) {
+        slot = &tos_timer_wheel[1][tos_timer_wheel_index(expire, 1)];
+    } else if (delta < (1u << (TOS_TIMER_WHEEL_BITS * 3))) {
+        slot = &tos_timer_wheel[2][tos_timer_wheel_index(expire, 2)];
+    } else {
+        // out of wheel range, inserted again when cascade
+        if (delta > TOS_TIMER_WHEEL_MAX) {
+            expire = tos_timer_jiffies + TOS_TIMER_WHEEL_MAX;
+        }
+        slot = &tos_timer_wheel[3][tos_timer_wheel_index(expire, 3)];
+    }
+
+    tos_queue_insert(slot, &timer_intenal->timer_link);
+    timer_intenal->state = TIMER_STATE_ACTIVE;
+}
+
+
+/**
+ * @brief remove timer from wheel or expired list
+ *
+ * @param timer_intenal
+ * @note called in critical section
+ */
+static void tos_timer_wheel_remove(tos_timer_intenal_t* timer_intenal) {
+    tos_queue_remove(&timer_intenal->timer_link);
+    tos_queue_init(&timer_intenal->timer_link);
+    timer_intenal->state = TIMER_STATE_STOPPED;
+}
+
+
+/**
+ * @brief move timers in current slot of level to lower levels
+ *
+ * @param level 1 ~ TOS_TIMER_WHEEL_LEVEL-1
+ * @return true the slot index is 0, higher level should cascade too
+ * @note called in critical section
+ */
+static bool tos_timer_wheel_cascade(uint32_t level) {
+    uint32_t             index = tos_timer_wheel_index(tos_timer_jiffies, level);
+    tos_queue_node_t*    slot  = &tos_timer_wheel[level][index];
+    tos_timer_intenal_t* timer_intenal;
+
+    while (!tos_queue_is_empty(slot)) {
+        timer_intenal = get_object_by_field(tos_timer_intenal_t, timer_link, slot->next);
+        tos_queue_remove(&timer_intenal->timer_link);
+        tos_timer_wheel_insert(timer_intenal);
+    }
+
+    return index == 0;
+}
+
+
+/**
+ * @brief process one tick, move timers expired in the tick to expired list
+ *
+ * @note called in critical section
+ */
+static void tos_timer_wheel_step(void) {
+    uint32_t             index = tos_timer_jiffies & TOS_TIMER_WHEEL_MASK;
+    uint32_t             level;
+    tos_queue_node_t*    slot;
+    tos_timer_intenal_t* timer_intenal;
+
+    // level 0 turns around, cascade higher levels
+    if (index == 0) {
+        for (level = 1; level < TOS_TIMER_WHEEL_LEVEL; level++) {
+            if (!tos_timer_wheel_cascade(level)) {
+                break;
+            }
+        }
+    }
+
+    slot = &tos_timer_wheel[0][index];
+    while (!tos_queue_is_empty(slot)) {
+        timer_intenal = get_object_by_field(tos_timer_intenal_t, timer_link, slot->next);
+        tos_queue_remove(&timer_intenal->timer_link);
+        tos_queue_insert(&tos_timer_expired_list, &timer_intenal->timer_link);
+        timer_intenal->state = TIMER_STATE_EXPIRED;
+    }
+
+    tos_timer_jiffies++;
+}
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file tos_timer.h
+ * @brief software timer
+ * @note timers are kept in a hierarchical timing wheel advanced by sys tick,
+ *       callbacks of expired timers run in the timer task
+ */
+
+#ifndef _TOS_TIMER_H_
+#define _TOS_TIMER_H_
+
+
+#include "tos_types.h"
+
+
+#define TOS_ERR_TIMER_NULLPTR -1
+#define TOS_ERR_TIMER_NOFREE  -2
+#define TOS_ERR_TIMER_INVALID -3
+#define TOS_ERR_TIMER_PARAM   -4   // invalid attr or period
+
+#define TOS_TIMER_ONE_SHOT    0    // stop after expired once
+#define TOS_TIMER_AUTO_RELOAD 1    // restart by period, without drift
+
+
+typedef struct tos_timer_intenal_t* tos_timer_t;
+typedef void (*tos_timer_callback_t)(void* arg);
+
+typedef struct {
+    uint8_t              mode;         // TOS_TIMER_ONE_SHOT or TOS_TIMER_AUTO_RELOAD
+    uint32_t             period_nms;   // rounded down to ticks, one tick at least
+    tos_timer_callback_t callback;     // called in timer task, should not block long
+    void*                arg;
+} tos_timer_attr_t;
+
+
+/**
+ * @brief create the timer task
+ * @note called after tos_init, before use any timer
+ */
+void tos_timer_module_init(void);
+
+/**
+ * @brief
+ *
+ * @param timer
+ * @param attr
+ * @return int
+ * @note the timer is stopped after created
+ */
+int  tos_timer_create(tos_timer_t* timer, const tos_timer_attr_t* attr);
+
+/**
+ * @brief start timer, expire after period from now. restart if it is running
+ *
+ * @param timer
+ * @return int
+ * @note can be called in ISR
+ */
+int  tos_timer_start(tos_timer_t* timer);
+
+/**
+ * @brief
+ *
+ * @param timer
+ * @return int
+ * @note can be called in ISR. an expired timer waiting for timer task is not called, but the callback may run
+ *       once more after stopped, if timer task has taken the timer and is calling it (stopped from ISR or a higher
+ *       prio task)
+ */
+int  tos_timer_stop(tos_timer_t* timer);
+
+/**
+ * @brief restart timer with new period
+ *
+ * @param timer
+ * @param period_nms 0 to keep the period
+ * @return int
+ * @note can be called in ISR
+ */
+int  tos_timer_reset(tos_timer_t* timer, uint32_t period_nms);
+int  tos_timer_destroy(tos_timer_t* timer);
+
+
+#endif
@@ -0,0 +1,436 @@
+/**
+ * @file tos_tlsf.c
+ * @brief two level segregated fit allocator, O(1) alloc and free of variable size blocks
+ *
+ */
+
+#include "tos_tlsf.h"
+#include "tos_cpu.h"
+
+#include <stddef.h>
+
+
+/**
+ * free blocks are kept in lists by size class:
+ *     first level: power of 2 of the size
+ *     second level: TOS_TLSF_SL_NUM linear ranges in the power of 2
+ * two levels of bitmaps show which lists are not empty, so a fit list is found by find first set bit.
+ *
+ * when alloc, round size up to the next class, so any block of the class found fits without search.
+ *   split the block, return the remainder to free list
+ * when free, merge with free physical neighbours at once, there are never two adjacent free blocks.
+ */
+
+
+#define TOS_TLSF_BLK_FREE      0x1u
+#define TOS_TLSF_BLK_PREV_FREE 0x2u
+#define TOS_TLSF_BLK_FLAGS     (TOS_TLSF_BLK_FREE | TOS_TLSF_BLK_PREV_FREE)
+
+#define TOS_TLSF_PAYLOAD_OFFSET offsetof(tos_tlsf_blk_t, next_free)
+#define TOS_TLSF_BLK_OVERHEAD   (TOS_TLSF_PAYLOAD_OFFSET - offsetof(tos_tlsf_blk_t, size))   // size and tag
+// free links and prev_phys of next block are in payload of free block
+#define TOS_TLSF_BLK_MIN                                                                                               \
+    tos_tlsf_align_up(sizeof(tos_tlsf_blk_t) - TOS_TLSF_PAYLOAD_OFFSET + offsetof(tos_tlsf_blk_t, size))
+#define TOS_TLSF_BLK_MAX ((1u << TOS_MEM_TLSF_FL_MAX) - TOS_TLSF_ALIGN)
+
+#define tos_tlsf_align_up(size)   (((size) + TOS_TLSF_ALIGN - 1) & ~(uintptr_t)(TOS_TLSF_ALIGN - 1))
+#define tos_tlsf_align_down(size) ((size) & ~(uintptr_t)(TOS_TLSF_ALIGN - 1))
+
+#define tos_tlsf_fls(val) (31u - tos_cpu_clz(val))                   // index of highest set bit
+#define tos_tlsf_ffs(val) (31u - tos_cpu_clz((val) & (~(val) + 1u)))   // index of lowest set bit
+
+#define blk_size(blk)         ((blk)->size & ~TOS_TLSF_BLK_FLAGS)
+#define blk_is_free(blk)      (((blk)->size & TOS_TLSF_BLK_FREE) != 0)
+#define blk_is_prev_free(blk) (((blk)->size & TOS_TLSF_BLK_PREV_FREE) != 0)
+#define blk_payload(blk)      ((void*)((uint8_t*)(blk) + TOS_TLSF_PAYLOAD_OFFSET))
+#define blk_from_payload(ptr) ((tos_tlsf_blk_t*)((uint8_t*)(ptr)-TOS_TLSF_PAYLOAD_OFFSET))
+// prev_phys of next block overlaps the end of payload
+#define blk_next(blk)                                                                                                  \
+    ((tos_tlsf_blk_t*)((uint8_t*)blk_payload(blk) + blk_size(blk) - offsetof(tos_tlsf_blk_t, size)))
+
+
+static void            tos_tlsf_mapping(tos_size_t size, uint32_t* fl, uint32_t* sl);
+static tos_tlsf_blk_t* tos_tlsf_take(tos_tlsf_t* tlsf, tos_size_t size);
+static void*           tos_tlsf_use(tos_tlsf_t* tlsf, tos_tlsf_blk_t* blk, tos_size_t size);
+static tos_tlsf_blk_t* tos_tlsf_find_suitable(tos_tlsf_t* tlsf, uint32_t* fl, uint32_t* sl);
+static void            tos_tlsf_insert(tos_tlsf_t* tlsf, tos_tlsf_blk_t* blk);
+static void            tos_tlsf_remove(tos_tlsf_t* tlsf, tos_tlsf_blk_t* blk);
+static void            tos_tlsf_mark_free(tos_tlsf_blk_t* blk);
+static void            tos_tlsf_mark_used(tos_tlsf_blk_t* blk);
+
+
+/**
+ * @brief init allocator with one free block of the whole pool
+ *
+ * @param tlsf
+ * @param mem_start
+ * @param mem_size
+ * @return int 0 when succeed, -1 when the pool is too small or larger than 2^TOS_MEM_TLSF_FL_MAX bytes
+ */
+int tos_tlsf_init(tos_tlsf_t* tlsf, uintptr_t mem_start, tos_size_t mem_size) {
+    uintptr_t       payload = tos_tlsf_align_up(mem_start + TOS_TLSF_PAYLOAD_OFFSET);
+    uintptr_t       mem_end = mem_start + mem_size;
+    tos_tlsf_blk_t* blk;
+    tos_tlsf_blk_t* sentinel;
+    tos_size_t      size;
+    uint32_t        fl, sl;
+
+    // size and tag of the sentinel block are after the free block
+    if (mem_end < payload + TOS_TLSF_BLK_OVERHEAD + TOS_TLSF_BLK_MIN) {
+        return -1;
+    }
+    size = tos_tlsf_align_down(mem_end - payload - TOS_TLSF_BLK_OVERHEAD);
+    if (size > TOS_TLSF_BLK_MAX) {
+        return -1;
+    }
+
+    tlsf->fl_bitmap  = 0;
+    tlsf->free_bytes = 0;
+    tlsf->first_blk  = blk_from_payload(payload);
+    for (fl = 0; fl < TOS_TLSF_FL_NUM; fl++) {
+        tlsf->sl_bitmap[fl] = 0;
+        for (sl = 0; sl < TOS_TLSF_SL_NUM; sl++) {
+            tlsf->free_list[fl][sl] = nullptr;
+        }
+    }
+
+    // one free block, and a used sentinel of size 0 at end, which stops merging
+    blk            = blk_from_payload(payload);
+    blk->size      = size;
+    sentinel       = blk_next(blk);
+    sentinel->size = 0;
+    tos_tlsf_mark_free(blk);
+    tos_tlsf_insert(tlsf, blk);
+
+    return 0;
+}
+
+
+/**
+ * @brief alloc a block, the first free block of the size class which is sure to fit
+ *
+ * @param tlsf
+ * @param nbytes
+ * @return void* TOS_TLSF_ALIGN aligned, nullptr when fail
+ */
+void* tos_tlsf_alloc(tos_tlsf_t* tlsf, tos_size_t nbytes) {
+    tos_tlsf_blk_t* blk;
+    tos_size_t      size;
+
+    if (nbytes == 0 || nbytes > TOS_TLSF_BLK_MAX) {
+        return nullptr;
+    }
+    size = (nbytes < TOS_TLSF_BLK_MIN) ? TOS_TLSF_BLK_MIN : tos_tlsf_align_up(nbytes);
+
+    blk = tos_tlsf_take(tlsf, size);
+    if (blk == nullptr) {
+        return nullptr;
+    }
+
+    return tos_tlsf_use(tlsf, blk, size);
+}
+
+
+/**
+ * @brief alloc a block at an address aligned to align
+ *
+ * @param tlsf
+ * @param nbytes
+ * @param align power of 2, no less than TOS_TLSF_ALIGN
+ * @return void* nullptr when fail
+ */
+void* tos_tlsf_alloc_aligned(tos_tlsf_t* tlsf, tos_size_t nbytes, tos_size_t align) {
+    tos_tlsf_blk_t* blk;
+    tos_tlsf_blk_t* front;
+    uintptr_t       payload;
+    tos_size_t      size;
+    tos_size_t      gap;
+
+    if (align <= TOS_TLSF_ALIGN) {
+        return tos_tlsf_alloc(tlsf, nbytes);
+    }
+    if (nbytes == 0 || nbytes > TOS_TLSF_BLK_MAX) {
+        return nullptr;
+    }
+    size = (nbytes < TOS_TLSF_BLK_MIN) ? TOS_TLSF_BLK_MIN : tos_tlsf_align_up(nbytes);
+
+    // room for the gap before the aligned address, which must be large enough for a free block
+    if (size > TOS_TLSF_BLK_MAX - align - TOS_TLSF_BLK_OVERHEAD - TOS_TLSF_BLK_MIN) {
+        return nullptr;
+    }
+    blk = tos_tlsf_take(tlsf, size + align + TOS_TLSF_BLK_OVERHEAD + TOS_TLSF_BLK_MIN);
+    if (blk == nullptr) {
+        return nullptr;
+    }
+
+    payload = ((uintptr_t)blk_payload(blk) + align - 1) & ~(uintptr_t)(align - 1);
+    gap     = (tos_size_t)(payload - (uintptr_t)blk_payload(blk));
+    if (gap != 0 && gap < TOS_TLSF_BLK_OVERHEAD + TOS_TLSF_BLK_MIN) {
+        payload += align;
+        gap += align;
+    }
+
+    // split the gap as a free block before the aligned one
+    if (gap != 0) {
+        front       = blk;
+        blk         = blk_from_payload(payload);
+        blk->size   = blk_size(front) - gap;
+        front->size = (gap - TOS_TLSF_BLK_OVERHEAD) | (front->size & TOS_TLSF_BLK_FLAGS);
+        tos_tlsf_mark_free(front);
+        tos_tlsf_insert(tlsf, front);
+    }
+
+    return tos_tlsf_use(tlsf, blk, size);
+}
+
+
+/**
+ * @brief free a block, merge it with free physical neighbours at once
+ *
+ * @param tlsf
+ * @param ptr returned by tos_tlsf_alloc
+ */
+void tos_tlsf_free(tos_tlsf_t* tlsf, void* ptr) {
+    tos_tlsf_blk_t* blk;
+    tos_tlsf_blk_t* neighbour;
+
+    if (ptr == nullptr) {
+        return;
+    }
+    blk = blk_from_payload(ptr);
+
+    if (blk_is_prev_free(blk)) {
+        neighbour = blk->prev_phys;
+        tos_tlsf_remove(tlsf, neighbour);
+        neighbour->size += blk_size(blk) + TOS_TLSF_BLK_OVERHEAD;
+        blk = neighbour;
+    }
+
+    neighbour = blk_next(blk);
+    if (blk_is_free(neighbour)) {
+        tos_tlsf_remove(tlsf, neighbour);
+        blk->size += blk_size(neighbour) + TOS_TLSF_BLK_OVERHEAD;
+    }
+
+    tos_tlsf_mark_free(blk);
+    tos_tlsf_insert(tlsf, blk);
+}
+
+
+/**
+ * @brief usable bytes of a used block
+ *
+ * @param ptr returned by tos_tlsf_alloc
+ * @return tos_size_t
+ */
+tos_size_t tos_tlsf_block_size(void* ptr) {
+    return blk_size(blk_from_payload(ptr));
+}
+
+
+/**
+ * @brief walk all blocks, used and free, in address order
+ *
+ * @param tlsf
+ * @param ptr payload of a block, nullptr to get the first block
+ * @return void* payload of the next physical block, nullptr at end of pool
+ */
+void* tos_tlsf_block_next(tos_tlsf_t* tlsf, void* ptr) {
+    tos_tlsf_blk_t* blk = (ptr == nullptr) ? tlsf->first_blk : blk_next(blk_from_payload(ptr));
+
+    // the sentinel of size 0 ends the pool
+    return (blk_size(blk) == 0) ? nullptr : blk_payload(blk);
+}
+
+
+/**
+ * @brief check if a block got by tos_tlsf_block_next is free
+ *
+ * @param ptr
+ * @return true
+ * @return false
+ */
+bool tos_tlsf_block_is_free(void* ptr) {
+    return blk_is_free(blk_from_payload(ptr));
+}
+
+
+/**
+ * @brief get size class
+ *
+ * @param size
+ * @param fl first level, power of 2
+ * @param sl second level, linear range in the power of 2
+ */
+static void tos_tlsf_mapping(tos_size_t size, uint32_t* fl, uint32_t* sl) {
+    if (size < TOS_TLSF_SMALL_SIZE) {
+        *fl = 0;
+        *sl = size / (TOS_TLSF_SMALL_SIZE / TOS_TLSF_SL_NUM);
+    } else {
+        *fl = tos_tlsf_fls(size);
+        *sl = (size >> (*fl - TOS_MEM_TLSF_SL_LOG2)) ^ TOS_TLSF_SL_NUM;
+        *fl -= TOS_TLSF_FL_SHIFT - 1;
+    }
+}
+
+
+/**
+ * @brief remove a free block of at least size bytes from its list
+ *
+ * @param tlsf
+ * @param size aligned
+ * @return tos_tlsf_blk_t* nullptr when fail
+ */
+static tos_tlsf_blk_t* tos_tlsf_take(tos_tlsf_t* tlsf, tos_size_t size) {
+    tos_tlsf_blk_t* blk;
+    uint32_t        fl, sl;
+
+    // round up to the next class, every block of it is large enough
+    if (size >= TOS_TLSF_SMALL_SIZE) {
+        size += (1u << (tos_tlsf_fls(size) - TOS_MEM_TLSF_SL_LOG2)) - 1;
+    }
+    tos_tlsf_mapping(size, &fl, &sl);
+    if (fl >= TOS_TLSF_FL_NUM) {
+        return nullptr;
+    }
+
+    blk = tos_tlsf_find_suitable(tlsf, &fl, &sl);
+    if (blk != nullptr) {
+        tos_tlsf_remove(tlsf, blk);
+    }
+
+    return blk;
+}
+
+
+/**
+ * @brief split a taken block to size, the rest is free if it is large enough for a block
+ *
+ * @param tlsf
+ * @param blk
+ * @param size aligned
+ * @return void* payload
+ */
+static void* tos_tlsf_use(tos_tlsf_t* tlsf, tos_tlsf_blk_t* blk, tos_size_t size) {
+    tos_tlsf_blk_t* rest;
+
+    if (blk_size(blk) >= size + TOS_TLSF_BLK_OVERHEAD + TOS_TLSF_BLK_MIN) {
+        rest       = (tos_tlsf_blk_t*)((uint8_t*)blk_payload(blk) + size - offsetof(tos_tlsf_blk_t, size));
+        rest->size = blk_size(blk) - size - TOS_TLSF_BLK_OVERHEAD;
+        blk->size  = size | (blk->size & TOS_TLSF_BLK_FLAGS);
+        tos_tlsf_mark_free(rest);
+        tos_tlsf_insert(tlsf, rest);
+    }
+
+    tos_tlsf_mark_used(blk);
+    blk->tag = 0;
+
+    return blk_payload(blk);
+}
+
+
+/**
+ * @brief find a free block of the class or the next larger non empty class
+ *
+ * @param tlsf
+ * @param fl in: class wanted, out: class found
+ * @param sl
+ * @return tos_tlsf_blk_t* nullptr when no free block is large enough
+ */
+static tos_tlsf_blk_t* tos_tlsf_find_suitable(tos_tlsf_t* tlsf, uint32_t* fl, uint32_t* sl) {
+    uint32_t sl_map = tlsf->sl_bitmap[*fl] & (~0u << *sl);
+    uint32_t fl_map;
+
+    if (sl_map == 0) {
+        fl_map = (*fl + 1 < 32) ? tlsf->fl_bitmap & (~0u << (*fl + 1)) : 0;
+        if (fl_map == 0) {
+            return nullptr;
+        }
+        *fl    = tos_tlsf_ffs(fl_map);
+        sl_map = tlsf->sl_bitmap[*fl];
+    }
+    *sl = tos_tlsf_ffs(sl_map);
+
+    return tlsf->free_list[*fl][*sl];
+}
+
+
+/**
+ * @brief insert free block into head of the list of its class
+ *
+ * @param tlsf
+ * @param blk
+ */
+static void tos_tlsf_insert(tos_tlsf_t* tlsf, tos_tlsf_blk_t* blk) {
+    uint32_t fl, sl;
+
+    tos_tlsf_mapping(blk_size(blk), &fl, &sl);
+
+    blk->prev_free = nullptr;
+    blk->next_free = tlsf->free_list[fl][sl];
+    if (blk->next_free != nullptr) {
+        blk->next_free->prev_free = blk;
+    }
+    tlsf->free_list[fl][sl] = blk;
+
+    tlsf->fl_bitmap |= 1u << fl;
+    tlsf->sl_bitmap[fl] |= 1u << sl;
+    tlsf->free_bytes += blk_size(blk);
+}
+
+
+/**
+ * @brief remove free block from the list of its class
+ *
+ * @param tlsf
+ * @param blk
+ */
+static void tos_tlsf_remove(tos_tlsf_t* tlsf, tos_tlsf_blk_t* blk) {
+    uint32_t fl, sl;
+
+    tos_tlsf_mapping(blk_size(blk), &fl, &sl);
+
+    if (blk->next_free != nullptr) {
+        blk->next_free->prev_free = blk->prev_free;
+    }
+    if (blk->prev_free != nullptr) {
+        blk->prev_free->next_free = blk->next_free;
+    } else {
+        tlsf->free_list[fl][sl] = blk->next_free;
+        if (blk->next_free == nullptr) {
+            tlsf->sl_bitmap[fl] &= ~(1u << sl);
+            if (tlsf->sl_bitmap[fl] == 0) {
+                tlsf->fl_bitmap &= ~(1u << fl);
+            }
+        }
+    }
+
+    tlsf->free_bytes -= blk_size(blk);
+}
+
+
+/**
+ * @brief mark block free, tell next block by flag and prev_phys
+ *
+ * @param blk
+ */
+static void tos_tlsf_mark_free(tos_tlsf_blk_t* blk) {
+    tos_tlsf_blk_t* next = blk_next(blk);
+
+    blk->size |= TOS_TLSF_BLK_FREE;
+    next->prev_phys = blk;
+    next->size |= TOS_TLSF_BLK_PREV_FREE;
+}
+
+
+/**
+ * @brief mark block used, prev_phys of next block becomes payload
+ *
+ * @param blk
+ */
+static void tos_tlsf_mark_used(tos_tlsf_blk_t* blk) {
+    tos_tlsf_blk_t* next = blk_next(blk);
+
+    blk->size &= ~TOS_TLSF_BLK_FREE;
+    next->size &= ~TOS_TLSF_BLK_PREV_FREE;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file tos_tlsf.h
+ * @brief two level segregated fit allocator, O(1) alloc and free of variable size blocks
+ * @note private, not for user. used by tos_mem, not thread safe
+ */
+
+#ifndef _TOS_TLSF_H_
+#define _TOS_TLSF_H_
+
+
+#include "tos_config.h"
+#include "tos_types.h"
+
+
+#define TOS_TLSF_ALIGN_LOG2 3u
+#define TOS_TLSF_ALIGN      (1u << TOS_TLSF_ALIGN_LOG2)   // payload addr and size align
+#define TOS_TLSF_SL_NUM     (1u << TOS_MEM_TLSF_SL_LOG2)
+#define TOS_TLSF_FL_SHIFT   (TOS_MEM_TLSF_SL_LOG2 + TOS_TLSF_ALIGN_LOG2)
+#define TOS_TLSF_SMALL_SIZE (1u << TOS_TLSF_FL_SHIFT)   // smaller blocks are in first level 0, linear
+#define TOS_TLSF_FL_NUM     (TOS_MEM_TLSF_FL_MAX - TOS_TLSF_FL_SHIFT + 1)
+
+#if TOS_MEM_TLSF_SL_LOG2 < 1 || TOS_MEM_TLSF_SL_LOG2 > 5
+#error "TOS_MEM_TLSF_SL_LOG2 should be 1~5"
+#endif
+#if TOS_MEM_TLSF_FL_MAX <= TOS_TLSF_FL_SHIFT || TOS_MEM_TLSF_FL_MAX > 31
+#error "TOS_MEM_TLSF_FL_MAX is too small or too large"
+#endif
+
+
+/**
+ * block in pool, physical neighbours are found by size and prev_phys.
+ * prev_phys is in the last word of previous block, valid only when previous block is free.
+ * size and tag are the overhead of a used block, free links are in payload of a free block
+ */
+typedef struct tos_tlsf_blk_t {
+    struct tos_tlsf_blk_t* prev_phys;   // previous physical block
+    tos_size_t             size;        // payload bytes, bit 0: block is free, bit 1: previous block is free
+    tos_size_t             tag;         // word before payload, not used by tlsf, free for owner of used block
+    struct tos_tlsf_blk_t* next_free;   // free list of the same size class
+    struct tos_tlsf_blk_t* prev_free;   //
+} tos_tlsf_blk_t;
+
+typedef struct {
+    uint32_t        fl_bitmap;                                      // bit set when any list of the fl is not empty
+    uint32_t        sl_bitmap[TOS_TLSF_FL_NUM];                     // bit set when the list is not empty
+    tos_tlsf_blk_t* free_list[TOS_TLSF_FL_NUM][TOS_TLSF_SL_NUM];   // free blocks, by size class
+    tos_size_t      free_bytes;                                     // payload bytes of free blocks
+    tos_tlsf_blk_t* first_blk;                                      // lowest block in pool, for physical walk
+} tos_tlsf_t;
+
+
+/**
+ * @brief init allocator with one free block of the whole pool
+ *
+ * @param tlsf
+ * @param mem_start
+ * @param mem_size
+ * @return int 0 when succeed, -1 when the pool is too small or larger than 2^TOS_MEM_TLSF_FL_MAX bytes
+ */
+int tos_tlsf_init(tos_tlsf_t* tlsf, uintptr_t mem_start, tos_size_t mem_size);
+
+/**
+ * @brief alloc a block, the first free block of the size class which is sure to fit
+ *
+ * @param tlsf
+ * @param nbytes
+ * @return void* TOS_TLSF_ALIGN aligned, nullptr when fail
+ */
+void* tos_tlsf_alloc(tos_tlsf_t* tlsf, tos_size_t nbytes);
+
+/**
+ * @brief alloc a block at an address aligned to align, the gap before it is left as a free block
+ *
+ * @param tlsf
+ * @param nbytes
+ * @param align power of 2, no less than TOS_TLSF_ALIGN
+ * @return void* nullptr when fail
+ */
+void* tos_tlsf_alloc_aligned(tos_tlsf_t* tlsf, tos_size_t nbytes, tos_size_t align);
+
+/**
+ * @brief free a block, merge it with free physical neighbours at once
+ *
+ * @param tlsf
+ * @param ptr returned by tos_tlsf_alloc
+ */
+void tos_tlsf_free(tos_tlsf_t* tlsf, void* ptr);
+
+/**
+ * @brief usable bytes of a used block
+ *
+ * @param ptr returned by tos_tlsf_alloc
+ * @return tos_size_t
+ */
+tos_size_t tos_tlsf_block_size(void* ptr);
+
+/**
+ * @brief walk all blocks, used and free, in address order
+ *
+ * @param tlsf
+ * @param ptr payload of a block, nullptr to get the first block
+ * @return void* payload of the next physical block, nullptr at end of pool
+ * @note ptr must be a block still existing, a free block may be merged by tos_tlsf_alloc or tos_tlsf_free
+ */
+void* tos_tlsf_block_next(tos_tlsf_t* tlsf, void* ptr);
+
+/**
+ * @brief check if a block got by tos_tlsf_block_next is free
+ *
+ * @param ptr
+ * @return true
+ * @return false
+ */
+bool tos_tlsf_block_is_free(void* ptr);
+
+
+#endif
@@ -0,0 +1,248 @@
+/**
+ * @file tos_trace.c
+ * @brief kernel event trace
+ *
+ */
+
+#include "tos_trace.h"
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_core_.h"
+#include "tos_cpu.h"
+
+#include <string.h>
+
+
+#if TOS_TRACE_ENABLE
+
+#define TOS_TRACE_PACKET_RECORD_NUM 31u   // records in one packet, payload length should be less than 256
+#define TOS_TRACE_PACKET_HEAD_SIZE  4u
+
+
+static void tos_trace_send(uint8_t type, const uint8_t* payload, uint8_t len);
+static void tos_trace_send_header(void);
+static void tos_trace_send_name(uint8_t task_id);
+
+
+static tos_trace_record_t tos_trace_buffer[TOS_TRACE_BUFFER_SIZE];
+static volatile uint32_t  tos_trace_wr;            // written by producers (in critical section)
+static volatile uint32_t  tos_trace_rd;            // written by drain
+static volatile uint32_t  tos_trace_lost;          // written by producers
+static uint32_t           tos_trace_lost_sent;     // lost count reported by drain
+static volatile bool      tos_trace_on;            //
+static bool               tos_trace_header_sent;   //
+static tos_trace_output_t tos_trace_output;        //
+static uint8_t            tos_trace_packet[TOS_TRACE_PACKET_HEAD_SIZE + 255];
+
+
+/**
+ * @brief add a record into trace buffer
+ *
+ * @param event TOS_TRACE_xxx
+ * @param task_hdl task of the event, nullptr for no task
+ * @param arg
+ * @note called in critical section, dropped when buffer is full. use tos_trace() in kernel
+ */
+void tos_trace_record(uint8_t event, const tos_task_t* task_hdl, uint16_t arg) {
+    uint32_t            wr = tos_trace_wr;
+    tos_trace_record_t* record;
+
+    if (!tos_trace_on) {
+        return;
+    }
+    if (wr - tos_trace_rd >= TOS_TRACE_BUFFER_SIZE) {
+        tos_trace_lost++;
+        return;
+    }
+
+    record            = &tos_trace_buffer[wr & (TOS_TRACE_BUFFER_SIZE - 1)];
+    record->timestamp = tos_cpu_cycle_get();
+    record->event     = event;
+    record->task_id   = (task_hdl != nullptr) ? (uint8_t)task_hdl->task_id : TOS_TRACE_NO_TASK;
+    record->arg       = arg;
+
+    tos_trace_wr = wr + 1;   // publish after the record is filled
+}
+
+
+/**
+ * @brief set output of drained packets
+ *
+ * @param output such as uart_dbg_send_data
+ */
+void tos_trace_output_set(tos_trace_output_t output) {
+    tos_trace_output = output;
+}
+
+
+/**
+ * @brief start recording, the header and names of tasks will be sent by next drain
+ *
+ */
+void tos_trace_start(void) {
+    tos_use_critical_section();
+
+    tos_enter_critical_section();
+    tos_trace_rd          = tos_trace_wr;   // drop old records
+    tos_trace_lost_sent   = tos_trace_lost;
+    tos_trace_header_sent = false;
+    tos_trace_on          = true;
+    tos_leave_critical_section();
+}
+
+
+/**
+ * @brief stop recording, records in buffer can still be drained
+ *
+ */
+void tos_trace_stop(void) {
+    tos_trace_on = false;
+}
+
+
+/**
+ * @brief send records in buffer to output
+ *
+ * @return uint32_t records sent
+ * @note called by one task only, such as the service task
+ */
+uint32_t tos_trace_drain(void) {
+    tos_trace_record_t records[TOS_TRACE_PACKET_RECORD_NUM];
+    uint32_t           rd;
+    uint32_t           num;
+    uint32_t           idx;
+    uint32_t           lost;
+    uint32_t           sent = 0;
+
+    if (tos_trace_output == nullptr) {
+        return 0;
+    }
+    if (!tos_trace_header_sent) {
+        tos_trace_header_sent = true;
+        tos_trace_send_header();
+    }
+
+    do {
+        num = 0;
+
+        // report dropped records first
+        lost = tos_trace_lost;
+        if (lost != tos_trace_lost_sent) {
+            records[num].timestamp = tos_cpu_cycle_get();
+            records[num].event     = TOS_TRACE_LOST;
+            records[num].task_id   = TOS_TRACE_NO_TASK;
+            records[num].arg       = (lost - tos_trace_lost_sent > 0xFFFFu) ? 0xFFFFu : (uint16_t)(lost - tos_trace_lost_sent);
+            tos_trace_lost_sent    = lost;
+            num++;
+        }
+
+        // copy records out before release the space to producers
+        rd = tos_trace_rd;
+        while (num < TOS_TRACE_PACKET_RECORD_NUM && rd != tos_trace_wr) {
+            records[num++] = tos_trace_buffer[rd & (TOS_TRACE_BUFFER_SIZE - 1)];
+            rd++;
+        }
+        tos_trace_rd = rd;
+
+        if (num == 0) {
+            break;
+        }
+        tos_trace_send(TOS_TRACE_PACKET_RECORDS, (const uint8_t*)records, (uint8_t)(num * sizeof(tos_trace_record_t)));
+        sent += num;
+
+        // name of the new task
+        for (idx = 0; idx < num; idx++) {
+            if (records[idx].event == TOS_TRACE_TASK_CREATE) {
+                tos_trace_send_name(records[idx].task_id);
+            }
+        }
+    } while (num == TOS_TRACE_PACKET_RECORD_NUM);
+
+    return sent;
+}
+
+
+/**
+ * @brief send one packet to output
+ *
+ * @param type
+ * @param payload
+ * @param len
+ */
+static void tos_trace_send(uint8_t type, const uint8_t* payload, uint8_t len) {
+    tos_trace_packet[0] = TOS_TRACE_SYNC1;
+    tos_trace_packet[1] = TOS_TRACE_SYNC2;
+    tos_trace_packet[2] = type;
+    tos_trace_packet[3] = len;
+    memcpy(&tos_trace_packet[TOS_TRACE_PACKET_HEAD_SIZE], payload, len);
+
+    tos_trace_output(tos_trace_packet, TOS_TRACE_PACKET_HEAD_SIZE + len);
+}
+
+
+/**
+ * @brief send header and names of all tasks
+ *
+ */
+static void tos_trace_send_header(void) {
+    uint8_t           header[8];
+    uint32_t          hz      = MCU_SYS_CLOCK;
+    uint16_t          size    = sizeof(tos_trace_record_t);
+    uint16_t          version = TOS_TRACE_VERSION;
+    tos_queue_node_t* link;
+    uint8_t           task_ids[TOS_MAX_TASK_NUM_USED + 1];
+    uint32_t          task_num = 0;
+    uint32_t          idx;
+    tos_use_critical_section();
+
+    memcpy(&header[0], &hz, sizeof(hz));
+    memcpy(&header[4], &size, sizeof(size));
+    memcpy(&header[6], &version, sizeof(version));
+    tos_trace_send(TOS_TRACE_PACKET_HEADER, header, sizeof(header));
+
+    tos_enter_critical_section();
+    for (link = tos_state.all_task_list.next; link != &tos_state.all_task_list && task_num < sizeof(task_ids);
+         link = link->next) {
+        task_ids[task_num++] = (uint8_t)get_task_by_all_free_link(link)->task_id;
+    }
+    tos_leave_critical_section();
+
+    for (idx = 0; idx < task_num; idx++) {
+        tos_trace_send_name(task_ids[idx]);
+    }
+}
+
+
+/**
+ * @brief send name of task
+ *
+ * @param task_id
+ * @note nothing sent if the task is deleted
+ */
+static void tos_trace_send_name(uint8_t task_id) {
+    uint8_t           payload[1 + 32];
+    uint32_t          len = 0;
+    tos_queue_node_t* link;
+    tos_task_t*       task_hdl;
+    tos_use_critical_section();
+
+    tos_enter_critical_section();
+    for (link = tos_state.all_task_list.next; link != &tos_state.all_task_list; link = link->next) {
+        task_hdl = get_task_by_all_free_link(link);
+        if (task_hdl->task_id == task_id && task_hdl->task_name != nullptr) {
+            len = strlen(task_hdl->task_name);
+            len = (len < sizeof(payload) - 1) ? len : sizeof(payload) - 1;
+            memcpy(&payload[1], task_hdl->task_name, len);
+            break;
+        }
+    }
+    tos_leave_critical_section();
+
+    if (link == &tos_state.all_task_list) {
+        return;
+    }
+    payload[0] = task_id;
+    tos_trace_send(TOS_TRACE_PACKET_NAME, payload, (uint8_t)(1 + len));
+}
+
+#endif
@@ -0,0 +1,131 @@
+/**
+ * @file tos_trace.h
+ * @brief kernel event trace
+ * @note fixed size records are written into a ram ring buffer in critical section,
+ *       and drained by a task to the output (debug uart) as binary packets
+ */
+
+#ifndef _TOS_TRACE_H_
+#define _TOS_TRACE_H_
+
+
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_types.h"
+
+
+// trace events, task of record is the task which the event happens on
+#define TOS_TRACE_TASK_SWITCH     0x01   // task: switch from, arg: task id switch to
+#define TOS_TRACE_TASK_READY      0x02   // arg: prio
+#define TOS_TRACE_TASK_SLEEP      0x03   // arg: ticks, 0xFFFF when more
+#define TOS_TRACE_TASK_WAKE       0x04   // wake up by time
+#define TOS_TRACE_TASK_PRIO       0x05   // arg: new running prio
+#define TOS_TRACE_TASK_CREATE     0x06   // arg: prio
+#define TOS_TRACE_TASK_DELETE     0x07   //
+#define TOS_TRACE_TASK_STACK_OVF  0x08   // arg: max used bytes, found by stack check
+#define TOS_TRACE_TASK_DEADLINE   0x09   // deadline miss, arg: ticks late, 0xFFFF when more
+#define TOS_TRACE_ISR_ENTER       0x10   // task: interrupted task, arg: intr level after enter
+#define TOS_TRACE_ISR_EXIT        0x11   // arg: intr level after exit
+#define TOS_TRACE_MUTEX_LOCK      0x20   // arg: mutex index, task: new owner
+#define TOS_TRACE_MUTEX_PEND      0x21   // arg: mutex index
+#define TOS_TRACE_MUTEX_UNLOCK    0x22   // arg: mutex index
+#define TOS_TRACE_MUTEX_TIMEOUT   0x23   // arg: mutex index
+#define TOS_TRACE_COND_WAIT       0x30   // arg: cond index
+#define TOS_TRACE_COND_SIGNAL     0x31   // arg: cond index
+#define TOS_TRACE_COND_BROADCAST  0x32   // arg: cond index
+#define TOS_TRACE_COND_TIMEOUT    0x33   // arg: cond index
+#define TOS_TRACE_TIMER_EXPIRE    0x40   // arg: timer index, task: timer task
+#define TOS_TRACE_SEM_TAKE        0x50   // arg: sem index
+#define TOS_TRACE_SEM_PEND        0x51   // arg: sem index
+#define TOS_TRACE_SEM_GIVE        0x52   // arg: sem index, task: current task, or none in ISR
+#define TOS_TRACE_SEM_TIMEOUT     0x53   // arg: sem index
+#define TOS_TRACE_EVENT_WAIT      0x60   // arg: event index, wait satisfied
+#define TOS_TRACE_EVENT_PEND      0x61   // arg: event index
+#define TOS_TRACE_EVENT_SET       0x62   // arg: event index
+#define TOS_TRACE_EVENT_TIMEOUT   0x63   // arg: event index
+#define TOS_TRACE_MSGQ_SEND       0x70   // arg: msgq index
+#define TOS_TRACE_MSGQ_RECV       0x71   // arg: msgq index
+#define TOS_TRACE_MSGQ_PEND       0x72   // arg: msgq index, queue full when send or empty when recv
+#define TOS_TRACE_MSGQ_TIMEOUT    0x73   // arg: msgq index
+#define TOS_TRACE_LOST            0xF0   // arg: records dropped when buffer full, added by drain
+
+#define TOS_TRACE_NO_TASK         0xFF   // task id when there is no task (before first switch)
+
+// output packet: sync1 sync2 type len payload[len]
+#define TOS_TRACE_SYNC1           0xA5
+#define TOS_TRACE_SYNC2           0x5A
+#define TOS_TRACE_PACKET_HEADER   'H'    // u32 timestamp hz, u16 record size, u16 version
+#define TOS_TRACE_PACKET_NAME     'N'    // u8 task id, task name without '\0'
+#define TOS_TRACE_PACKET_RECORDS  'R'    // tos_trace_record_t[], little endian
+#define TOS_TRACE_VERSION         1u
+
+
+typedef struct {
+    uint32_t timestamp;   // cpu cycles
+    uint8_t  event;
+    uint8_t  task_id;
+    uint16_t arg;
+} tos_trace_record_t;
+
+typedef void (*tos_trace_output_t)(const uint8_t* data, uint16_t len);
+
+
+#if TOS_TRACE_ENABLE
+
+#if (TOS_TRACE_BUFFER_SIZE & (TOS_TRACE_BUFFER_SIZE - 1)) != 0
+#error "TOS_TRACE_BUFFER_SIZE should be power of 2"
+#endif
+
+/**
+ * @brief add a record into trace buffer
+ *
+ * @param event TOS_TRACE_xxx
+ * @param task_hdl task of the event, nullptr for no task
+ * @param arg
+ * @note called in critical section, dropped when buffer is full. use tos_trace() in kernel
+ */
+void tos_trace_record(uint8_t event, const tos_task_t* task_hdl, uint16_t arg);
+
+/**
+ * @brief set output of drained packets
+ *
+ * @param output such as uart_dbg_send_data
+ */
+void tos_trace_output_set(tos_trace_output_t output);
+
+/**
+ * @brief start recording, the header and names of tasks will be sent by next drain
+ *
+ */
+void tos_trace_start(void);
+
+/**
+ * @brief stop recording, records in buffer can still be drained
+ *
+ */
+void tos_trace_stop(void);
+
+/**
+ * @brief send records in buffer to output
+ *
+ * @return uint32_t records sent
+ * @note called by one task only, such as the service task
+ */
+uint32_t tos_trace_drain(void);
+
+#define tos_trace(event, task_hdl, arg) tos_trace_record((event), (task_hdl), (uint16_t)(arg))
+
+#else
+
+#define tos_trace(event, task_hdl, arg) ((void)0)
+#define tos_trace_output_set(output)    ((void)0)
+#define tos_trace_start()               ((void)0)
+#define tos_trace_stop()                ((void)0)
+
+static inline uint32_t tos_trace_drain(void) {
+    return 0;
+}
+
+#endif
+
+#endif
@@ -1,30 +1,30 @@
-/**
- * @file tos_types.h
- * @brief base types used by tos
- *
- */
-
-#ifndef _TOS_TYPES_H_
-#define _TOS_TYPES_H_
-
-#include <stdbool.h>
-#include <stdint.h>
-
-
-#ifndef nullptr
-#define nullptr         ((void*)0)
-#endif
-
-#ifdef _IN_TOS_CORE_C_
-#define TOS_EXTERN
-#else
-#define TOS_EXTERN      extern
-#endif
-
-
-typedef uint32_t        tos_size_t;
-typedef uint32_t        tos_stack_t;
-typedef void            (*tos_task_proc_t)(void*);
-
-
-#endif
+/**
+ * @file tos_types.h
+ * @brief base types used by tos
+ *
+ */
+
+#ifndef _TOS_TYPES_H_
+#define _TOS_TYPES_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+#ifndef nullptr
+#define nullptr         ((void*)0)
+#endif
+
+#ifdef _IN_TOS_CORE_C_
+#define TOS_EXTERN
+#else
+#define TOS_EXTERN      extern
+#endif
+
+
+typedef uint32_t        tos_size_t;
+typedef uint32_t        tos_stack_t;
+typedef void            (*tos_task_proc_t)(void*);
+
+
+#endif
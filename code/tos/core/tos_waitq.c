@@ -0,0 +1,156 @@
+/**
+ * @file tos_waitq.c
+ * @brief priority ordered wait queue of tasks
+ * @note tasks are kept sorted when insert or prio change, so the best task is always at the head
+ */
+
+#include "tos_waitq.h"
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_core_.h"
+#include "tos_utils.h"
+
+
+static void tos_waitq_insert(tos_waitq_t* waitq, tos_task_t* task_hdl);
+
+
+/**
+ * @brief
+ *
+ * @param waitq
+ */
+void tos_waitq_init(tos_waitq_t* waitq) {
+    tos_queue_init(&waitq->task_list);
+}
+
+
+/**
+ * @brief get the highest prio pending task, which was pending first among the same prio
+ *
+ * @param waitq
+ * @return tos_task_t* nullptr when empty
+ * @note called in critical section
+ */
+tos_task_t* tos_waitq_first(tos_waitq_t* waitq) {
+    if (tos_queue_is_empty(&waitq->task_list)) {
+        return nullptr;
+    }
+    return get_task_by_ready_pending_link(waitq->task_list.next);
+}
+
+
+/**
+ * @brief move current task from ready list to wait queue
+ *
+ * @param waitq
+ * @param ticks ticks to wait, TOS_TIME_WAIT_INFINITY for no timeout
+ * @note called in critical section. task_pend_status is TOS_PEND_TIMEOUT until woken by tos_waitq_wake
+ */
+void tos_waitq_pend(tos_waitq_t* waitq, uint32_t ticks) {
+    tos_task_t* task_hdl = tos_get_current_task();
+
+    tos_ready_list_remove(task_hdl);
+    task_hdl->task_state       = TOS_TASK_STATE_PENDING;
+    task_hdl->task_pend_status = TOS_PEND_TIMEOUT;
+    tos_waitq_insert(waitq, task_hdl);
+
+    tos_waiting_list_insert(task_hdl, ticks);
+}
+
+
+/**
+ * @brief move pending task from its wait queue to ready list
+ *
+ * @param task_hdl
+ * @note called in critical section
+ */
+void tos_waitq_wake(tos_task_t* task_hdl) {
+    tos_waitq_remove(task_hdl);
+    tos_waiting_list_remove(task_hdl);
+    tos_ready_list_insert(task_hdl);
+    task_hdl->task_pend_status = TOS_PEND_OK;
+}
+
+
+/**
+ * @brief wake the first task
+ *
+ * @param waitq
+ * @return tos_task_t* woken task, nullptr when empty
+ * @note called in critical section
+ */
+tos_task_t* tos_waitq_wake_one(tos_waitq_t* waitq) {
+    tos_task_t* task_hdl = tos_waitq_first(waitq);
+
+    if (task_hdl != nullptr) {
+        tos_waitq_wake(task_hdl);
+    }
+    return task_hdl;
+}
+
+
+/**
+ * @brief wake all tasks
+ *
+ * @param waitq
+ * @return uint32_t number of woken tasks
+ * @note called in critical section
+ */
+uint32_t tos_waitq_wake_all(tos_waitq_t* waitq) {
+    uint32_t task_num = 0;
+
+    while (tos_waitq_wake_one(waitq) != nullptr) {
+        task_num++;
+    }
+    return task_num;
+}
+
+
+/**
+ * @brief remove task from its wait queue, task state is not changed
+ *
+ * @param task_hdl
+ * @note called in critical section, when pending times out or task is deleted
+ */
+void tos_waitq_remove(tos_task_t* task_hdl) {
+    tos_queue_remove(&task_hdl->ready_pending_link);
+    tos_queue_init(&task_hdl->ready_pending_link);
+    task_hdl->task_pend_waitq = nullptr;
+}
+
+
+/**
+ * @brief move task to the right place of its wait queue after its prio changed
+ *
+ * @param task_hdl
+ * @note called in critical section
+ */
+void tos_waitq_reposition(tos_task_t* task_hdl) {
+    tos_waitq_t* waitq = task_hdl->task_pend_waitq;
+
+    if (waitq == nullptr) {
+        return;
+    }
+    tos_waitq_remove(task_hdl);
+    tos_waitq_insert(waitq, task_hdl);
+}
+
+
+/**
+ * @brief insert task by prio, behind tasks with the same prio
+ *
+ * @param waitq
+ * @param task_hdl
+ * @note called in critical section
+ */
+static void tos_waitq_insert(tos_waitq_t* waitq, tos_task_t* task_hdl) {
+    tos_queue_node_t* list_node;
+
+    for (list_node = waitq->task_list.next; list_node != &waitq->task_list; list_node = list_node->next) {
+        if (get_task_by_ready_pending_link(list_node)->task_prio < task_hdl->task_prio) {
+            break;
+        }
+    }
+    tos_queue_insert(list_node, &task_hdl->ready_pending_link);   // insert in front of list_node
+    task_hdl->task_pend_waitq = waitq;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file tos_waitq.h
+ * @brief priority ordered wait queue of tasks, shared by all blocking kernel objects
+ * @note private, not for user
+ */
+
+#ifndef _TOS_WAITQ_H_
+#define _TOS_WAITQ_H_
+
+
+#include "tos_core_.h"
+#include "tos_utils.h"
+
+
+struct tos_waitq_t {
+    tos_queue_node_t task_list;   // pending tasks, higher prio first, FIFO for same prio
+};
+
+
+#define tos_waitq_is_empty(waitq) tos_queue_is_empty(&(waitq)->task_list)
+
+
+/**
+ * @brief
+ *
+ * @param waitq
+ */
+void tos_waitq_init(tos_waitq_t* waitq);
+
+/**
+ * @brief get the highest prio pending task, which was pending first among the same prio
+ *
+ * @param waitq
+ * @return tos_task_t* nullptr when empty
+ * @note called in critical section
+ */
+tos_task_t* tos_waitq_first(tos_waitq_t* waitq);
+
+/**
+ * @brief move current task from ready list to wait queue
+ *
+ * @param waitq
+ * @param ticks ticks to wait, TOS_TIME_WAIT_INFINITY for no timeout
+ * @note called in critical section. task_pend_status is TOS_PEND_TIMEOUT until woken by tos_waitq_wake
+ */
+void tos_waitq_pend(tos_waitq_t* waitq, uint32_t ticks);
+
+/**
+ * @brief move pending task from its wait queue to ready list
+ *
+ * @param task_hdl
+ * @note called in critical section
+ */
+void tos_waitq_wake(tos_task_t* task_hdl);
+
+/**
+ * @brief wake the first task
+ *
+ * @param waitq
+ * @return tos_task_t* woken task, nullptr when empty
+ * @note called in critical section
+ */
+tos_task_t* tos_waitq_wake_one(tos_waitq_t* waitq);
+
+/**
+ * @brief wake all tasks
+ *
+ * @param waitq
+ * @return uint32_t number of woken tasks
+ * @note called in critical section
+ */
+uint32_t tos_waitq_wake_all(tos_waitq_t* waitq);
+
+/**
+ * @brief remove task from its wait queue, task state is not changed
+ *
+ * @param task_hdl
+ * @note called in critical section, when pending times out or task is deleted
+ */
+void tos_waitq_remove(tos_task_t* task_hdl);
+
+/**
+ * @brief move task to the right place of its wait queue after its prio changed
+ *
+ * @param task_hdl
+ * @note called in critical section
+ */
+void tos_waitq_reposition(tos_task_t* task_hdl);
+
+
+#endif
@@ -0,0 +1,483 @@
+/**
+ * @file tos_cpu_c.c
+ * @brief cpu dependency functions for linux host simulation
+ * @version 0.1
+ * @note task switch by ucontext, irq by signals, sys tick by interval timer
+ */
+
+#define _GNU_SOURCE
+
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_core_.h"
+#include "tos_cpu.h"
+#include "tos_cpu_posix.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <ucontext.h>
+
+
+/**
+ * tasks run on host stacks, because libc calls in task (printf in log) need much more stack than a mcu task has.
+ * the stack given by tos_task_create only keeps a pointer to the context at its top, so the stack check still
+ * works but shows a few bytes used.
+ *
+ * irq is simulated by signals: tos_irq_diable blocks all irq signals, ISR is the signal handler. the handler
+ * runs on the stack of the interrupted task, so tos_task_switch_intr in tos_exit_isr just swaps the context,
+ * and the rest of the handler runs when the interrupted task is switched back.
+ *
+ * all tasks are in one host thread, a task may be switched out inside a libc call holding a lock. so tasks should
+ * call non reentrant libc functions (stdio, malloc) with irq disabled, or use log and tos_mem instead.
+ */
+
+
+#define TOS_POSIX_HOST_STACK_SIZE (256u * 1024u)                 // host stack of each task
+#define TOS_POSIX_CONTEXT_NUM     (2u * (TOS_MAX_TASK_NUM_USED + 1) + 32u)   // more than tasks, tasks may be recreated,
+                                                                           // dynamic tasks are not in tcb pool
+#define TOS_POSIX_TICK_US         (1000000u / TOS_SYS_HZ)
+
+
+typedef struct {
+    tos_stack_t* user_stack;   // stack ptr given by tos_task_create, nullptr for free context
+    uint8_t*     host_stack;
+    ucontext_t   context;
+} tos_posix_context_t;
+
+
+extern uint32_t    tos_task_prio_current;
+extern uint32_t    tos_task_prio_switch_to;
+extern tos_task_t* tos_task_current;
+extern tos_task_t* tos_task_switch_to;
+
+
+static tos_posix_context_t tos_posix_context_pool[TOS_POSIX_CONTEXT_NUM];
+static sigset_t            tos_posix_irq_set;   // signals used as irq
+static bool                tos_posix_irq_inited = false;
+static void                (*tos_posix_isr_table[NSIG])(void);
+
+
+/**
+ * @brief signals used as irq, SIGALRM for sys tick, others are added by tos_posix_irq_install
+ *
+ */
+static void tos_posix_irq_init(void) {
+    if (!tos_posix_irq_inited) {
+        sigemptyset(&tos_posix_irq_set);
+        sigaddset(&tos_posix_irq_set, SIGALRM);
+        tos_posix_irq_inited = true;
+    }
+}
+
+
+/**
+ * @brief get context of task by the ptr saved in task stack
+ *
+ * @param stack_ptr task_stk_ptr of task
+ * @return tos_posix_context_t*
+ */
+static tos_posix_context_t* tos_posix_context_of(tos_stack_t* stack_ptr) {
+    tos_posix_context_t* ctx;
+
+    memcpy(&ctx, stack_ptr, sizeof(ctx));
+
+    return ctx;
+}
+
+
+/**
+ * @brief get a context for the stack, reuse the context of the same stack or a context not used by any task
+ *
+ * @param user_stack
+ * @return tos_posix_context_t* nullptr when no free context
+ * @note a deleted task may still be running on its context, such as a task deleting itself, so a context is
+ *       free only when no task in task list and no current task use it
+ */
+static tos_posix_context_t* tos_posix_context_get(tos_stack_t* user_stack) {
+    tos_posix_context_t* ctx;
+    tos_queue_node_t*    link;
+    uint32_t             idx;
+
+    for (idx = 0; idx < TOS_POSIX_CONTEXT_NUM; idx++) {
+        if (tos_posix_context_pool[idx].user_stack == user_stack) {
+            return &tos_posix_context_pool[idx];
+        }
+    }
+    for (idx = 0; idx < TOS_POSIX_CONTEXT_NUM; idx++) {
+        if (tos_posix_context_pool[idx].user_stack == nullptr) {
+            return &tos_posix_context_pool[idx];
+        }
+    }
+
+    // reclaim the context of a deleted task
+    for (idx = 0; idx < TOS_POSIX_CONTEXT_NUM; idx++) {
+        ctx = &tos_posix_context_pool[idx];
+
+        if (tos_task_current != nullptr && tos_posix_context_of(tos_task_current->task_stk_ptr) == ctx) {
+            continue;
+        }
+        for (link = tos_state.all_task_list.next; link != &tos_state.all_task_list; link = link->next) {
+            if (tos_posix_context_of(get_task_by_all_free_link(link)->task_stk_ptr) == ctx) {
+                break;
+            }
+        }
+        if (link == &tos_state.all_task_list) {
+            return ctx;
+        }
+    }
+
+    return nullptr;
+}
+
+
+/**
+ * @brief signal handler of all irq signals
+ *
+ * @param signo
+ */
+static void tos_posix_irq_handler(int signo) {
+    tos_posix_isr_table[signo]();
+}
+
+
+/**
+ * @brief cpu SysTick ISR
+ *
+ */
+void tos_systick_isr(void) {
+    tos_enter_isr();   // enter ISR
+    tos_time_tick();
+    tos_exit_isr();   // leave ISR
+}
+
+
+/**
+ * @brief OS Tick init
+ *
+ */
+void tos_sys_clock_init(void) {
+    struct itimerval timer;
+
+    tos_posix_irq_install(SIGALRM, tos_systick_isr);
+
+    timer.it_interval.tv_sec  = 0;
+    timer.it_interval.tv_usec = TOS_POSIX_TICK_US;
+    timer.it_value            = timer.it_interval;
+    setitimer(ITIMER_REAL, &timer, nullptr);
+}
+
+
+/**
+ * @brief install a signal as irq
+ *
+ * @param signo
+ * @param isr
+ * @note the isr should call tos_enter_isr and tos_exit_isr, other irq signals are blocked in isr
+ */
+void tos_posix_irq_install(int signo, void (*isr)(void)) {
+    struct sigaction act;
+    uint32_t         primask = tos_irq_diable();
+
+    sigaddset(&tos_posix_irq_set, signo);
+    tos_posix_isr_table[signo] = isr;
+
+    memset(&act, 0, sizeof(act));
+    act.sa_handler = tos_posix_irq_handler;
+    act.sa_mask    = tos_posix_irq_set;
+    act.sa_flags   = SA_RESTART;
+    sigaction(signo, &act, nullptr);
+
+    tos_irq_restore(primask);
+}
+
+
+/**
+ * @brief start the free running cpu cycle counter
+ *
+ * @note monotonic clock scaled to MCU_SYS_CLOCK
+ */
+void tos_cpu_cycle_init(void) {
+}
+
+
+/**
+ * @brief read the cpu cycle counter
+ *
+ * @return uint32_t
+ */
+uint32_t tos_cpu_cycle_get(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)((uint64_t)ts.tv_sec * MCU_SYS_CLOCK + (uint64_t)ts.tv_nsec * MCU_SYS_CLOCK / 1000000000u);
+}
+
+
+/**
+ * @brief entry of all tasks, delete the task when proc returns
+ *
+ * @param proc
+ * @param args
+ */
+static void tos_posix_task_entry(tos_task_proc_t proc, void* args) {
+    proc(args);
+
+    tos_task_exit();
+}
+
+
+/**
+ * @brief task stack frame init
+ *
+ * @param proc task proc
+ * @param args task arg
+ * @param stack_ptr task stack ptr
+ * @return tos_stack_t* ptr to current stack
+ * @note the stack space and size must be valid
+ */
+tos_stack_t* tos_task_stack_frame_init(tos_task_proc_t proc, void* args, tos_stack_t* stack_ptr) {
+    tos_posix_context_t* ctx;
+    uint32_t             primask = tos_irq_diable();
+
+    ctx = tos_posix_context_get(stack_ptr);
+    if (ctx == nullptr) {
+        tos_irq_restore(primask);
+        fprintf(stderr, "tos posix: no free context\n");
+        abort();
+    }
+    ctx->user_stack = stack_ptr;
+
+    // malloc is not reentrant, a task switched in a signal handler may call it too
+    if (ctx->host_stack == nullptr) {
+        ctx->host_stack = malloc(TOS_POSIX_HOST_STACK_SIZE);
+        if (ctx->host_stack == nullptr) {
+            tos_irq_restore(primask);
+            fprintf(stderr, "tos posix: no memory for stack\n");
+            abort();
+        }
+    }
+
+    tos_irq_restore(primask);
+
+    getcontext(&ctx->context);
+    ctx->context.uc_stack.ss_sp   = ctx->host_stack;
+    ctx->context.uc_stack.ss_size = TOS_POSIX_HOST_STACK_SIZE;
+    ctx->context.uc_link          = nullptr;
+    sigemptyset(&ctx->context.uc_sigmask);   // irq enabled when task starts
+    makecontext(&ctx->context, (void (*)(void))tos_posix_task_entry, 2, proc, args);
+
+    // keep ptr of context in the top of task stack
+    stack_ptr -= (sizeof(ctx) + sizeof(tos_stack_t) - 1) / sizeof(tos_stack_t) - 1;
+    memcpy(stack_ptr, &ctx, sizeof(ctx));
+
+    return stack_ptr;
+}
+
+
+/**
+ * @brief switch to tos_task_switch_to, store cpu info of tos_task_current
+ *
+ * @note called with irq disabled. the irq mask is saved and restored with the context
+ */
+void tos_task_switch(void) {
+    tos_task_t* task_from = tos_task_current;
+
+    tos_task_switch_hook();
+    tos_task_prio_current = tos_task_prio_switch_to;
+    tos_task_current      = tos_task_switch_to;
+
+    if (task_from != tos_task_current) {
+        swapcontext(&tos_posix_context_of(task_from->task_stk_ptr)->context,
+                    &tos_posix_context_of(tos_task_current->task_stk_ptr)->context);
+    }
+}
+
+
+/**
+ * @brief task switch when exit ISR
+ *
+ * @note in signal handler, switch directly, the handler returns when the task is switched back
+ */
+void tos_task_switch_intr(void) {
+    tos_task_switch();
+}
+
+
+/**
+ * @brief start first task of TOS, do not store cpu info
+ *
+ */
+void tos_task_switch_first(void) {
+    tos_task_switch_hook();
+    tos_task_prio_current = tos_task_prio_switch_to;
+    tos_task_current      = tos_task_switch_to;
+
+    setcontext(&tos_posix_context_of(tos_task_current->task_stk_ptr)->context);
+}
+
+
+/**
+ * @brief disable CPU IRQ, return PRIMASK
+ *
+ * @return uint32_t 1 if irq is disabled before
+ */
+uint32_t tos_irq_diable(void) {
+    sigset_t old_set;
+
+    tos_posix_irq_init();
+    sigprocmask(SIG_BLOCK, &tos_posix_irq_set, &old_set);
+
+    return sigismember(&old_set, SIGALRM) ? 1u : 0u;
+}
+
+
+/**
+ * @brief enable CPU IRQ
+ *
+ */
+void tos_irq_enable(void) {
+    tos_posix_irq_init();
+    sigprocmask(SIG_UNBLOCK, &tos_posix_irq_set, nullptr);
+}
+
+
+/**
+ * @brief restore CPU IRQ, restore PRIMASK
+ *
+ * @param primask
+ */
+void tos_irq_restore(uint32_t primask) {
+    if (primask == 0) {
+        tos_irq_enable();
+    }
+}
+
+
+/**
+ * @brief no irq prio on host, mask all irq
+ *
+ * @param prio no use
+ * @return uint32_t
+ */
+uint32_t tos_irq_mask(uint32_t prio) {
+    return tos_irq_diable();
+}
+
+
+/**
+ * @brief
+ *
+ * @param mask
+ */
+void tos_irq_unmask(uint32_t mask) {
+    tos_irq_restore(mask);
+}
+
+
+/**
+ * @brief all irq signals are masked by critical section
+ *
+ * @return true
+ */
+bool tos_cpu_isr_managed(void) {
+    return true;
+}
+
+
+/**
+ * @brief count leading zeros
+ *
+ * @param val
+ * @return uint32_t
+ */
+uint32_t tos_cpu_clz(uint32_t val) {
+    return (val == 0) ? 32 : (uint32_t)__builtin_clz(val);
+}
+
+
+/**
+ * @brief atomic compare and swap
+ *
+ * @param ptr
+ * @param expected
+ * @param desired
+ * @return true swapped
+ * @return false *ptr is not expected
+ * @note safe against signal handlers without blocking them
+ */
+bool tos_cpu_cas(volatile uint32_t* ptr, uint32_t expected, uint32_t desired) {
+    return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+
+#if TOS_TICKLESS_ENABLE
+/**
+ * @brief stop the periodic tick, sleep until an irq comes or the ticks passed
+ *
+ * @param ticks ticks to sleep, the port may sleep less when the timer can not reach it
+ * @return uint32_t complete ticks passed in sleep, not counted by the tick ISR
+ * @note called with irq disabled, and irq is still disabled when return
+ */
+uint32_t tos_cpu_tickless_sleep(uint32_t ticks) {
+    struct itimerval timer;
+    struct timespec  start, now;
+    uint64_t         first_us, passed_us;
+    sigset_t         pending;
+    int              signo;
+
+    if (ticks > 3600u * TOS_SYS_HZ) {
+        ticks = 3600u * TOS_SYS_HZ;
+    }
+
+    // a tick is pending, go on with the periodic tick. sigwait would take it as the end of the sleep
+    sigpending(&pending);
+    if (sigismember(&pending, SIGALRM)) {
+        return 0;
+    }
+
+    // one shot timer to the end of the ticks-th tick, then the periodic tick goes on
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    getitimer(ITIMER_REAL, &timer);
+    first_us                  = (uint64_t)timer.it_value.tv_sec * 1000000u + timer.it_value.tv_usec;
+    passed_us                 = first_us + (uint64_t)(ticks - 1) * TOS_POSIX_TICK_US;
+    timer.it_value.tv_sec     = passed_us / 1000000u;
+    timer.it_value.tv_usec    = passed_us % 1000000u;
+    timer.it_interval.tv_sec  = 0;
+    timer.it_interval.tv_usec = TOS_POSIX_TICK_US;
+    setitimer(ITIMER_REAL, &timer, nullptr);
+
+    // the tick came between getitimer and setitimer, restore the periodic tick and let the ISR count it
+    sigpending(&pending);
+    if (sigismember(&pending, SIGALRM)) {
+        timer.it_value = timer.it_interval;
+        setitimer(ITIMER_REAL, &timer, nullptr);
+        return 0;
+    }
+
+    // wait with irq disabled, like WFI. other irq is raised again to run its handler when irq enabled
+    if (sigwait(&tos_posix_irq_set, &signo) == 0 && signo == SIGALRM) {
+        return ticks;
+    }
+    raise(signo);
+
+    // woken by other irq, count the passed ticks and restart the periodic tick at the next tick boundary
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    passed_us = (uint64_t)(now.tv_sec - start.tv_sec) * 1000000u + now.tv_nsec / 1000 - start.tv_nsec / 1000;
+    if (passed_us < first_us) {
+        ticks                  = 0;
+        timer.it_value.tv_usec = first_us - passed_us;
+    } else {
+        ticks                  = 1 + (passed_us - first_us) / TOS_POSIX_TICK_US;
+        timer.it_value.tv_usec = TOS_POSIX_TICK_US - (passed_us - first_us) % TOS_POSIX_TICK_US;
+    }
+    timer.it_value.tv_sec = 0;
+    setitimer(ITIMER_REAL, &timer, nullptr);
+
+    return ticks;
+}
+#endif
@@ -0,0 +1,23 @@
+/**
+ * @file tos_cpu_posix.h
+ * @brief functions only in linux host simulation port
+ *
+ */
+
+#ifndef _TOS_CPU_POSIX_H_
+#define _TOS_CPU_POSIX_H_
+
+#include "tos_types.h"
+
+
+/**
+ * @brief install a signal as irq
+ *
+ * @param signo
+ * @param isr
+ * @note the isr should call tos_enter_isr and tos_exit_isr, other irq signals are blocked in isr
+ */
+void tos_posix_irq_install(int signo, void (*isr)(void));
+
+
+#endif
@@ -1,75 +1,240 @@
-/**
- * @file tos_cpu_c.c
- * @brief cpu dependency functions in C
- * @version 0.1
- * @note task switch, sys tick init, sys irq control
- */
-
-#include "tos_config.h"
-#include "tos_core.h"
-#include "tos_core_.h"
-#include "tos_cpu.h"
-
-
-/**
- * @brief OS Tick init
- *
- */
-void tos_sys_clock_init(void) {
-    uint32_t counts = MCU_SYS_CLOCK / TOS_SYS_HZ;
-
-    *(volatile unsigned int*)0xE000E018  = 0;        // SysTick->VAL
-    *(volatile unsigned int*)0xE000E014  = counts;   // SysTick->LOAD
-    *(volatile unsigned char*)0xE000ED23 = 0xFF;     // SysTick Prio, lowest
-
-    // SysTick->CTRL
-    *(volatile unsigned int*)0xE000E010 |= (1u << 2) | 1u;   // AHB clk, enable systick counter
-    *(volatile unsigned int*)0xE000E010 |= (1u << 1);        // enable systick irq
-}
-
-
-/**
- * @brief task stack frame init
- *
- * @param proc task proc
- * @param args task arg
- * @param stack_ptr task stack ptr
- * @return tos_stack_t* ptr to current stack
- * @note the stack space and size must be valid
- */
-tos_stack_t* tos_task_stack_frame_init(tos_task_proc_t proc, void* args, tos_stack_t* stack_ptr) {
-    uint32_t* reg_tmp = (uint32_t*)stack_ptr;
-
-    // the reg info restored by cpu when exception occer
-    *(reg_tmp)   = (uint32_t)0x01000000;   // xPSR
-    *(--reg_tmp) = (uint32_t)proc;         // return addr
-    *(--reg_tmp) = (uint32_t)0xFFFFFFFF;   // r14 LR: will not use
-    *(--reg_tmp) = (uint32_t)0xCCCCCCCC;   // r12
-    *(--reg_tmp) = (uint32_t)0x33333333;   // r3
-    *(--reg_tmp) = (uint32_t)0x22222222;   // r2
-    *(--reg_tmp) = (uint32_t)0x11111111;   // r1
-    *(--reg_tmp) = (uint32_t)args;         // r0 arg
-
-    // the reg info restored by task switch code
-    *(--reg_tmp) = (uint32_t)0xBBBBBBBB;   // r11
-    *(--reg_tmp) = (uint32_t)0xAAAAAAAA;   // r10
-    *(--reg_tmp) = (uint32_t)0x99999999;   // r9
-    *(--reg_tmp) = (uint32_t)0x88888888;   // r8
-    *(--reg_tmp) = (uint32_t)0x77777777;   // r7
-    *(--reg_tmp) = (uint32_t)0x66666666;   // r6
-    *(--reg_tmp) = (uint32_t)0x55555555;   // r5
-    *(--reg_tmp) = (uint32_t)0x44444444;   // r4
-
-    return (tos_stack_t*)reg_tmp;
-}
-
-
-/**
- * @brief cpu SysTick ISR
- * @note change the default ISR name of stm32
- */
-void tos_systick_isr(void) {
-    tos_enter_isr();   // enter ISR
-    tos_time_tick();
-    tos_exit_isr();   // leave ISR
-}
+/**
+ * @file tos_cpu_c.c
+ * @brief cpu dependency functions in C
+ * @version 0.1
+ * @note task switch, sys tick init, sys irq control
+ */
+
+#include "tos_config.h"
+#include "tos_core.h"
+#include "tos_core_.h"
+#include "tos_cpu.h"
+
+
+#define SYSTICK_CTRL         (*(volatile unsigned int*)0xE000E010)
+#define SYSTICK_LOAD         (*(volatile unsigned int*)0xE000E014)
+#define SYSTICK_VAL          (*(volatile unsigned int*)0xE000E018)
+#define SYSTICK_CTRL_ENABLE  (1u << 0)
+#define SYSTICK_CTRL_COUNTED (1u << 16)   // COUNTFLAG, cleared by read
+#define SYSTICK_LOAD_MAX     0x00FFFFFFu   // 24 bits counter
+#define SCB_ICSR             (*(volatile unsigned int*)0xE000ED04)
+#define SCB_ICSR_PENDSTSET   (1u << 26)    // SysTick irq is pending
+#define SYSTICK_TICK_COUNTS  (MCU_SYS_CLOCK / TOS_SYS_HZ)
+#define DEMCR                (*(volatile unsigned int*)0xE000EDFC)
+#define DEMCR_TRCENA         (1u << 24)    // enable DWT
+#define DWT_CTRL             (*(volatile unsigned int*)0xE0001000)
+#define DWT_CTRL_CYCCNTENA   (1u << 0)
+#define DWT_CYCCNT           (*(volatile unsigned int*)0xE0001004)
+#define SCB_ICSR_VECTACTIVE  0x1FFu        // exception number of current ISR
+#define SCB_SHPR             ((volatile unsigned char*)0xE000ED18)   // prio of system exception 4~15
+#define NVIC_IPR             ((volatile unsigned char*)0xE000E400)   // prio of irq 0~239, exception 16~255
+
+#if TOS_IRQ_MASK_PRIO > 0xFFu || (TOS_IRQ_MASK_PRIO & 0x0Fu) != 0
+#error "TOS_IRQ_MASK_PRIO should be 0 or 0x10~0xF0, stm32f1 has 4 prio bits"
+#endif
+
+
+#if TOS_TICKLESS_ENABLE
+void tos_cpu_wfi(void);   // implement by asm
+#endif
+
+
+static bool tos_cpu_cycle_dwt = false;   // DWT CYCCNT is running
+
+const uint32_t tos_cpu_irq_mask_prio = TOS_IRQ_MASK_PRIO;   // used by PendSV_Handler
+
+
+/**
+ * @brief OS Tick init
+ *
+ */
+void tos_sys_clock_init(void) {
+    uint32_t counts = SYSTICK_TICK_COUNTS;
+
+    *(volatile unsigned int*)0xE000E018  = 0;            // SysTick->VAL
+    *(volatile unsigned int*)0xE000E014  = counts - 1;   // SysTick->LOAD, period is LOAD + 1
+    *(volatile unsigned char*)0xE000ED23 = 0xFF;     // SysTick Prio, lowest
+
+    // SysTick->CTRL
+    *(volatile unsigned int*)0xE000E010 |= (1u << 2) | 1u;   // AHB clk, enable systick counter
+    *(volatile unsigned int*)0xE000E010 |= (1u << 1);        // enable systick irq
+}
+
+
+/**
+ * @brief start the free running cpu cycle counter
+ *
+ * @note DWT CYCCNT, counts at core clock. some cores and emulators (QEMU) have no DWT, CYCCNT keeps 0,
+ *       then SysTick and sys ticks are used
+ */
+void tos_cpu_cycle_init(void) {
+    uint32_t cnt;
+
+    DEMCR |= DEMCR_TRCENA;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+
+    cnt               = DWT_CYCCNT;
+    tos_cpu_cycle_dwt = (DWT_CYCCNT != cnt);   // some cycles passed between the two reads
+}
+
+
+/**
+ * @brief read the cpu cycle counter
+ *
+ * @return uint32_t
+ * @note SysTick counter wraps every tick, count the tick not handled by ISR yet by the pending bit.
+ *       it is not precise when tickless idle changes the SysTick reload
+ */
+uint32_t tos_cpu_cycle_get(void) {
+    uint32_t ticks, val, pend;
+
+    if (tos_cpu_cycle_dwt) {
+        return DWT_CYCCNT;
+    }
+
+    do {
+        ticks = tos_state.sys_ticks;
+        val   = SYSTICK_VAL;
+        pend  = SCB_ICSR & SCB_ICSR_PENDSTSET;
+        if (pend) {
+            val = SYSTICK_VAL;   // wrapped, read again
+        }
+    } while (ticks != tos_state.sys_ticks);   // tick ISR ran between
+    if (pend) {
+        ticks++;
+    }
+
+    return ticks * SYSTICK_TICK_COUNTS + (SYSTICK_TICK_COUNTS - 1 - val);
+}
+
+
+/**
+ * @brief check that current ISR is masked by kernel critical section, so it can call kernel api
+ *
+ * @return true
+ * @return false prio of the ISR is higher than TOS_IRQ_MASK_PRIO
+ * @note NMI and HardFault have fixed negative prio, they should never call kernel api
+ */
+bool tos_cpu_isr_managed(void) {
+    uint32_t exception = SCB_ICSR & SCB_ICSR_VECTACTIVE;
+    uint32_t prio;
+
+    if (exception >= 16) {
+        prio = NVIC_IPR[exception - 16];
+    } else if (exception >= 4) {
+        prio = SCB_SHPR[exception - 4];
+    } else {
+        return exception == 0;   // thread mode, or NMI, HardFault
+    }
+
+    return prio >= TOS_IRQ_MASK_PRIO;
+}
+
+
+/**
+ * @brief task stack frame init
+ *
+ * @param proc task proc
+ * @param args task arg
+ * @param stack_ptr task stack ptr
+ * @return tos_stack_t* ptr to current stack
+ * @note the stack space and size must be valid
+ */
+tos_stack_t* tos_task_stack_frame_init(tos_task_proc_t proc, void* args, tos_stack_t* stack_ptr) {
+    uint32_t* reg_tmp = (uint32_t*)stack_ptr;
+
+    // the reg info restored by cpu when exception occer
+    *(reg_tmp)   = (uint32_t)0x01000000;   // xPSR
+    *(--reg_tmp) = (uint32_t)proc;         // return addr
+    *(--reg_tmp) = (uint32_t)tos_task_exit;   // r14 LR: delete task when proc returns
+    *(--reg_tmp) = (uint32_t)0xCCCCCCCC;   // r12
+    *(--reg_tmp) = (uint32_t)0x33333333;   // r3
+    *(--reg_tmp) = (uint32_t)0x22222222;   // r2
+    *(--reg_tmp) = (uint32_t)0x11111111;   // r1
+    *(--reg_tmp) = (uint32_t)args;         // r0 arg
+
+    // the reg info restored by task switch code
+    *(--reg_tmp) = (uint32_t)0xBBBBBBBB;   // r11
+    *(--reg_tmp) = (uint32_t)0xAAAAAAAA;   // r10
+    *(--reg_tmp) = (uint32_t)0x99999999;   // r9
+    *(--reg_tmp) = (uint32_t)0x88888888;   // r8
+    *(--reg_tmp) = (uint32_t)0x77777777;   // r7
+    *(--reg_tmp) = (uint32_t)0x66666666;   // r6
+    *(--reg_tmp) = (uint32_t)0x55555555;   // r5
+    *(--reg_tmp) = (uint32_t)0x44444444;   // r4
+
+    return (tos_stack_t*)reg_tmp;
+}
+
+
+/**
+ * @brief cpu SysTick ISR
+ * @note change the default ISR name of stm32
+ */
+void tos_systick_isr(void) {
+    tos_enter_isr();   // enter ISR
+    tos_time_tick();
+    tos_exit_isr();   // leave ISR
+}
+
+
+#if TOS_TICKLESS_ENABLE
+/**
+ * @brief stop the periodic tick, sleep until an irq comes or the ticks passed
+ *
+ * @param ticks ticks to sleep, the port may sleep less when the timer can not reach it
+ * @return uint32_t complete ticks passed in sleep, not counted by the tick ISR
+ * @note called with irq disabled, and irq is still disabled when return
+ */
+uint32_t tos_cpu_tickless_sleep(uint32_t ticks) {
+    uint32_t counts = SYSTICK_TICK_COUNTS;
+    uint32_t ctrl;
+    uint32_t reload;
+    uint32_t passed;
+
+    if (ticks > SYSTICK_LOAD_MAX / counts) {
+        ticks = SYSTICK_LOAD_MAX / counts;
+    }
+
+    // stop SysTick, the rest of current tick is kept in the reload value. CTRL is read once, reading it clears
+    // COUNTFLAG, so it only tells wraps in sleep after that (the tick ISR never reads it)
+    ctrl         = SYSTICK_CTRL;
+    SYSTICK_CTRL = ctrl & ~SYSTICK_CTRL_ENABLE;
+    reload       = SYSTICK_VAL + counts * (ticks - 1);
+
+    // a tick is pending or just ends, go on with the periodic tick. LOAD = 0 would stop SysTick
+    if ((SCB_ICSR & SCB_ICSR_PENDSTSET) || reload == 0) {
+        SYSTICK_CTRL = ctrl;
+        return 0;
+    }
+
+    SYSTICK_LOAD = reload;
+    SYSTICK_VAL  = 0;   // clears COUNTFLAG too
+    SYSTICK_CTRL = ctrl | SYSTICK_CTRL_ENABLE;
+
+    tos_cpu_wfi();   // irq is disabled, wake up by pending irq without entering ISR
+
+    ctrl         = SYSTICK_CTRL;
+    SYSTICK_CTRL = ctrl & ~SYSTICK_CTRL_ENABLE;
+
+    if (ctrl & SYSTICK_CTRL_COUNTED) {
+        // the whole time passed, the pending SysTick ISR will count the last tick
+        passed       = reload - SYSTICK_VAL;                                // counts of the new tick passed
+        SYSTICK_LOAD = (passed < counts - 1) ? counts - 1 - passed : 1u;   // rest of the new tick, never 0
+        passed       = ticks - 1;
+    } else {
+        // wake up by other irq, count the complete ticks, align the next tick to the tick boundary
+        reload       = ticks * counts - SYSTICK_VAL;   // counts passed
+        passed       = reload / counts;
+        SYSTICK_LOAD = (passed + 1) * counts - reload;
+    }
+
+    // restart SysTick, restore the periodic reload value after the first period
+    SYSTICK_VAL  = 0;
+    SYSTICK_CTRL = ctrl | SYSTICK_CTRL_ENABLE;
+    SYSTICK_LOAD = counts - 1;
+
+    return passed;
+}
+#endif
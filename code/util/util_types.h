@@ -1,11 +1,11 @@
-#ifndef _UTIL_TYPES_H_
-#define _UTIL_TYPES_H_
-
-#include <stdbool.h>
-#include <stdint.h>
-
-#ifndef nullptr
-#define nullptr ((void*)0)
-#endif
-
-#endif
+#ifndef _UTIL_TYPES_H_
+#define _UTIL_TYPES_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef nullptr
+#define nullptr ((void*)0)
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+#!/usr/bin/env python3
+"""Convert a tos trace capture to Chrome trace event json.
+
+The capture is the raw byte stream of the debug uart, log text between the
+trace packets is skipped. Open the output in chrome://tracing or
+https://ui.perfetto.dev.
+
+    python3 trace2json.py uart.bin -o trace.json
+
+Packet: 0xA5 0x5A type len payload[len] (see code/tos/core/tos_trace.h)
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+RECORD = struct.Struct("<IBBH")   # timestamp, event, task id, arg
+NO_TASK = 0xFF
+ISR_TID = 1000
+
+EVENTS = {
+    0x01: "switch",
+    0x02: "ready",
+    0x03: "sleep",
+    0x04: "wake",
+    0x05: "prio",
+    0x06: "create",
+    0x07: "delete",
+    0x08: "stack_overflow",
+    0x09: "deadline_miss",
+    0x10: "isr_enter",
+    0x11: "isr_exit",
+    0x20: "mutex_lock",
+    0x21: "mutex_pend",
+    0x22: "mutex_unlock",
+    0x23: "mutex_timeout",
+    0x30: "cond_wait",
+    0x31: "cond_signal",
+    0x32: "cond_broadcast",
+    0x33: "cond_timeout",
+    0x40: "timer_expire",
+    0x50: "sem_take",
+    0x51: "sem_pend",
+    0x52: "sem_give",
+    0x53: "sem_timeout",
+    0x60: "event_wait",
+    0x61: "event_pend",
+    0x62: "event_set",
+    0x63: "event_timeout",
+    0x70: "msgq_send",
+    0x71: "msgq_recv",
+    0x72: "msgq_pend",
+    0x73: "msgq_timeout",
+    0xF0: "lost",
+}
+
+
+def parse_packets(data):
+    """yield (type, payload) of all complete packets in data"""
+    pos = 0
+    while True:
+        pos = data.find(SYNC, pos)
+        if pos < 0 or pos + 4 > len(data):
+            return
+        ptype, plen = data[pos + 2], data[pos + 3]
+        end = pos + 4 + plen
+        if end > len(data) or chr(ptype) not in "HNR":
+            pos += 1
+            continue
+        yield chr(ptype), data[pos + 4:end]
+        pos = end
+
+
+def convert(data):
+    hz = 72000000
+    names = {}
+    records = []
+    for ptype, payload in parse_packets(data):
+        if ptype == "H" and len(payload) >= 8:
+            hz, size, _version = struct.unpack_from("<IHH", payload)
+            if size != RECORD.size:
+                sys.exit("unsupported record size %d" % size)
+        elif ptype == "N" and len(payload) >= 1:
+            names[payload[0]] = payload[1:].decode("ascii", "replace")
+        elif ptype == "R" and len(payload) % RECORD.size == 0:
+            records.extend(RECORD.iter_unpack(payload))
+
+    events = []
+    last_raw = None
+    base = 0
+
+    def us(raw):
+        # unwrap the 32 bits cycle counter, records come at least once per tick
+        nonlocal last_raw, base
+        if last_raw is not None and raw < last_raw:
+            base += 1 << 32
+        last_raw = raw
+        return (base + raw) * 1e6 / hz
+
+    running = None   # (task id, start us)
+    isr_depth = 0
+    for raw, event, task, arg in records:
+        ts = us(raw)
+        name = EVENTS.get(event, "event_%02x" % event)
+
+        if event == 0x01:   # switch: close run slice of the old task, open the new one
+            if running is not None:
+                events.append({"name": names.get(running[0], "task %d" % running[0]), "ph": "X", "pid": 0,
+                               "tid": running[0], "ts": running[1], "dur": ts - running[1]})
+            running = (arg, ts)
+        elif event == 0x10:
+            isr_depth += 1
+            events.append({"name": "isr", "ph": "B", "pid": 0, "tid": ISR_TID, "ts": ts, "args": {"level": arg}})
+        elif event == 0x11:
+            if isr_depth > 0:
+                isr_depth -= 1
+                events.append({"name": "isr", "ph": "E", "pid": 0, "tid": ISR_TID, "ts": ts})
+        else:
+            tid = task if task != NO_TASK else ISR_TID
+            events.append({"name": name, "ph": "i", "s": "t", "pid": 0, "tid": tid, "ts": ts, "args": {"arg": arg}})
+            if event == 0xF0:
+                running = None   # records lost, run slice is unknown
+
+    for tid, tname in names.items():
+        events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": tid, "args": {"name": tname}})
+    events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": ISR_TID, "args": {"name": "ISR"}})
+    events.append({"name": "process_name", "ph": "M", "pid": 0, "args": {"name": "tos"}})
+
+    return {"traceEvents": events, "displayTimeUnit": "ns"}, len(records)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("capture", help="raw uart capture file")
+    parser.add_argument("-o", "--output", default="trace.json", help="output json file")
+    args = parser.parse_args()
+
+    with open(args.capture, "rb") as f:
+        trace, num = convert(f.read())
+    with open(args.output, "w") as f:
+        json.dump(trace, f)
+    print("%d records -> %s" % (num, args.output))
+
+
+if __name__ == "__main__":
+    main()